@@ -18,9 +18,17 @@ import java.io.*;
 import java.net.URL;
 import java.net.URLClassLoader;
 import java.net.MalformedURLException;
+import java.sql.Driver;
+import java.util.HashMap;
  
 public class JDBCDriverLoader extends URLClassLoader
 {
+	/* One loader per jar file, so that drivers from different jars
+	 * and their dependencies cannot see each other. */
+	private static HashMap<String, JDBCDriverLoader> 	loaders = new HashMap<String, JDBCDriverLoader>();
+
+	/* Driver instances, by jar file and driver class name. */
+	private static HashMap<String, Driver> 			drivers = new HashMap<String, Driver>();
 
 /*
  * JDBCDriverLoader
@@ -33,22 +41,33 @@ public class JDBCDriverLoader extends URLClassLoader
 	}
 
 /*
- * addPath
- *		Adds a path to the path of the loader.
+ * GetDriver
+ *		Returns the driver of the given class from the given jar file.
+ *		The jar file is loaded by its own loader and the driver is
+ *		instantiated once; later calls only look them up.
  */
-	public void 
-	addPath(String path) throws MalformedURLException
+	public static synchronized Driver
+	GetDriver(String jarfile, String driver_class_name) throws Exception
 	{
-		addURL(new URL (path));
-	}
+		String 			driver_key = jarfile + "\u0000" + driver_class_name;
+		Driver 			driver = drivers.get(driver_key);
+		JDBCDriverLoader 	loader;
 
-/*
- * CheckIfClassIsLoaded
- *		Checks if a class of given classname has been loaded by the loader or not.
- */
-	public Class
-	CheckIfClassIsLoaded(String ClassName)
-	{
-		return findLoadedClass(ClassName);
+		if (driver != null)
+		{
+			return driver;
+		}
+
+		loader = loaders.get(jarfile);
+		if (loader == null)
+		{
+			loader = new JDBCDriverLoader(new URL[]{new File(jarfile).toURI().toURL()});
+			loaders.put(jarfile, loader);
+		}
+
+		driver = (Driver) loader.loadClass(driver_class_name).newInstance();
+		drivers.put(driver_key, driver);
+
+		return driver;
 	}
 }
@@ -0,0 +1,340 @@
+/*-------------------------------------------------------------------------
+ *
+ *		  foreign-data wrapper for JDBC
+ *
+ * Copyright (c) 2012, PostgreSQL Global Development Group
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * Author: Atri Sharma <atri.jiit@gmail.com>
+ *
+ * IDENTIFICATION
+ *		  jdbc_fdw/JDBCFilter.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.math.BigDecimal;
+import java.util.*;
+import java.util.regex.Pattern;
+
+public class JDBCFilter
+{
+	private ArrayList<Predicate> 	predicates = new ArrayList<Predicate>();
+
+/*
+ * Predicate
+ *		One qual: a column compared with one or more constants.  A
+ *		predicate whose constants cannot be interpreted passes every
+ *		row, as the qual is checked again by PostgreSQL.
+ */
+	private static class Predicate
+	{
+		String 			op;
+		int 			column;
+		boolean 		numeric;
+		String[] 		values;
+		BigDecimal[] 		numbers;
+		HashSet<String> 	value_set;
+		Pattern 		pattern;
+		boolean 		always_true;
+	}
+
+/*
+ * Parse
+ *		Builds a filter from the string produced by the C code: quals
+ *		ended by ';', each made of '|'-separated tokens (operator,
+ *		column number, 'n' or 's' and the constants), with '\' escaping
+ *		the delimiters.  Returns null for an empty filter.
+ */
+	public static JDBCFilter
+	Parse(String filter_string)
+	{
+		JDBCFilter 		filter = new JDBCFilter();
+		ArrayList<String> 	tokens = new ArrayList<String>();
+		StringBuilder 		token = new StringBuilder();
+		int 			i = 0;
+		char 			c;
+
+		for (i = 0; i < filter_string.length(); i++)
+		{
+			c = filter_string.charAt(i);
+
+			if (c == '\\' && i + 1 < filter_string.length())
+			{
+				token.append(filter_string.charAt(++i));
+			}
+			else if (c == '|' || c == ';')
+			{
+				tokens.add(token.toString());
+				token.setLength(0);
+
+				if (c == ';')
+				{
+					filter.predicates.add(MakePredicate(tokens));
+					tokens.clear();
+				}
+			}
+			else
+			{
+				token.append(c);
+			}
+		}
+
+		if (filter.predicates.isEmpty())
+		{
+			return null;
+		}
+
+		return filter;
+	}
+
+/*
+ * MakePredicate
+ *		Builds a predicate from its tokens, preparing the constants for
+ *		evaluation.
+ */
+	private static Predicate
+	MakePredicate(ArrayList<String> tokens)
+	{
+		Predicate 	predicate = new Predicate();
+		int 		i = 0;
+
+		predicate.op = tokens.get(0);
+		predicate.column = Integer.parseInt(tokens.get(1));
+		predicate.numeric = tokens.get(2).equals("n");
+		predicate.values = tokens.subList(3, tokens.size()).toArray(new String[0]);
+
+		try
+		{
+			if (predicate.numeric)
+			{
+				predicate.numbers = new BigDecimal[predicate.values.length];
+				for (i = 0; i < predicate.values.length; i++)
+				{
+					predicate.numbers[i] = new BigDecimal(predicate.values[i]);
+				}
+			}
+			else if (predicate.op.equals("in"))
+			{
+				predicate.value_set = new HashSet<String>(Arrays.asList(predicate.values));
+			}
+			else if (predicate.op.equals("like") || predicate.op.equals("notlike"))
+			{
+				predicate.pattern = Pattern.compile(LikeToRegex(predicate.values[0]), Pattern.DOTALL);
+			}
+			else if (predicate.op.equals("~") || predicate.op.equals("!~"))
+			{
+				predicate.pattern = Pattern.compile(RegexToJava(predicate.values[0]), Pattern.DOTALL);
+			}
+		}
+		catch (Exception predicate_exception)
+		{
+			predicate.always_true = true;
+		}
+
+		return predicate;
+	}
+
+/*
+ * LikeToRegex
+ *		Translates a LIKE pattern with the default '\' escape into an
+ *		equivalent regular expression.
+ */
+	private static String
+	LikeToRegex(String like)
+	{
+		StringBuilder 	regex = new StringBuilder();
+		int 		i = 0;
+		int 		c;
+
+		while (i < like.length())
+		{
+			c = like.codePointAt(i);
+			i += Character.charCount(c);
+
+			if (c == '\\')
+			{
+				if (i >= like.length())
+				{
+					throw new IllegalArgumentException("LIKE pattern ends with escape character");
+				}
+				c = like.codePointAt(i);
+				i += Character.charCount(c);
+			}
+			else if (c == '%')
+			{
+				regex.append(".*");
+				continue;
+			}
+			else if (c == '_')
+			{
+				regex.append('.');
+				continue;
+			}
+
+			if (c < 128 && !Character.isLetterOrDigit(c))
+			{
+				regex.append('\\');
+			}
+			regex.appendCodePoint(c);
+		}
+
+		return regex.toString();
+	}
+
+/*
+ * RegexToJava
+ *		Adapts a POSIX regular expression that the C code found portable
+ *		to java.util.regex: '$' must only match at the very end of the
+ *		value, which Java spells \z.
+ */
+	private static String
+	RegexToJava(String posix)
+	{
+		StringBuilder 	regex = new StringBuilder();
+		boolean 	in_bracket = false;
+		int 		i = 0;
+		char 		c;
+
+		for (i = 0; i < posix.length(); i++)
+		{
+			c = posix.charAt(i);
+
+			if (c == '\\' && i + 1 < posix.length())
+			{
+				regex.append(c).append(posix.charAt(++i));
+				continue;
+			}
+
+			if (c == '[')
+				in_bracket = true;
+			else if (c == ']')
+				in_bracket = false;
+			else if (c == '$' && !in_bracket)
+			{
+				regex.append("\\z");
+				continue;
+			}
+
+			regex.append(c);
+		}
+
+		return regex.toString();
+	}
+
+/*
+ * ReferencedColumns
+ *		Returns the result column numbers the filter reads.
+ */
+	public Set<Integer>
+	ReferencedColumns()
+	{
+		HashSet<Integer> 	columns = new HashSet<Integer>();
+
+		for (Predicate predicate : predicates)
+		{
+			columns.add(predicate.column);
+		}
+
+		return columns;
+	}
+
+/*
+ * Accept
+ *		Returns false if the row, given as the String values of its
+ *		columns, certainly fails one of the quals.
+ */
+	public boolean
+	Accept(String[] row)
+	{
+		for (Predicate predicate : predicates)
+		{
+			if (predicate.always_true || predicate.column > row.length)
+			{
+				continue;
+			}
+
+			if (!Evaluate(predicate, row[predicate.column - 1]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+/*
+ * Evaluate
+ *		Evaluates one predicate on a column value.  All supported
+ *		operators are strict, so a NULL value fails.  A value that
+ *		cannot be interpreted passes.
+ */
+	private static boolean
+	Evaluate(Predicate predicate, String value)
+	{
+		BigDecimal 	number;
+		int 		cmp = 0;
+
+		if (value == null)
+		{
+			return false;
+		}
+
+		if (predicate.numeric)
+		{
+			try
+			{
+				number = new BigDecimal(value.trim());
+			}
+			catch (NumberFormatException number_exception)
+			{
+				return true;
+			}
+
+			if (predicate.op.equals("in"))
+			{
+				for (BigDecimal candidate : predicate.numbers)
+				{
+					if (number.compareTo(candidate) == 0)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			cmp = number.compareTo(predicate.numbers[0]);
+
+			if (predicate.op.equals("="))
+				return cmp == 0;
+			if (predicate.op.equals("<>"))
+				return cmp != 0;
+			if (predicate.op.equals("<"))
+				return cmp < 0;
+			if (predicate.op.equals("<="))
+				return cmp <= 0;
+			if (predicate.op.equals(">"))
+				return cmp > 0;
+			if (predicate.op.equals(">="))
+				return cmp >= 0;
+			return true;
+		}
+
+		if (predicate.op.equals("in"))
+			return predicate.value_set.contains(value);
+		if (predicate.op.equals("="))
+			return value.equals(predicate.values[0]);
+		if (predicate.op.equals("<>"))
+			return !value.equals(predicate.values[0]);
+		if (predicate.op.equals("like"))
+			return predicate.pattern.matcher(value).matches();
+		if (predicate.op.equals("notlike"))
+			return !predicate.pattern.matcher(value).matches();
+		if (predicate.op.equals("~"))
+			return predicate.pattern.matcher(value).find();
+		if (predicate.op.equals("!~"))
+			return !predicate.pattern.matcher(value).find();
+		return true;
+	}
+}
@@ -17,9 +17,15 @@
 import java.sql.*;
 import java.text.*;
 import java.io.*;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.math.BigDecimal;
 import java.net.URL;
 import java.net.URLClassLoader;
 import java.net.MalformedURLException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.Charset;
 import java.util.*;
 public class JDBCUtils
 {
@@ -27,75 +33,303 @@ public class JDBCUtils
 	private Connection 		conn;
 	private int 			NumberOfColumns;
 	private int 			NumberOfRows;
-	private Statement 		sql;
+	private PreparedStatement 	sql;
 	private String[] 		Iterate;
 	private String			iterate_error_message;
-	private static JDBCDriverLoader JDBC_Driver_Loader;
 	private StringWriter 		exception_stack_trace_string_writer;
 	private PrintWriter 		exception_stack_trace_print_writer;
+	private int 			fetch_size;
+	private String 			server_encoding;
+	private Charset 		server_charset;
+	private ByteBuffer 		batch_buffer;
+	private boolean[] 		dictionary_active;
+	private HashMap<String, Integer>[] 	dictionary_codes;
+	private ArrayList<String>[] 	dictionary_values;
+	private int[] 			dictionary_sent;
+	private boolean[] 		column_needed;
+	private JDBCFilter 		filter;
+	private String 			connection_key;
+	private boolean 		result_set_exhausted;
+	private String 			query;
+	private String 			retrieved_columns;
+	private int 			number_of_params;
+	private String 			streaming_profile;
+	private int 			maxrows;
+	private String[] 		param_types;
+	private String[] 		param_values;
+
+	/* Keyset pagination: the query is read in pages of page_size rows
+	 * ordered by page_key, each page after the first resuming after
+	 * the last key seen. */
+	private int 			page_size;
+	private String 			page_key;
+	private PreparedStatement 	first_page_statement;
+	private PreparedStatement 	next_page_statement;
+	private int 			page_key_column;
+	private Object 			page_last_key;
+	private int 			page_rows;
+	private int 			page_limit;
+	private long 			rows_read;
+
+	/* Modifications: rows are bound to sql and sent in JDBC batches
+	 * when the driver supports them, and one by one otherwise. */
+	private boolean 		modify_statement;
+	private boolean 		supports_batch;
+	private int 			update_count;
+	private int[] 			batch_counts;
+	private ArrayList<Integer> 	unbatched_counts = new ArrayList<Integer>();
+	private int 			query_timeout;
+	private String 			driver_class_name;
+	private String 			connection_url;
+	private String 			connection_jarfile;
+	private String 			connection_user;
+	private String 			connection_password;
+
+	/* Bulk load: the rows of a COPY are written as CSV through the
+	 * bulk interface of the driver, found by reflection, instead of
+	 * JDBC batches.  bulk_mode is "postgresql" for PgJDBC's CopyIn,
+	 * "mysql" for LOAD DATA LOCAL INFILE from a stream, or null. */
+	private String 			bulk_mode;
+	private ByteArrayOutputStream 	bulk_buffer;
+	private int 			bulk_rows;
+	private Object 			copy_in;
+	private Method 			copy_write;
+	private Method 			copy_end;
+	private Method 			copy_cancel;
+	private Statement 		bulk_statement;
+	private Object 			bulk_target;
+	private Method 			bulk_set_stream;
+	private String 			bulk_sql;
+	private static final String[] 	MYSQL_STATEMENT_CLASSES = { "com.mysql.cj.jdbc.JdbcStatement", "com.mysql.jdbc.Statement", "org.mariadb.jdbc.MariaDbStatement" };
+	private static final Charset 	BULK_CHARSET = Charset.forName("UTF-8");
+
+	/* Remote transactions: unless isolation_level is "autocommit", the
+	 * connection is used in the remote transaction of the local one,
+	 * from local subtransaction level transaction_level. */
+	private String 			isolation_level;
+	private int 			transaction_level;
+	private boolean 		in_transaction;
+
+	/* The connections in the remote transactions of the current local
+	 * transaction, and the reason why they must not commit, if any. */
+	private static ArrayList<RemoteTransaction> 	remote_transactions = new ArrayList<RemoteTransaction>();
+	private static String 		remote_transaction_error;
+
+/*
+ * RemoteTransaction
+ *		A connection in the remote transaction of the local one.
+ *		savepoints holds a savepoint for each open local subtransaction
+ *		the connection was used in, from level 2 on, or null if the
+ *		driver has no savepoints.
+ */
+	private static class RemoteTransaction
+	{
+		String 			key;
+		Connection 		conn;
+		boolean 		busy;
+		boolean 		savepoints_supported;
+		ArrayList<Savepoint> 	savepoints = new ArrayList<Savepoint>();
+	}
+
+	/* Open connections that no scan is using, by connection_key. */
+	private static HashMap<String, LinkedList<Connection>> 	idle_connections = new HashMap<String, LinkedList<Connection>>();
+	private static final int 	MAX_IDLE_CONNECTIONS = 4;
+
+	/* Statements prepared on each open connection, by query text, in
+	 * least recently used order. */
+	private static IdentityHashMap<Connection, LinkedHashMap<String, PreparedStatement>> 	statement_caches = new IdentityHashMap<Connection, LinkedHashMap<String, PreparedStatement>>();
+	private static final int 	MAX_CACHED_STATEMENTS = 32;
+
+	/* How long a scan that stopped early may take to cancel its
+	 * statement before its connection is discarded. */
+	private static final long 	CANCEL_WAIT_MILLIS = 5000;
+
+	/* A batch is closed once it holds this many bytes, unless it is
+	 * still empty; a single larger row grows the buffer instead. */
+	private static final int 	BATCH_BUFFER_SIZE = 1024 * 1024;
+
+	/* String columns are sent as dictionary codes until they have this
+	 * many distinct values. */
+	private static final int 	DICTIONARY_MAX_ENTRIES = 1024;
+
+	/* A page that fails is tried this many times in all, waiting
+	 * PAGE_RETRY_MILLIS times the attempt number in between, and
+	 * looking for a query cancel every PAGE_RETRY_SLICE_MILLIS. */
+	private static final int 	PAGE_ATTEMPTS = 3;
+	private static final long 	PAGE_RETRY_MILLIS = 1000;
+	private static final long 	PAGE_RETRY_SLICE_MILLIS = 50;
+
+	/* The backend's flag for a pending query cancel, set by
+	 * SetInterruptFlag, so that waits in Java do not hold it up. */
+	private static ByteBuffer 	interrupt_flag;
+
+	/* The reserved words of SQL-92, which imported identifiers are
+	 * quoted for, with those DatabaseMetaData.getSQLKeywords adds. */
+	private static final String[] 	SQL_RESERVED_WORDS = {
+		"ABSOLUTE", "ACTION", "ADD", "ALL", "ALLOCATE", "ALTER", "AND", "ANY", "ARE", "AS",
+		"ASC", "ASSERTION", "AT", "AUTHORIZATION", "AVG", "BEGIN", "BETWEEN", "BIT",
+		"BIT_LENGTH", "BOTH", "BY", "CASCADE", "CASCADED", "CASE", "CAST", "CATALOG", "CHAR",
+		"CHARACTER", "CHAR_LENGTH", "CHARACTER_LENGTH", "CHECK", "CLOSE", "COALESCE",
+		"COLLATE", "COLLATION", "COLUMN", "COMMIT", "CONNECT", "CONNECTION", "CONSTRAINT",
+		"CONSTRAINTS", "CONTINUE", "CONVERT", "CORRESPONDING", "COUNT", "CREATE", "CROSS",
+		"CURRENT", "CURRENT_DATE", "CURRENT_TIME", "CURRENT_TIMESTAMP", "CURRENT_USER",
+		"CURSOR", "DATE", "DAY", "DEALLOCATE", "DEC", "DECIMAL", "DECLARE", "DEFAULT",
+		"DEFERRABLE", "DEFERRED", "DELETE", "DESC", "DESCRIBE", "DESCRIPTOR", "DIAGNOSTICS",
+		"DISCONNECT", "DISTINCT", "DOMAIN", "DOUBLE", "DROP", "ELSE", "END", "END-EXEC",
+		"ESCAPE", "EXCEPT", "EXCEPTION", "EXEC", "EXECUTE", "EXISTS", "EXTERNAL", "EXTRACT",
+		"FALSE", "FETCH", "FIRST", "FLOAT", "FOR", "FOREIGN", "FOUND", "FROM", "FULL", "GET",
+		"GLOBAL", "GO", "GOTO", "GRANT", "GROUP", "HAVING", "HOUR", "IDENTITY", "IMMEDIATE",
+		"IN", "INDICATOR", "INITIALLY", "INNER", "INPUT", "INSENSITIVE", "INSERT", "INT",
+		"INTEGER", "INTERSECT", "INTERVAL", "INTO", "IS", "ISOLATION", "JOIN", "KEY",
+		"LANGUAGE", "LAST", "LEADING", "LEFT", "LEVEL", "LIKE", "LOCAL", "LOWER", "MATCH",
+		"MAX", "MIN", "MINUTE", "MODULE", "MONTH", "NAMES", "NATIONAL", "NATURAL", "NCHAR",
+		"NEXT", "NO", "NOT", "NULL", "NULLIF", "NUMERIC", "OCTET_LENGTH", "OF", "ON", "ONLY",
+		"OPEN", "OPTION", "OR", "ORDER", "OUTER", "OUTPUT", "OVERLAPS", "PAD", "PARTIAL",
+		"POSITION", "PRECISION", "PREPARE", "PRESERVE", "PRIMARY", "PRIOR", "PRIVILEGES",
+		"PROCEDURE", "PUBLIC", "READ", "REAL", "REFERENCES", "RELATIVE", "RESTRICT",
+		"REVOKE", "RIGHT", "ROLLBACK", "ROWS", "SCHEMA", "SCROLL", "SECOND", "SECTION",
+		"SELECT", "SESSION", "SESSION_USER", "SET", "SIZE", "SMALLINT", "SOME", "SPACE",
+		"SQL", "SQLCODE", "SQLERROR", "SQLSTATE", "SUBSTRING", "SUM", "SYSTEM_USER", "TABLE",
+		"TEMPORARY", "THEN", "TIME", "TIMESTAMP", "TIMEZONE_HOUR", "TIMEZONE_MINUTE", "TO",
+		"TRAILING", "TRANSACTION", "TRANSLATE", "TRANSLATION", "TRIM", "TRUE", "UNION",
+		"UNIQUE", "UNKNOWN", "UPDATE", "UPPER", "USAGE", "USER", "USING", "VALUE", "VALUES",
+		"VARCHAR", "VARYING", "VIEW", "WHEN", "WHENEVER", "WHERE", "WITH", "WORK", "WRITE",
+		"YEAR", "ZONE" };
 
 /*
  * Initialize
  *		Initiates the connection to the foreign database after setting 
- *		up initial configuration and executes the query.
+ *		up initial configuration and prepares the query, which is run
+ *		by Execute.
  */
 	public String
 	Initialize(String[] options_array) throws IOException
 	{       
 		DatabaseMetaData 	db_metadata;
-		ResultSetMetaData 	result_set_metadata;
-		Properties 		JDBCProperties;
-		Class 			JDBCDriverClass = null;
-		Driver 			JDBCDriver = null;
-		String 			query = options_array[0];
 		String 			DriverClassName = options_array[1];
 		String 			url = options_array[2];
   		String 			userName = options_array[3];
   		String 			password = options_array[4];
 		int 			querytimeoutvalue = Integer.parseInt(options_array[5]);
 
+		query = options_array[0];
+		query_timeout = querytimeoutvalue;
+		driver_class_name = DriverClassName;
+		connection_url = url;
+		connection_jarfile = options_array[6];
+		connection_user = userName;
+		connection_password = password;
+		retrieved_columns = options_array[9];
+		number_of_params = Integer.parseInt(options_array[12]);
+		fetch_size = Integer.parseInt(options_array[7]);
+		server_encoding = options_array[8];
+		server_charset = ServerEncodingToCharset(server_encoding);
+		streaming_profile = ResolveStreamingProfile(options_array[13], DriverClassName);
+		maxrows = Integer.parseInt(options_array[11]);
+		page_size = Integer.parseInt(options_array[14]);
+		page_key = options_array[15];
+		isolation_level = options_array[16];
+		transaction_level = Integer.parseInt(options_array[17]);
+		in_transaction = false;
+		if (page_key.length() == 0 || modify_statement)
+		{
+			page_size = 0;
+		}
+
 		exception_stack_trace_string_writer = new StringWriter();
  		exception_stack_trace_print_writer = new PrintWriter(exception_stack_trace_string_writer);
 
   		NumberOfColumns = 0;
   		conn = null;
+		Iterate = null;
+
+		/* Nothing is pending on the statement until it is executed. */
+		result_set_exhausted = true;
+		connection_key = DriverClassName + "\u0000" + url + "\u0000" + userName + "\u0000" + password + "\u0000" + streaming_profile;
 
   		try 
 		{
-			File 	JarFile = new File(options_array[6]);
-			String 	jarfile_path = JarFile.toURI().toURL().toString();
-
-			if (JDBC_Driver_Loader == null)
+			/* Reuse a connection already in the remote transaction,
+			 * or else one left by an earlier scan, if possible. */
+			if (!isolation_level.equals("autocommit"))
 			{
-				/* If JDBC_Driver_Loader is being 									
-				 * created. */
-				JDBC_Driver_Loader = new JDBCDriverLoader(new URL[]{JarFile.toURI().toURL()}); 
+				conn = TakeTransactionConnection(connection_key, transaction_level);
+				in_transaction = (conn != null);
 			}
-			else if (JDBC_Driver_Loader.CheckIfClassIsLoaded(DriverClassName) == null)
-			{
-				JDBC_Driver_Loader.addPath(jarfile_path);
-			}	
-
-			JDBCDriverClass = JDBC_Driver_Loader.loadClass(DriverClassName);
-
-			JDBCDriver = (Driver)JDBCDriverClass.newInstance();
-			JDBCProperties = new Properties();
 
-			JDBCProperties.put("user", userName);
-			JDBCProperties.put("password", password);
+			if (conn == null)
+			{
+				conn = TakeIdleConnection(connection_key);
+			}
 
-			conn = JDBCDriver.connect(url, JDBCProperties);
+			if (conn == null)
+			{
+				conn = Connect();
+			}
   		
   			db_metadata = conn.getMetaData();
 
-  			sql = conn.createStatement(ResultSet.TYPE_FORWARD_ONLY, ResultSet.CONCUR_READ_ONLY);
+			if (!in_transaction && !isolation_level.equals("autocommit"))
+			{
+				in_transaction = BeginTransaction(connection_key, conn, db_metadata, isolation_level, transaction_level);
+			}
+
+			/* A command such as TRUNCATE, built here for the
+			 * remote dialect, prepares no statement. */
+			if (modify_statement && query.length() == 0)
+			{
+				if (!in_transaction)
+				{
+					conn.setAutoCommit(true);
+				}
+				return null;
+			}
+
+			/* Values are always bound to "?" placeholders, so a
+			 * statement prepared by an earlier scan of the same
+			 * query on this connection can be used again. */
+			if (page_size > 0)
+			{
+				first_page_statement = PrepareCachedStatement(conn, "SELECT * FROM (" + query + ") jdbc_fdw_page ORDER BY " + page_key);
+				next_page_statement = PrepareCachedStatement(conn, "SELECT * FROM (" + query + ") jdbc_fdw_page WHERE " + page_key + " > ? ORDER BY " + page_key);
+				sql = first_page_statement;
+			}
+			else
+			{
+				sql = PrepareCachedStatement(conn, query);
+			}
 			try
 			{
-				if (querytimeoutvalue != 0)
+				/* The statement may come from a scan with other
+				 * settings, so both are always set.  The scan
+				 * will stop after maxrows rows, so the remote
+				 * need not produce any more. */
+				sql.setQueryTimeout(querytimeoutvalue);
+				if (modify_statement)
 				{
-					sql.setQueryTimeout(querytimeoutvalue);
+					/* Outside a remote transaction, each batch is
+					 * committed as it is sent.  A cached statement
+					 * may still hold the rows of a modification
+					 * that failed. */
+					if (!in_transaction)
+					{
+						conn.setAutoCommit(true);
+					}
+					supports_batch = db_metadata.supportsBatchUpdates();
+					if (supports_batch)
+					{
+						sql.clearBatch();
+					}
+					return null;
 				}
+				sql.setMaxRows(maxrows);
+				ApplyStreamingProfile(conn, sql);
 
+				if (next_page_statement != null)
+				{
+					next_page_statement.setQueryTimeout(querytimeoutvalue);
+					ApplyStreamingProfile(conn, next_page_statement);
+				}
 			}
 			catch(Exception setquerytimeout_exception)
 			{
@@ -108,11 +342,7 @@ public class JDBCUtils
 				return (new String(exception_stack_trace_string_writer.toString()));
 			}
 
-  			result_set = sql.executeQuery(query);
-
-  			result_set_metadata = result_set.getMetaData();
-  			NumberOfColumns = result_set_metadata.getColumnCount();
-  			Iterate = new String[NumberOfColumns];
+			filter = JDBCFilter.Parse(options_array[10]);
 		}
 		catch (Throwable initialize_exception)
 	  	{
@@ -129,121 +359,2635 @@ public class JDBCUtils
 	}
 
 /*
- * ReturnResultSet
- *		Returns the result set that is returned from the foreign database
- *		after execution of the query to C code.
+ * Connect
+ *		Opens a new connection to the foreign database with the settings
+ *		given to Initialize.
  */
-	public String[] 
-	ReturnResultSet()
+	private Connection
+	Connect() throws Exception
 	{
-		iterate_error_message = null;
-		int 	i = 0;
+		Properties 		JDBCProperties;
+		Driver 			JDBCDriver;
+		ClassLoader 		context_loader;
+
+		JDBCDriver = JDBCDriverLoader.GetDriver(connection_jarfile, driver_class_name);
+		JDBCProperties = new Properties();
 
+		JDBCProperties.put("user", connection_user);
+		JDBCProperties.put("password", connection_password);
+
+		/* SQL Server reads all rows into memory
+		 * unless it is told to use a server cursor. */
+		if (streaming_profile.equals("sqlserver"))
+		{
+			JDBCProperties.put("selectMethod", "cursor");
+			JDBCProperties.put("responseBuffering", "adaptive");
+		}
+
+		/* Drivers that look up their own resources
+		 * expect their loader as the context loader. */
+		context_loader = Thread.currentThread().getContextClassLoader();
+		Thread.currentThread().setContextClassLoader(JDBCDriver.getClass().getClassLoader());
 		try
 		{
-			/* Row-by-row processing is done in jdbc_fdw.One row
-			 * at a time is returned to the C code. */
-			if (result_set.next())
+			return JDBCDriver.connect(connection_url, JDBCProperties);
+		}
+		finally
+		{
+			Thread.currentThread().setContextClassLoader(context_loader);
+		}
+	}
+
+/*
+ * InitializeModify
+ *		Like Initialize, for an INSERT, UPDATE or DELETE statement whose
+ *		rows are sent by AddBatch and ExecuteBatch.
+ */
+	public String
+	InitializeModify(String[] options_array) throws IOException
+	{
+		modify_statement = true;
+
+		return Initialize(options_array);
+	}
+
+/*
+ * AddBatch
+ *		Binds the values of one row to the statement and adds it to the
+ *		current batch.  If the driver has no batch support, the row is
+ *		sent at once.
+ */
+	public String
+	AddBatch(String[] param_types, String[] param_values)
+	{
+		try
+		{
+			if (param_values.length != number_of_params)
 			{
-				for (i = 0; i < NumberOfColumns; i++)
-				{
-    					Iterate[i] = result_set.getString(i+1);
-				}
+				throw new IllegalArgumentException("statement has " + number_of_params + " parameters, " + param_values.length + " values given");
+			}
 
-				++NumberOfRows;				
-				
-				/* The current row in result_set is returned
-				 * to the C code in a Java String array that
-				 * has the value of the fields of the current
-				 * row as it values. */
+			if (bulk_mode != null)
+			{
+				AppendBulkRow(param_types, param_values);
+				return null;
+			}
 
-				return (Iterate);
+			BindParameters(sql, param_types, param_values);
+
+			if (supports_batch)
+			{
+				sql.addBatch();
+			}
+			else
+			{
+				unbatched_counts.add(sql.executeUpdate());
 			}
+		}
+		catch (Throwable addbatch_exception)
+		{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
 
+			addbatch_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
 		}
-		catch (Exception returnresultset_exception)
-	 	{
-			returnresultset_exception.printStackTrace(exception_stack_trace_print_writer);
-			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
-	 	}
 
-		/* All of result_set's rows have been returned to the C code. */
 		return null;
 	}
 
 /*
- * ReturnResultSetErrorMessage
- *		Returns any error resulting from iterating the result set.
- *		Call after ReturnResultSet returns null to determine if an
- *		error occurred or all results have been read.
+ * ExecuteBatch
+ *		Sends the rows added since the last call in one round trip, and
+ *		records the number of rows each of them affected in batch_counts,
+ *		or null when the bulk interface sent them.  A count may be
+ *		Statement.SUCCESS_NO_INFO if the driver does not know it.
  */
 	public String
-	ReturnResultSetErrorMessage()
+	ExecuteBatch()
 	{
-		return iterate_error_message;
+		batch_counts = null;
+
+		try
+		{
+			if (bulk_mode != null)
+			{
+				FlushBulkRows();
+			}
+			else if (supports_batch)
+			{
+				batch_counts = sql.executeBatch();
+			}
+			else
+			{
+				batch_counts = new int[unbatched_counts.size()];
+				for (int i = 0; i < batch_counts.length; i++)
+				{
+					batch_counts[i] = unbatched_counts.get(i);
+				}
+				unbatched_counts.clear();
+			}
+		}
+		catch (Throwable executebatch_exception)
+		{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
+
+			try
+			{
+				if (bulk_mode == null)
+				{
+					sql.clearBatch();
+				}
+			}
+			catch (SQLException clearbatch_exception)
+			{
+			}
+
+			if (executebatch_exception instanceof InvocationTargetException)
+			{
+				executebatch_exception = executebatch_exception.getCause();
+			}
+
+			executebatch_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
+		}
+
+		return null;
 	}
 
 /*
- * Close
- *		Releases the resources used.
+ * BeginBulkLoad
+ *		Sets up loading rows into the given columns of table through the
+ *		bulk interface of the driver: a COPY FROM STDIN in CSV with
+ *		PgJDBC, or LOAD DATA LOCAL INFILE with MySQL drivers when the
+ *		URL sets allowLoadLocalInfile=true.  With other drivers, or if
+ *		the driver lacks the expected classes, rows keep going through
+ *		JDBC batches.
  */
-	public String 
-	Close()
+	public String
+	BeginBulkLoad(String table, String[] columns)
 	{
+		StringBuilder 	column_list = new StringBuilder();
+		String 		mode = ResolveStreamingProfile("auto", driver_class_name);
+		ClassLoader 	driver_loader = conn.getClass().getClassLoader();
+		Class<?> 	pg_connection_class;
+		Class<?> 	copy_manager_class;
+		Class<?> 	copy_in_class;
+		Class<?> 	statement_class;
+		Object 		copy_manager;
+		int 		i = 0;
+
+		for (i = 0; i < columns.length; i++)
+		{
+			column_list.append((i == 0) ? "" : ", ").append(columns[i]);
+		}
 
 		try
 		{
-			if (result_set != null)
+			if (mode.equals("postgresql"))
 			{
-				result_set.close();
+				pg_connection_class = Class.forName("org.postgresql.PGConnection", true, driver_loader);
+				copy_manager_class = Class.forName("org.postgresql.copy.CopyManager", true, driver_loader);
+				copy_in_class = Class.forName("org.postgresql.copy.CopyIn", true, driver_loader);
+
+				copy_write = copy_in_class.getMethod("writeToCopy", byte[].class, int.class, int.class);
+				copy_end = copy_in_class.getMethod("endCopy");
+				copy_cancel = copy_in_class.getMethod("cancelCopy");
+				copy_manager = pg_connection_class.getMethod("getCopyAPI").invoke(conn.unwrap(pg_connection_class));
+				copy_in = copy_manager_class.getMethod("copyIn", String.class).invoke(copy_manager, "COPY " + table + " (" + column_list + ") FROM STDIN CSV");
+			}
+			else if (mode.equals("mysql") && connection_url.contains("allowLoadLocalInfile=true"))
+			{
+				bulk_statement = conn.createStatement();
+				for (String class_name : MYSQL_STATEMENT_CLASSES)
+				{
+					try
+					{
+						statement_class = Class.forName(class_name, true, driver_loader);
+					}
+					catch (ClassNotFoundException class_exception)
+					{
+						continue;
+					}
+
+					if (bulk_statement.isWrapperFor(statement_class))
+					{
+						bulk_set_stream = statement_class.getMethod("setLocalInfileInputStream", InputStream.class);
+						bulk_target = bulk_statement.unwrap(statement_class);
+						break;
+					}
+				}
+
+				if (bulk_set_stream == null)
+				{
+					bulk_statement.close();
+					bulk_statement = null;
+					return null;
+				}
+
+				bulk_statement.setQueryTimeout(query_timeout);
+				bulk_sql = "LOAD DATA LOCAL INFILE 'jdbc_fdw' INTO TABLE " + table + " CHARACTER SET utf8mb4 FIELDS TERMINATED BY ',' OPTIONALLY ENCLOSED BY '\"' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n' (" + column_list + ")";
 			}
-			if (conn != null)
+			else
 			{
-				conn.close();
+				return null;
 			}
-			result_set = null;
-			conn = null;
-			Iterate = null;
 		}
-		catch (Exception close_exception) 
-	 	{
-			/* If an exception occurs,it is returned back to the
-			 * calling C code by returning a Java String object
-			 * that has the exception's stack trace.
-			 * If all goes well,a null String is returned. */
+		catch (InvocationTargetException bulkload_exception)
+		{
+			/* The driver refused the load: the error is returned
+			 * back to the calling C code as a stack trace. */
 
-	 		close_exception.printStackTrace(exception_stack_trace_print_writer);
+			ResetBulkLoad();
+			bulkload_exception.getCause().printStackTrace(exception_stack_trace_print_writer);
 			return (new String(exception_stack_trace_string_writer.toString()));
-	 	}
+		}
+		catch (Throwable bulkload_exception)
+		{
+			/* The driver has no such bulk interface: rows go
+			 * through JDBC batches. */
+
+			ResetBulkLoad();
+			return null;
+		}
+
+		bulk_mode = mode;
+		bulk_buffer = new ByteArrayOutputStream();
+		bulk_rows = 0;
 
 		return null;
 	}
 
 /*
- * Cancel
- *		Cancels the query and releases the resources in case query
- *		cancellation is requested by the user.
+ * AppendBulkRow
+ *		Appends a row to bulk_buffer as a CSV line.  NULL is an unquoted
+ *		empty field for COPY and \N for LOAD DATA; other values are
+ *		quoted.
  */
-	public String 
-	Cancel()
+	private void
+	AppendBulkRow(String[] param_types, String[] param_values) throws IOException
+	{
+		StringBuilder 	line = new StringBuilder();
+		String 		value;
+		int 		i = 0;
+
+		for (i = 0; i < param_values.length; i++)
+		{
+			if (i > 0)
+			{
+				line.append(',');
+			}
+
+			if (param_values[i] == null)
+			{
+				if (bulk_mode.equals("mysql"))
+				{
+					line.append("\\N");
+				}
+				continue;
+			}
+
+			value = BulkValue(param_types[i], param_values[i]);
+			if (bulk_mode.equals("mysql"))
+			{
+				value = value.replace("\\", "\\\\");
+			}
+			line.append('"').append(value.replace("\"", "\"\"")).append('"');
+		}
+		line.append('\n');
+
+		bulk_buffer.write(line.toString().getBytes(BULK_CHARSET));
+		bulk_rows++;
+	}
+
+/*
+ * BulkValue
+ *		Returns the text a bulk load reads for a value in the form the
+ *		C code binds it: timestamps with time zone, given in epoch
+ *		microseconds, are written in UTC for COPY and in the JVM time
+ *		zone for LOAD DATA, as setTimestamp would; booleans are 1 or 0
+ *		for LOAD DATA.
+ */
+	private String
+	BulkValue(String type, String value)
 	{
+		SimpleDateFormat 	utc_format;
+		Timestamp 		timestamp;
 
 		try
 		{
-			result_set.close();
-			conn.close();
+			if (type.equals("timestamptz"))
+			{
+				timestamp = EpochMicrosToTimestamp(Long.parseLong(value));
+				if (bulk_mode.equals("mysql"))
+				{
+					return timestamp.toString();
+				}
+
+				utc_format = new SimpleDateFormat("yyyy-MM-dd HH:mm:ss");
+				utc_format.setTimeZone(TimeZone.getTimeZone("UTC"));
+				return utc_format.format(timestamp) + String.format(".%06d+00", timestamp.getNanos() / 1000);
+			}
+		}
+		catch (NumberFormatException timestamp_exception)
+		{
+			return value;
 		}
-		catch(Exception cancel_exception)
-	 	{
+
+		if (type.equals("bool") && bulk_mode.equals("mysql"))
+		{
+			return value.equals("t") ? "1" : "0";
+		}
+
+		return value;
+	}
+
+/*
+ * FlushBulkRows
+ *		Sends the rows in bulk_buffer: written to the COPY stream, or
+ *		loaded by one LOAD DATA statement.  LOAD DATA LOCAL skips the
+ *		rows it cannot load, such as duplicate keys, and adjusts values
+ *		it cannot store, with a warning only; either is an error here,
+ *		as COPY would raise one.
+ */
+	private void
+	FlushBulkRows() throws Exception
+	{
+		byte[] 		rows;
+		int 		rows_sent = bulk_rows;
+		int 		rows_loaded;
+		SQLWarning 	warning;
+
+		if (bulk_buffer.size() == 0)
+		{
+			return;
+		}
+
+		rows = bulk_buffer.toByteArray();
+		bulk_buffer.reset();
+		bulk_rows = 0;
+
+		if (bulk_mode.equals("postgresql"))
+		{
+			copy_write.invoke(copy_in, rows, 0, rows.length);
+		}
+		else
+		{
+			bulk_statement.clearWarnings();
+			bulk_set_stream.invoke(bulk_target, new ByteArrayInputStream(rows));
+			bulk_statement.execute(bulk_sql);
+
+			rows_loaded = bulk_statement.getUpdateCount();
+			warning = bulk_statement.getWarnings();
+			if (rows_loaded != rows_sent || warning != null)
+			{
+				throw new SQLException("LOAD DATA loaded " + rows_loaded + " of " + rows_sent + " rows" + (warning != null ? ": " + warning.getMessage() : ""), "22000");
+			}
+		}
+	}
+
+/*
+ * EndBulkLoad
+ *		Sends the last rows of a bulk load and ends it.  COPY commits
+ *		all rows at once here.
+ */
+	public String
+	EndBulkLoad()
+	{
+		if (bulk_mode == null)
+		{
+			return null;
+		}
+
+		try
+		{
+			FlushBulkRows();
+
+			if (bulk_mode.equals("postgresql"))
+			{
+				copy_end.invoke(copy_in);
+				copy_in = null;
+			}
+		}
+		catch (Throwable endbulkload_exception)
+		{
 			/* If an exception occurs,it is returned back to the
 			 * calling C code by returning a Java String object
 			 * that has the exception's stack trace.
 			 * If all goes well,a null String is returned. */
 
-			cancel_exception.printStackTrace(exception_stack_trace_print_writer);
+			if (endbulkload_exception instanceof InvocationTargetException)
+			{
+				endbulkload_exception = endbulkload_exception.getCause();
+			}
+
+			ResetBulkLoad();
+			endbulkload_exception.printStackTrace(exception_stack_trace_print_writer);
 			return (new String(exception_stack_trace_string_writer.toString()));
-  	 	}
+		}
+
+		ResetBulkLoad();
 
 		return null;
 	}
+
+/*
+ * ResetBulkLoad
+ *		Leaves bulk load mode, cancelling a COPY still in progress so
+ *		that the connection can be used again.
+ */
+	private void
+	ResetBulkLoad()
+	{
+		try
+		{
+			if (copy_in != null)
+			{
+				copy_cancel.invoke(copy_in);
+			}
+			if (bulk_statement != null)
+			{
+				bulk_statement.close();
+			}
+		}
+		catch (Throwable reset_exception)
+		{
+		}
+
+		bulk_mode = null;
+		bulk_buffer = null;
+		copy_in = null;
+		bulk_statement = null;
+		bulk_target = null;
+		bulk_set_stream = null;
+	}
+
+/*
+ * ExecuteUpdate
+ *		Runs an UPDATE or DELETE statement once with the given parameter
+ *		values and records the number of rows it affected in
+ *		update_count.
+ */
+	public String
+	ExecuteUpdate(String[] param_types, String[] param_values)
+	{
+		try
+		{
+			if (param_values.length != number_of_params)
+			{
+				throw new IllegalArgumentException("statement has " + number_of_params + " parameters, " + param_values.length + " values given");
+			}
+
+			BindParameters(sql, param_types, param_values);
+			update_count = sql.executeUpdate();
+		}
+		catch (Throwable executeupdate_exception)
+		{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
+
+			executeupdate_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
+		}
+
+		return null;
+	}
+
+/*
+ * Truncate
+ *		Empties the given tables, named as in their table options, in
+ *		one remote call: a single TRUNCATE TABLE on PostgreSQL, and a
+ *		batch of one TRUNCATE TABLE per table elsewhere, or of DELETE
+ *		for SQLite, which has no TRUNCATE.  RESTART IDENTITY and
+ *		CASCADE are only sent to PostgreSQL and refused on other
+ *		databases, except that MySQL, MariaDB and SQL Server always
+ *		restart identity on TRUNCATE: there it is used for RESTART
+ *		IDENTITY, and DELETE otherwise.
+ */
+	public String
+	Truncate(String[] tables, boolean restart_identity, boolean cascade)
+	{
+		DatabaseMetaData 	db_metadata;
+		Statement 		statement = null;
+		StringBuilder 		truncate_sql = new StringBuilder();
+		String 			product;
+		boolean 		truncate_restarts;
+		int 			i = 0;
+
+		try
+		{
+			db_metadata = conn.getMetaData();
+			product = db_metadata.getDatabaseProductName().toLowerCase();
+			statement = conn.createStatement();
+			statement.setQueryTimeout(query_timeout);
+
+			if (product.contains("postgresql"))
+			{
+				truncate_sql.append("TRUNCATE TABLE ");
+				for (i = 0; i < tables.length; i++)
+				{
+					truncate_sql.append((i == 0) ? "" : ", ").append(tables[i]);
+				}
+				if (restart_identity)
+					truncate_sql.append(" RESTART IDENTITY");
+				if (cascade)
+					truncate_sql.append(" CASCADE");
+
+				statement.executeUpdate(truncate_sql.toString());
+			}
+			else
+			{
+				if (cascade)
+				{
+					throw new SQLFeatureNotSupportedException("TRUNCATE ... CASCADE is not supported by " + db_metadata.getDatabaseProductName());
+				}
+
+				truncate_restarts = product.contains("mysql") || product.contains("mariadb") || product.contains("microsoft sql server");
+				if (restart_identity && !truncate_restarts)
+				{
+					throw new SQLFeatureNotSupportedException("TRUNCATE ... RESTART IDENTITY is not supported by " + db_metadata.getDatabaseProductName());
+				}
+
+				for (i = 0; i < tables.length; i++)
+				{
+					if (product.contains("sqlite") || (truncate_restarts && !restart_identity))
+						statement.addBatch("DELETE FROM " + tables[i]);
+					else
+						statement.addBatch("TRUNCATE TABLE " + tables[i]);
+				}
+				statement.executeBatch();
+			}
+
+			statement.close();
+		}
+		catch (Throwable truncate_exception)
+		{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
+
+			try
+			{
+				if (statement != null)
+				{
+					statement.close();
+				}
+			}
+			catch (SQLException close_exception)
+			{
+			}
+
+			truncate_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
+		}
+
+		return null;
+	}
+
+/*
+ * PrimaryKeyColumns
+ *		Returns the names of the primary key columns of the given table,
+ *		in key order, as reported by the driver.  The table name may be
+ *		qualified and quoted as in the table option.  Returns null on
+ *		error, which ReturnResultSetErrorMessage then describes.
+ */
+	public String[]
+	PrimaryKeyColumns(String table)
+	{
+		DatabaseMetaData 	db_metadata;
+		String[] 		location;
+
+		iterate_error_message = null;
+
+		try
+		{
+			db_metadata = conn.getMetaData();
+			location = TableLocation(table, db_metadata);
+
+			return PrimaryKey(db_metadata, location);
+		}
+		catch (Throwable primarykey_exception)
+		{
+			/* The error is returned back to the calling C code
+			 * through ReturnResultSetErrorMessage. */
+
+			primarykey_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+			return null;
+		}
+	}
+
+/*
+ * IndexColumns
+ *		Returns the columns of each index of the given table, in index
+ *		order, as reported by the driver: the primary key first, then
+ *		the indexes of getIndexInfo.  An index on an expression stops
+ *		at its first expression.  Returns null on error, which
+ *		ReturnResultSetErrorMessage then describes.
+ */
+	public String[][]
+	IndexColumns(String table)
+	{
+		DatabaseMetaData 	db_metadata;
+		ResultSet 		index_set = null;
+		String[] 		location;
+		String[] 		key_columns;
+		ArrayList<String[]> 	indexes = new ArrayList<String[]>();
+		TreeMap<String, TreeMap<Short, String>> 	index_columns = new TreeMap<String, TreeMap<Short, String>>();
+		TreeMap<Short, String> 	columns;
+		String 			index_name;
+
+		iterate_error_message = null;
+
+		try
+		{
+			db_metadata = conn.getMetaData();
+			location = TableLocation(table, db_metadata);
+
+			key_columns = PrimaryKey(db_metadata, location);
+			if (key_columns.length > 0)
+			{
+				indexes.add(key_columns);
+			}
+
+			index_set = db_metadata.getIndexInfo(location[0], location[1], location[2], false, true);
+			while (index_set.next())
+			{
+				index_name = index_set.getString("INDEX_NAME");
+				if (index_set.getShort("TYPE") == DatabaseMetaData.tableIndexStatistic || index_name == null)
+				{
+					continue;
+				}
+
+				columns = index_columns.get(index_name);
+				if (columns == null)
+				{
+					columns = new TreeMap<Short, String>();
+					index_columns.put(index_name, columns);
+				}
+				columns.put(index_set.getShort("ORDINAL_POSITION"), index_set.getString("COLUMN_NAME"));
+			}
+			index_set.close();
+		}
+		catch (Throwable index_exception)
+		{
+			/* The error is returned back to the calling C code
+			 * through ReturnResultSetErrorMessage. */
+
+			try
+			{
+				if (index_set != null)
+				{
+					index_set.close();
+				}
+			}
+			catch (SQLException close_exception)
+			{
+			}
+
+			index_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+			return null;
+		}
+
+		for (TreeMap<Short, String> index : index_columns.values())
+		{
+			ArrayList<String> 	leading = new ArrayList<String>();
+			short 			position = 1;
+
+			/* Only the columns before a gap or an expression */
+			while (index.get(position) != null)
+			{
+				leading.add(index.get(position));
+				position++;
+			}
+
+			if (!leading.isEmpty())
+			{
+				indexes.add(leading.toArray(new String[0]));
+			}
+		}
+
+		return indexes.toArray(new String[0][]);
+	}
+
+/*
+ * Dialect
+ *		Describes the SQL the remote database accepts, from its
+ *		DatabaseMetaData and what is known of the product: the product
+ *		name and version, where NULLs sort ("high", "low", "start",
+ *		"end", or "" if the driver does not say), "t" if ORDER BY
+ *		accepts NULLS FIRST and NULLS LAST, else "f", and the string
+ *		quoting identifiers, "" if they cannot be quoted.  Returns null
+ *		on error, which ReturnResultSetErrorMessage then describes.
+ */
+	public String[]
+	Dialect()
+	{
+		DatabaseMetaData 	db_metadata;
+		String 			product;
+		String 			null_order;
+		String 			quote;
+		boolean 		nulls_clause;
+
+		iterate_error_message = null;
+
+		try
+		{
+			db_metadata = conn.getMetaData();
+			product = db_metadata.getDatabaseProductName();
+
+			if (db_metadata.nullsAreSortedHigh())
+				null_order = "high";
+			else if (db_metadata.nullsAreSortedLow())
+				null_order = "low";
+			else if (db_metadata.nullsAreSortedAtStart())
+				null_order = "start";
+			else if (db_metadata.nullsAreSortedAtEnd())
+				null_order = "end";
+			else
+				null_order = "";
+
+			nulls_clause = AcceptsNullsOrdering(product.toLowerCase(), db_metadata);
+
+			quote = db_metadata.getIdentifierQuoteString();
+			quote = (quote == null) ? "" : quote.trim();
+
+			return new String[] { product, db_metadata.getDatabaseProductVersion(), null_order, nulls_clause ? "t" : "f", quote };
+		}
+		catch (Throwable dialect_exception)
+		{
+			/* The error is returned back to the calling C code
+			 * through ReturnResultSetErrorMessage. */
+
+			dialect_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+			return null;
+		}
+	}
+
+/*
+ * AcceptsNullsOrdering
+ *		Whether ORDER BY accepts NULLS FIRST and NULLS LAST on the
+ *		database of the given lower case product name.  MySQL, MariaDB
+ *		and SQL Server do not; SQLite does since 3.30.
+ */
+	private static boolean
+	AcceptsNullsOrdering(String product, DatabaseMetaData db_metadata) throws SQLException
+	{
+		String[] 	accepting = { "postgresql", "oracle", "db2", "hsql", "derby", "firebird",
+					      "snowflake", "vertica", "exasol", "trino", "presto" };
+
+		if (product.contains("sqlite"))
+		{
+			return db_metadata.getDatabaseMajorVersion() > 3 ||
+				(db_metadata.getDatabaseMajorVersion() == 3 && db_metadata.getDatabaseMinorVersion() >= 30);
+		}
+
+		if (product.equals("h2"))
+		{
+			return true;
+		}
+
+		for (String name : accepting)
+		{
+			if (product.contains(name))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+/*
+ * TableLocation
+ *		Returns the catalog, schema and name of the given table, named
+ *		as in the table option, for DatabaseMetaData calls.  The catalog
+ *		and schema are null when the name does not give them.
+ */
+	private static String[]
+	TableLocation(String table, DatabaseMetaData db_metadata) throws SQLException
+	{
+		ArrayList<String> 	parts = SplitQualifiedName(table, db_metadata);
+		String 			catalog = null;
+		String 			schema = null;
+
+		if (parts.size() >= 3)
+		{
+			catalog = parts.get(parts.size() - 3);
+		}
+		if (parts.size() >= 2)
+		{
+			/* A two part name is catalog.table for drivers
+			 * without schemas, such as MySQL. */
+			if (db_metadata.supportsSchemasInTableDefinitions())
+				schema = parts.get(parts.size() - 2);
+			else
+				catalog = parts.get(parts.size() - 2);
+		}
+
+		return new String[] { catalog, schema, parts.get(parts.size() - 1) };
+	}
+
+/*
+ * PrimaryKey
+ *		Returns the primary key columns of the table at the given
+ *		location, in key order.
+ */
+	private static String[]
+	PrimaryKey(DatabaseMetaData db_metadata, String[] location) throws SQLException
+	{
+		ResultSet 		key_set;
+		TreeMap<Short, String> 	key_columns = new TreeMap<Short, String>();
+
+		key_set = db_metadata.getPrimaryKeys(location[0], location[1], location[2]);
+		try
+		{
+			while (key_set.next())
+			{
+				key_columns.put(key_set.getShort("KEY_SEQ"), key_set.getString("COLUMN_NAME"));
+			}
+		}
+		finally
+		{
+			key_set.close();
+		}
+
+		return key_columns.values().toArray(new String[0]);
+	}
+
+/*
+ * ImportSchema
+ *		Describes the tables of a remote schema for IMPORT FOREIGN
+ *		SCHEMA with a single getColumns call, whatever the number of
+ *		tables.  Returns six strings per column, those of a table next
+ *		to each other in column order: the table name, the table name
+ *		qualified and quoted for remote SQL, the column name, the column
+ *		name quoted for remote SQL, the PostgreSQL type and "t" or "f"
+ *		for NOT NULL.  For databases without schemas, such as MySQL, the
+ *		schema is the catalog.  Returns null on error, which
+ *		ReturnResultSetErrorMessage then describes.
+ */
+	public String[]
+	ImportSchema(String schema)
+	{
+		DatabaseMetaData 	db_metadata;
+		ResultSet 		column_set = null;
+		LinkedHashMap<List<String>, ArrayList<String>> tables = new LinkedHashMap<List<String>, ArrayList<String>>();
+		ArrayList<String> 	columns = new ArrayList<String>();
+		ArrayList<String> 	table_columns;
+		HashSet<String> 	keywords;
+		String 			quote;
+		String 			row_schema;
+		String 			table;
+		boolean 		use_schemas;
+
+		iterate_error_message = null;
+
+		try
+		{
+			db_metadata = conn.getMetaData();
+			quote = IdentifierQuote(db_metadata);
+			keywords = ReservedWords(db_metadata);
+			use_schemas = db_metadata.supportsSchemasInTableDefinitions();
+
+			/* The schema is a pattern, where _ and % are wildcards,
+			 * and the catalog is not. */
+			if (use_schemas)
+				column_set = db_metadata.getColumns(null, EscapeSearchPattern(schema, db_metadata.getSearchStringEscape()), "%", "%");
+			else
+				column_set = db_metadata.getColumns(schema, null, "%", "%");
+
+			while (column_set.next())
+			{
+				/* Drivers matching names without regard to case
+				 * may return other schemas too. */
+				row_schema = column_set.getString(use_schemas ? "TABLE_SCHEM" : "TABLE_CAT");
+				if (!schema.equals(row_schema))
+				{
+					continue;
+				}
+
+				table = column_set.getString("TABLE_NAME");
+				table_columns = tables.get(Arrays.asList(row_schema, table));
+				if (table_columns == null)
+				{
+					table_columns = new ArrayList<String>();
+					tables.put(Arrays.asList(row_schema, table), table_columns);
+				}
+
+				table_columns.add(table);
+				table_columns.add(QuoteIdentifier(row_schema, db_metadata, quote, keywords) + "." + QuoteIdentifier(table, db_metadata, quote, keywords));
+				table_columns.add(column_set.getString("COLUMN_NAME"));
+				table_columns.add(QuoteIdentifier(column_set.getString("COLUMN_NAME"), db_metadata, quote, keywords));
+				table_columns.add(PostgresTypeName(column_set.getInt("DATA_TYPE"),
+								   column_set.getInt("COLUMN_SIZE"),
+								   column_set.getInt("DECIMAL_DIGITS")));
+				table_columns.add((column_set.getInt("NULLABLE") == DatabaseMetaData.columnNoNulls) ? "t" : "f");
+			}
+			column_set.close();
+		}
+		catch (Throwable import_exception)
+		{
+			/* The error is returned back to the calling C code
+			 * through ReturnResultSetErrorMessage. */
+
+			try
+			{
+				if (column_set != null)
+				{
+					column_set.close();
+				}
+			}
+			catch (SQLException close_exception)
+			{
+			}
+
+			import_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+			return null;
+		}
+
+		for (ArrayList<String> table_strings : tables.values())
+		{
+			columns.addAll(table_strings);
+		}
+
+		return columns.toArray(new String[0]);
+	}
+
+/*
+ * EscapeSearchPattern
+ *		Returns a name as a DatabaseMetaData search pattern matching
+ *		only itself, with its wildcards escaped by escape.
+ */
+	private static String
+	EscapeSearchPattern(String name, String escape)
+	{
+		if (escape == null || escape.length() == 0)
+		{
+			return name;
+		}
+
+		return name.replace(escape, escape + escape).replace("_", escape + "_").replace("%", escape + "%");
+	}
+
+/*
+ * IdentifierQuote
+ *		Returns the string quoting identifiers on the database, "" if
+ *		they cannot be quoted.
+ */
+	private static String
+	IdentifierQuote(DatabaseMetaData db_metadata) throws SQLException
+	{
+		String 	quote = db_metadata.getIdentifierQuoteString();
+
+		return (quote == null) ? "" : quote.trim();
+	}
+
+/*
+ * ReservedWords
+ *		Returns the upper case words the database reserves, which must
+ *		be quoted to be identifiers.
+ */
+	private static HashSet<String>
+	ReservedWords(DatabaseMetaData db_metadata) throws SQLException
+	{
+		HashSet<String> 	words = new HashSet<String>(Arrays.asList(SQL_RESERVED_WORDS));
+		String 			keywords = db_metadata.getSQLKeywords();
+
+		if (keywords != null)
+		{
+			for (String word : keywords.split(","))
+			{
+				words.add(word.trim().toUpperCase());
+			}
+		}
+
+		return words;
+	}
+
+/*
+ * QuoteIdentifier
+ *		Returns a remote identifier as it must be written in remote SQL:
+ *		as is if the database would find it unquoted, else quoted with
+ *		the database's quote string.  Reserved words are quoted.
+ */
+	private static String
+	QuoteIdentifier(String identifier, DatabaseMetaData db_metadata, String quote, Set<String> keywords) throws SQLException
+	{
+		boolean 	plain = identifier.matches("[A-Za-z_][A-Za-z0-9_]*");
+
+		if (plain && db_metadata.storesUpperCaseIdentifiers())
+			plain = identifier.equals(identifier.toUpperCase());
+		else if (plain && db_metadata.storesLowerCaseIdentifiers())
+			plain = identifier.equals(identifier.toLowerCase());
+
+		if (plain && keywords.contains(identifier.toUpperCase()))
+			plain = false;
+
+		if (plain || quote.length() == 0)
+		{
+			return identifier;
+		}
+
+		return quote + identifier.replace(quote, quote + quote) + quote;
+	}
+
+/*
+ * PostgresTypeName
+ *		Returns the PostgreSQL type of a remote column of the given
+ *		java.sql.Types type, size and scale.  Types without a close
+ *		match are read as text.
+ */
+	private static String
+	PostgresTypeName(int data_type, int size, int scale)
+	{
+		switch (data_type)
+		{
+			case Types.BIT:
+				/* BIT(n) of several bits, whose text no type reads
+				 * alike on all databases */
+				if (size > 1)
+					return "text";
+				return "boolean";
+			case Types.BOOLEAN:
+				return "boolean";
+			case Types.TINYINT:
+			case Types.SMALLINT:
+				return "smallint";
+			case Types.INTEGER:
+				return "integer";
+			case Types.BIGINT:
+				return "bigint";
+			case Types.REAL:
+				return "real";
+			case Types.FLOAT:
+			case Types.DOUBLE:
+				return "double precision";
+			case Types.NUMERIC:
+			case Types.DECIMAL:
+				if (size > 0 && size <= 1000 && scale >= 0 && scale <= size)
+					return "numeric(" + size + "," + scale + ")";
+				return "numeric";
+			case Types.CHAR:
+			case Types.NCHAR:
+				if (size > 0 && size <= 10485760)
+					return "character(" + size + ")";
+				return "text";
+			case Types.VARCHAR:
+			case Types.NVARCHAR:
+				if (size > 0 && size <= 10485760)
+					return "character varying(" + size + ")";
+				return "text";
+			case Types.DATE:
+				return "date";
+			case Types.TIME:
+				return "time without time zone";
+			case Types.TIME_WITH_TIMEZONE:
+				return "time with time zone";
+			case Types.TIMESTAMP:
+				return "timestamp without time zone";
+			case Types.TIMESTAMP_WITH_TIMEZONE:
+				return "timestamp with time zone";
+			case Types.BINARY:
+			case Types.VARBINARY:
+			case Types.LONGVARBINARY:
+			case Types.BLOB:
+				return "bytea";
+			default:
+				return "text";
+		}
+	}
+
+/*
+ * SplitQualifiedName
+ *		Splits a possibly qualified table name at the dots outside
+ *		quotes, written with the database's quote string.  Quoted parts
+ *		are unquoted; others are folded to the case the database stores
+ *		unquoted identifiers in.
+ */
+	private static ArrayList<String>
+	SplitQualifiedName(String name, DatabaseMetaData db_metadata) throws SQLException
+	{
+		ArrayList<String> 	parts = new ArrayList<String>();
+		StringBuilder 		part = new StringBuilder();
+		String 			quote = IdentifierQuote(db_metadata);
+		String 			identifier;
+		boolean 		in_quotes = false;
+		int 			i = 0;
+		char 			c;
+
+		for (i = 0; i <= name.length(); i++)
+		{
+			c = (i < name.length()) ? name.charAt(i) : '.';
+
+			if (quote.length() > 0 && name.startsWith(quote, i))
+			{
+				in_quotes = !in_quotes;
+				part.append(quote);
+				i += quote.length() - 1;
+				continue;
+			}
+
+			if (c != '.' || in_quotes)
+			{
+				part.append(c);
+				continue;
+			}
+
+			identifier = part.toString().trim();
+
+			if (quote.length() > 0 && identifier.startsWith(quote))
+				parts.add(UnquoteIdentifier(identifier, quote));
+			else if (db_metadata.storesUpperCaseIdentifiers())
+				parts.add(identifier.toUpperCase());
+			else if (db_metadata.storesLowerCaseIdentifiers())
+				parts.add(identifier.toLowerCase());
+			else
+				parts.add(identifier);
+			part.setLength(0);
+		}
+
+		return parts;
+	}
+
+/*
+ * Execute
+ *		Executes the query, binding the given parameter values, and
+ *		sets up reading its result set.  Called again to rescan, when
+ *		the result set of the previous execution is closed first.
+ */
+	public String
+	Execute(String[] param_types, String[] param_values)
+	{
+		ResultSetMetaData 	result_set_metadata;
+
+		try
+		{
+			if (result_set != null)
+			{
+				result_set.close();
+				result_set = null;
+			}
+
+			if (param_values.length != number_of_params)
+			{
+				throw new IllegalArgumentException("query has " + number_of_params + " parameters, " + param_values.length + " values given");
+			}
+
+			this.param_types = param_types;
+			this.param_values = param_values;
+
+			/* A rescan starts again from the first page. */
+			if (page_size > 0)
+			{
+				sql = first_page_statement;
+				rows_read = 0;
+				page_rows = 0;
+				page_limit = PageLimit();
+				sql.setMaxRows(page_limit);
+			}
+
+			BindParameters(sql, param_types, param_values);
+			result_set = sql.executeQuery();
+			result_set_exhausted = false;
+
+			/* The result columns are the same for every execution. */
+			if (Iterate == null)
+			{
+				result_set_metadata = result_set.getMetaData();
+				NumberOfColumns = result_set_metadata.getColumnCount();
+				Iterate = new String[NumberOfColumns];
+				InitializeNeededColumns(retrieved_columns);
+				InitializeDictionaries(result_set_metadata);
+
+				if (page_size > 0)
+				{
+					page_key_column = result_set.findColumn(UnquoteIdentifier(page_key, IdentifierQuote(conn.getMetaData())));
+				}
+			}
+		}
+		catch (Throwable execute_exception)
+		{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
+
+			execute_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
+		}
+
+		return null;
+	}
+
+/*
+ * NextRow
+ *		Advances result_set to the next row.  With keyset pagination, a
+ *		full page is followed by the next one, read as the rows after
+ *		the last key seen.
+ */
+	private boolean
+	NextRow() throws SQLException
+	{
+		while (!result_set.next())
+		{
+			if (page_size <= 0 || page_rows < page_limit || PageLimit() == 0)
+			{
+				return false;
+			}
+
+			ExecuteNextPage();
+		}
+
+		if (page_size > 0)
+		{
+			page_last_key = result_set.getObject(page_key_column);
+			if (page_last_key == null)
+			{
+				throw new SQLException("page_key column " + page_key + " is NULL");
+			}
+			page_rows++;
+			rows_read++;
+		}
+
+		return true;
+	}
+
+/*
+ * ExecuteNextPage
+ *		Runs the query of the page after page_last_key.  Outside a
+ *		remote transaction, a failing page is tried again, on a new
+ *		connection if the old one is no longer valid, so that a
+ *		transient error does not restart a long scan from the start.
+ *		A query cancel stops the retries.
+ */
+	private void
+	ExecuteNextPage() throws SQLException
+	{
+		int 	attempt = 0;
+
+		result_set.close();
+		result_set = null;
+		sql = next_page_statement;
+		page_rows = 0;
+		page_limit = PageLimit();
+
+		for (;;)
+		{
+			try
+			{
+				sql.setMaxRows(page_limit);
+				BindParameters(sql, param_types, param_values);
+				sql.setObject(param_values.length + 1, page_last_key);
+				result_set = sql.executeQuery();
+				return;
+			}
+			catch (SQLException page_exception)
+			{
+				/* What a remote transaction did before the error
+				 * may be lost, so its scans are never retried. */
+				if (++attempt >= PAGE_ATTEMPTS || in_transaction)
+				{
+					throw page_exception;
+				}
+
+				WaitBeforeRetry(PAGE_RETRY_MILLIS * attempt, page_exception);
+
+				if (!conn.isValid(1))
+				{
+					Reconnect(page_exception);
+				}
+			}
+		}
+	}
+
+/*
+ * WaitBeforeRetry
+ *		Sleeps for millis, and throws cause as the error of the scan if
+ *		a query cancel arrives meanwhile.
+ */
+	private static void
+	WaitBeforeRetry(long millis, SQLException cause) throws SQLException
+	{
+		long 	deadline = System.currentTimeMillis() + millis;
+		long 	remaining;
+
+		while ((remaining = deadline - System.currentTimeMillis()) > 0)
+		{
+			if (InterruptPending())
+			{
+				break;
+			}
+
+			try
+			{
+				Thread.sleep(Math.min(remaining, PAGE_RETRY_SLICE_MILLIS));
+			}
+			catch (InterruptedException sleep_exception)
+			{
+				Thread.currentThread().interrupt();
+				break;
+			}
+		}
+
+		if (InterruptPending() || Thread.currentThread().isInterrupted())
+		{
+			throw new SQLException("canceling statement due to user request", "57014", cause);
+		}
+	}
+
+/*
+ * Reconnect
+ *		Replaces an invalid connection with a new one and prepares the
+ *		page statements on it.  The error of the failed page, cause, is
+ *		reported if that fails.
+ */
+	private void
+	Reconnect(SQLException cause) throws SQLException
+	{
+		DiscardConnection(conn);
+
+		try
+		{
+			conn = Connect();
+			first_page_statement = PrepareCachedStatement(conn, "SELECT * FROM (" + query + ") jdbc_fdw_page ORDER BY " + page_key);
+			next_page_statement = PrepareCachedStatement(conn, "SELECT * FROM (" + query + ") jdbc_fdw_page WHERE " + page_key + " > ? ORDER BY " + page_key);
+			first_page_statement.setQueryTimeout(query_timeout);
+			next_page_statement.setQueryTimeout(query_timeout);
+			ApplyStreamingProfile(conn, first_page_statement);
+			ApplyStreamingProfile(conn, next_page_statement);
+			sql = next_page_statement;
+		}
+		catch (Exception reconnect_exception)
+		{
+			throw new SQLException("could not reconnect after a page failed: " + cause.getMessage(), cause.getSQLState(), reconnect_exception);
+		}
+	}
+
+/*
+ * SetInterruptFlag
+ *		Gives the Java side the backend's query cancel flag, as a direct
+ *		buffer over its memory.
+ */
+	public static void
+	SetInterruptFlag(ByteBuffer flag)
+	{
+		interrupt_flag = flag;
+	}
+
+/*
+ * InterruptPending
+ *		Whether the backend has received a query cancel it has not
+ *		processed yet.
+ */
+	private static boolean
+	InterruptPending()
+	{
+		return interrupt_flag != null && interrupt_flag.get(0) != 0;
+	}
+
+/*
+ * PageLimit
+ *		Returns the number of rows the next page may have: page_size,
+ *		less near the end of a scan limited to maxrows.
+ */
+	private int
+	PageLimit()
+	{
+		if (maxrows > 0 && maxrows - rows_read < page_size)
+		{
+			return (int) Math.max(maxrows - rows_read, 0);
+		}
+		return page_size;
+	}
+
+/*
+ * UnquoteIdentifier
+ *		Returns the column label of an identifier possibly quoted with
+ *		quote.
+ */
+	private static String
+	UnquoteIdentifier(String identifier, String quote)
+	{
+		int 	length = quote.length();
+
+		if (length > 0 && identifier.length() >= 2 * length && identifier.startsWith(quote) && identifier.endsWith(quote))
+		{
+			return identifier.substring(length, identifier.length() - length).replace(quote + quote, quote);
+		}
+		return identifier;
+	}
+
+/*
+ * ResolveStreamingProfile
+ *		Returns the streaming profile to use: the one given, or for
+ *		"auto" the one matching the driver class.
+ */
+	private static String
+	ResolveStreamingProfile(String profile, String driver_class_name)
+	{
+		if (!profile.equals("auto"))
+		{
+			return profile;
+		}
+
+		if (driver_class_name.startsWith("org.postgresql."))
+			return "postgresql";
+		if (driver_class_name.startsWith("com.mysql.") || driver_class_name.startsWith("org.mariadb."))
+			return "mysql";
+		if (driver_class_name.startsWith("com.microsoft.sqlserver."))
+			return "sqlserver";
+		return "generic";
+	}
+
+/*
+ * ApplyStreamingProfile
+ *		Sets up the statement so that the driver streams the result
+ *		instead of reading it all into the JVM heap.  PgJDBC only uses
+ *		a cursor with a fetch size outside autocommit mode; MySQL
+ *		Connector/J streams row by row with a fetch size of
+ *		Integer.MIN_VALUE; other drivers honour the fetch size.
+ */
+	private void
+	ApplyStreamingProfile(Connection statement_conn, PreparedStatement statement) throws SQLException
+	{
+		if (streaming_profile.equals("none"))
+		{
+			return;
+		}
+
+		if (streaming_profile.equals("postgresql"))
+		{
+			statement_conn.setAutoCommit(false);
+		}
+
+		if (streaming_profile.equals("mysql"))
+		{
+			statement.setFetchSize(Integer.MIN_VALUE);
+		}
+		else
+		{
+			statement.setFetchSize(fetch_size);
+		}
+	}
+
+/*
+ * BindParameters
+ *		Binds the parameters of a prepared query.  Each value comes
+ *		with the name of its binding: int2, int4, int8, float4, float8,
+ *		numeric, bool, date, timestamp and timestamptz values are bound
+ *		with the matching JDBC type, in the text forms the C code
+ *		produces, and anything else as a string.  A value that does not parse is bound as a string.
+ */
+	private static void
+	BindParameters(PreparedStatement statement, String[] param_types, String[] param_values) throws SQLException
+	{
+		int 	i = 0;
+		String 	type;
+		String 	value;
+
+		for (i = 0; i < param_values.length; i++)
+		{
+			type = param_types[i];
+			value = param_values[i];
+
+			if (value == null)
+			{
+				statement.setNull(i+1, ParameterSqlType(type));
+				continue;
+			}
+
+			try
+			{
+				if (type.equals("int2"))
+					statement.setShort(i+1, Short.parseShort(value));
+				else if (type.equals("int4"))
+					statement.setInt(i+1, Integer.parseInt(value));
+				else if (type.equals("int8"))
+					statement.setLong(i+1, Long.parseLong(value));
+				else if (type.equals("float4"))
+					statement.setFloat(i+1, Float.parseFloat(value));
+				else if (type.equals("float8"))
+					statement.setDouble(i+1, Double.parseDouble(value));
+				else if (type.equals("numeric"))
+					statement.setBigDecimal(i+1, new BigDecimal(value));
+				else if (type.equals("bool"))
+					statement.setBoolean(i+1, value.equals("t"));
+				else if (type.equals("date"))
+					statement.setDate(i+1, java.sql.Date.valueOf(value));
+				else if (type.equals("timestamp"))
+					statement.setTimestamp(i+1, Timestamp.valueOf(value));
+				else if (type.equals("timestamptz"))
+					statement.setTimestamp(i+1, EpochMicrosToTimestamp(Long.parseLong(value)));
+				else
+					statement.setString(i+1, value);
+			}
+			catch (IllegalArgumentException parameter_exception)
+			{
+				statement.setString(i+1, value);
+			}
+		}
+	}
+
+/*
+ * EpochMicrosToTimestamp
+ *		Returns the Timestamp of the instant given in microseconds
+ *		since the Unix epoch.
+ */
+	private static Timestamp
+	EpochMicrosToTimestamp(long micros)
+	{
+		long 		seconds = micros / 1000000;
+		long 		remainder = micros % 1000000;
+		Timestamp 	timestamp;
+
+		if (remainder < 0)
+		{
+			seconds--;
+			remainder += 1000000;
+		}
+
+		timestamp = new Timestamp(seconds * 1000);
+		timestamp.setNanos((int) remainder * 1000);
+
+		return timestamp;
+	}
+
+/*
+ * ParameterSqlType
+ *		Returns the java.sql.Types code of a parameter binding name.
+ */
+	private static int
+	ParameterSqlType(String type)
+	{
+		if (type.equals("int2"))
+			return Types.SMALLINT;
+		if (type.equals("int4"))
+			return Types.INTEGER;
+		if (type.equals("int8"))
+			return Types.BIGINT;
+		if (type.equals("float4"))
+			return Types.REAL;
+		if (type.equals("float8"))
+			return Types.DOUBLE;
+		if (type.equals("numeric"))
+			return Types.NUMERIC;
+		if (type.equals("bool"))
+			return Types.BOOLEAN;
+		if (type.equals("date"))
+			return Types.DATE;
+		if (type.equals("timestamp") || type.equals("timestamptz"))
+			return Types.TIMESTAMP;
+		return Types.VARCHAR;
+	}
+
+/*
+ * ReturnResultSet
+ *		Returns the result set that is returned from the foreign database
+ *		after execution of the query to C code.
+ */
+	public String[] 
+	ReturnResultSet()
+	{
+		iterate_error_message = null;
+
+		try
+		{
+			/* Row-by-row processing is done in jdbc_fdw.One row
+			 * at a time is returned to the C code. */
+			if (ReadRow())
+			{
+				++NumberOfRows;				
+				
+				/* The current row in result_set is returned
+				 * to the C code in a Java String array that
+				 * has the value of the fields of the current
+				 * row as it values. */
+
+				return (Iterate);
+			}
+
+		}
+		catch (Exception returnresultset_exception)
+	 	{
+			returnresultset_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+	 	}
+
+		/* All of result_set's rows have been returned to the C code. */
+		return null;
+	}
+
+/*
+ * ReadRow
+ *		Advances result_set to the next row that passes the filter and
+ *		reads the needed columns of it into Iterate.  Returns false
+ *		when there are no more rows.
+ */
+	private boolean
+	ReadRow() throws SQLException
+	{
+		int 	i = 0;
+
+		while (NextRow())
+		{
+			for (i = 0; i < NumberOfColumns; i++)
+			{
+				/* Columns the query does not reference are
+				 * never read from the result set. */
+				if (column_needed[i])
+				{
+					Iterate[i] = result_set.getString(i+1);
+				}
+			}
+
+			/* Rows failing the quals JDBCUtils can evaluate
+			 * are dropped before they reach the C code. */
+			if (filter == null || filter.Accept(Iterate))
+			{
+				return true;
+			}
+		}
+
+		result_set_exhausted = true;
+		return false;
+	}
+
+/*
+ * ReturnResultSetBatch
+ *		Encodes up to fetch_size rows of the result set into a direct
+ *		ByteBuffer that the C code reads in place.  The buffer starts
+ *		with the number of rows and the offset of the dictionary
+ *		section.  Every column of every row follows, either as an int
+ *		length (-1 for NULL) and that many bytes in the server
+ *		encoding plus a terminating zero byte, or, for dictionary
+ *		encoded columns, as an int code (-1 for NULL).  The
+ *		dictionary section holds, for each column, the number of
+ *		dictionary entries added by this batch (-1 if the column is
+ *		not dictionary encoded) followed by the new entries, encoded
+ *		like plain values.  The buffer is reused for the next batch.
+ *		Returns null once all rows have been returned or if an error
+ *		occurred, such as a server encoding Java has no charset for.
+ */
+	public ByteBuffer
+	ReturnResultSetBatch()
+	{
+		iterate_error_message = null;
+		int 	rows = 0;
+		int 	i = 0;
+
+		try
+		{
+			if (server_charset == null)
+			{
+				throw new UnsupportedEncodingException("server encoding " + server_encoding + " has no Java charset, use transfer_mode 'string'");
+			}
+
+			if (batch_buffer == null)
+			{
+				batch_buffer = ByteBuffer.allocateDirect(BATCH_BUFFER_SIZE);
+				batch_buffer.order(ByteOrder.nativeOrder());
+			}
+
+			batch_buffer.clear();
+			batch_buffer.putInt(0);
+			batch_buffer.putInt(0);
+
+			while (rows < fetch_size && batch_buffer.position() < BATCH_BUFFER_SIZE && ReadRow())
+			{
+				for (i = 0; i < NumberOfColumns; i++)
+				{
+					if (dictionary_active[i])
+					{
+						PutCode(i, Iterate[i]);
+					}
+					else
+					{
+						PutValue(Iterate[i]);
+					}
+				}
+
+				++rows;
+				++NumberOfRows;
+			}
+
+			if (rows > 0)
+			{
+				batch_buffer.putInt(0, rows);
+				batch_buffer.putInt(4, batch_buffer.position());
+				PutDictionaries(rows);
+				return (batch_buffer);
+			}
+		}
+		catch (Exception returnresultsetbatch_exception)
+		{
+			returnresultsetbatch_exception.printStackTrace(exception_stack_trace_print_writer);
+			iterate_error_message = new String(exception_stack_trace_string_writer.toString());
+		}
+
+		/* All of result_set's rows have been returned to the C code. */
+		return null;
+	}
+
+/*
+ * InitializeNeededColumns
+ *		Marks the result columns the query references, given as a comma
+ *		separated list of column numbers, or "*" for all columns.
+ */
+	private void
+	InitializeNeededColumns(String retrieved_columns)
+	{
+		int 	column = 0;
+
+		column_needed = new boolean[NumberOfColumns];
+
+		if (retrieved_columns.equals("*"))
+		{
+			Arrays.fill(column_needed, true);
+			return;
+		}
+
+		if (filter != null)
+		{
+			for (int filter_column : filter.ReferencedColumns())
+			{
+				if (filter_column >= 1 && filter_column <= NumberOfColumns)
+				{
+					column_needed[filter_column - 1] = true;
+				}
+			}
+		}
+
+		for (String column_string : retrieved_columns.split(","))
+		{
+			if (column_string.length() == 0)
+			{
+				continue;
+			}
+
+			column = Integer.parseInt(column_string);
+			if (column >= 1 && column <= NumberOfColumns)
+			{
+				column_needed[column - 1] = true;
+			}
+		}
+	}
+
+/*
+ * InitializeDictionaries
+ *		Sets up dictionary encoding for the character columns of the
+ *		result set.
+ */
+	@SuppressWarnings("unchecked")
+	private void
+	InitializeDictionaries(ResultSetMetaData result_set_metadata) throws SQLException
+	{
+		int 	i = 0;
+
+		dictionary_active = new boolean[NumberOfColumns];
+		dictionary_codes = new HashMap[NumberOfColumns];
+		dictionary_values = new ArrayList[NumberOfColumns];
+		dictionary_sent = new int[NumberOfColumns];
+
+		for (i = 0; i < NumberOfColumns; i++)
+		{
+			if (!column_needed[i])
+			{
+				dictionary_active[i] = false;
+				continue;
+			}
+
+			switch (result_set_metadata.getColumnType(i+1))
+			{
+				case Types.CHAR:
+				case Types.VARCHAR:
+				case Types.NCHAR:
+				case Types.NVARCHAR:
+					dictionary_active[i] = true;
+					dictionary_codes[i] = new HashMap<String, Integer>();
+					dictionary_values[i] = new ArrayList<String>();
+					break;
+				default:
+					dictionary_active[i] = false;
+			}
+		}
+	}
+
+/*
+ * PutCode
+ *		Appends the dictionary code of a value of column i to the batch
+ *		buffer, adding the value to the column's dictionary if it is
+ *		new.
+ */
+	private void
+	PutCode(int i, String value)
+	{
+		Integer 	code;
+
+		EnsureBatchCapacity(4);
+
+		if (value == null)
+		{
+			batch_buffer.putInt(-1);
+			return;
+		}
+
+		code = dictionary_codes[i].get(value);
+		if (code == null)
+		{
+			code = dictionary_values[i].size();
+			dictionary_codes[i].put(value, code);
+			dictionary_values[i].add(value);
+		}
+
+		batch_buffer.putInt(code);
+	}
+
+/*
+ * PutDictionaries
+ *		Appends the dictionary section of a batch of the given number of
+ *		rows.  A column whose dictionary has grown too large, or gained
+ *		mostly new values in this batch, is sent as plain values from
+ *		the next batch on.
+ */
+	private void
+	PutDictionaries(int rows)
+	{
+		int 	i = 0;
+		int 	j = 0;
+		int 	added = 0;
+
+		for (i = 0; i < NumberOfColumns; i++)
+		{
+			EnsureBatchCapacity(4);
+
+			if (!dictionary_active[i])
+			{
+				batch_buffer.putInt(-1);
+				continue;
+			}
+
+			added = dictionary_values[i].size() - dictionary_sent[i];
+			batch_buffer.putInt(added);
+
+			for (j = dictionary_sent[i]; j < dictionary_values[i].size(); j++)
+			{
+				PutValue(dictionary_values[i].get(j));
+			}
+
+			dictionary_sent[i] = dictionary_values[i].size();
+
+			if (dictionary_sent[i] > DICTIONARY_MAX_ENTRIES || (rows >= 16 && added > rows / 2))
+			{
+				dictionary_active[i] = false;
+				dictionary_codes[i] = null;
+				dictionary_values[i] = null;
+			}
+		}
+	}
+
+/*
+ * PutValue
+ *		Appends one length-prefixed, zero-terminated value to the
+ *		batch buffer, growing the buffer if it does not fit.
+ */
+	private void
+	PutValue(String value)
+	{
+		byte[] 	bytes;
+
+		if (value == null)
+		{
+			EnsureBatchCapacity(4);
+			batch_buffer.putInt(-1);
+			return;
+		}
+
+		bytes = value.getBytes(server_charset);
+		EnsureBatchCapacity(bytes.length + 5);
+		batch_buffer.putInt(bytes.length);
+		batch_buffer.put(bytes);
+		batch_buffer.put((byte) 0);
+	}
+
+/*
+ * EnsureBatchCapacity
+ *		Makes room for needed more bytes in the batch buffer.  The
+ *		contents written so far are carried over to the new buffer.
+ */
+	private void
+	EnsureBatchCapacity(int needed)
+	{
+		ByteBuffer 	new_buffer;
+
+		if (batch_buffer.remaining() >= needed)
+		{
+			return;
+		}
+
+		new_buffer = ByteBuffer.allocateDirect(Math.max(batch_buffer.capacity() * 2, batch_buffer.position() + needed));
+		new_buffer.order(ByteOrder.nativeOrder());
+		batch_buffer.flip();
+		new_buffer.put(batch_buffer);
+		batch_buffer = new_buffer;
+	}
+
+/*
+ * ServerEncodingToCharset
+ *		Maps a PostgreSQL server encoding name to the matching Java
+ *		charset, or returns null if Java has none, as for MULE_INTERNAL
+ *		and the JIS X 0213 encodings.  SQL_ASCII, which takes any
+ *		bytes, is written as UTF-8.
+ */
+	private static Charset
+	ServerEncodingToCharset(String encoding)
+	{
+		String[] 	candidates;
+
+		if (encoding.equals("SQL_ASCII"))
+		{
+			return Charset.forName("UTF-8");
+		}
+
+		if (encoding.equals("MULE_INTERNAL") || encoding.equals("SHIFT_JIS_2004") || encoding.equals("EUC_JIS_2004"))
+		{
+			return null;
+		}
+
+		if (encoding.equals("UHC"))
+		{
+			candidates = new String[]{"x-windows-949"};
+		}
+		else if (encoding.equals("EUC_TW"))
+		{
+			candidates = new String[]{"x-EUC-TW"};
+		}
+		else if (encoding.equals("JOHAB"))
+		{
+			candidates = new String[]{"x-Johab"};
+		}
+		else if (encoding.startsWith("WIN"))
+		{
+			candidates = new String[]{"windows-" + encoding.substring(3), "cp" + encoding.substring(3)};
+		}
+		else if (encoding.startsWith("KOI8"))
+		{
+			candidates = new String[]{"KOI8-" + encoding.substring(4)};
+		}
+		else
+		{
+			candidates = new String[]{encoding, encoding.replace('_', '-')};
+		}
+
+		for (String candidate : candidates)
+		{
+			try
+			{
+				return Charset.forName(candidate);
+			}
+			catch (Exception charset_exception)
+			{
+				/* Try the next spelling. */
+			}
+		}
+
+		return null;
+	}
+
+/*
+ * ReturnResultSetErrorMessage
+ *		Returns any error resulting from iterating the result set.
+ *		Call after ReturnResultSet returns null to determine if an
+ *		error occurred or all results have been read, and after
+ *		PrimaryKeyColumns returns null.
+ */
+	public String
+	ReturnResultSetErrorMessage()
+	{
+		return iterate_error_message;
+	}
+
+/*
+ * Close
+ *		Releases the resources used.  If all rows were read, the
+ *		connection and its prepared statements are kept for reuse.  If the
+ *		scan stopped early, many drivers would drain or wait for the
+ *		rest of the remote result on close, so the statement is
+ *		cancelled in the background instead and this returns at once.
+ */
+	public String 
+	Close()
+	{
+		ResultSet 	closing_result_set = result_set;
+		Statement 	closing_statement = sql;
+		Connection 	closing_conn = conn;
+
+		ResetBulkLoad();
+
+		result_set = null;
+		sql = null;
+		conn = null;
+		Iterate = null;
+		batch_buffer = null;
+
+		if (closing_conn == null)
+		{
+			return null;
+		}
+
+		/* Cancelling the statement could abort the remote
+		 * transaction, so an unfinished result is closed here. */
+		if (in_transaction)
+		{
+			in_transaction = false;
+			try
+			{
+				if (closing_result_set != null)
+				{
+					closing_result_set.close();
+				}
+			}
+			catch (Exception close_exception)
+			{
+				/* If an exception occurs,it is returned back to the
+				 * calling C code by returning a Java String object
+				 * that has the exception's stack trace.
+				 * If all goes well,a null String is returned. */
+
+				close_exception.printStackTrace(exception_stack_trace_print_writer);
+				return (new String(exception_stack_trace_string_writer.toString()));
+			}
+			finally
+			{
+				ReleaseTransactionConnection(connection_key, closing_conn);
+			}
+			return null;
+		}
+
+		if (!result_set_exhausted)
+		{
+			TerminateInBackground(closing_result_set, closing_statement, closing_conn, connection_key);
+			return null;
+		}
+
+		try
+		{
+			if (closing_result_set != null)
+			{
+				closing_result_set.close();
+			}
+			ReleaseConnection(connection_key, closing_conn);
+		}
+		catch (Exception close_exception) 
+	 	{
+			/* If an exception occurs,it is returned back to the
+			 * calling C code by returning a Java String object
+			 * that has the exception's stack trace.
+			 * If all goes well,a null String is returned. */
+
+			DiscardConnection(closing_conn);
+	 		close_exception.printStackTrace(exception_stack_trace_print_writer);
+			return (new String(exception_stack_trace_string_writer.toString()));
+	 	}
+
+		return null;
+	}
+
+/*
+ * Cancel
+ *		Cancels the query and releases the resources in case query
+ *		cancellation is requested by the user.  The statement is
+ *		cancelled in the background, so this returns at once.
+ */
+	public String 
+	Cancel()
+	{
+		Connection 	cancelled_conn = conn;
+
+		if (cancelled_conn != null)
+		{
+			/* What the remote transaction did on the connection is
+			 * lost, so it must not commit. */
+			if (in_transaction)
+			{
+				LeaveTransaction(cancelled_conn, "a statement of the remote transaction was cancelled");
+				in_transaction = false;
+			}
+			TerminateInBackground(result_set, sql, cancelled_conn, connection_key);
+		}
+
+		result_set = null;
+		sql = null;
+		conn = null;
+		Iterate = null;
+		batch_buffer = null;
+
+		return null;
+	}
+
+/*
+ * TerminateInBackground
+ *		Cancels a statement whose results are no longer wanted and
+ *		closes it on a helper thread.  The helper waits at most
+ *		CANCEL_WAIT_MILLIS for the driver; the connection is reused if
+ *		the driver recovered cleanly in that time and discarded
+ *		otherwise.
+ */
+	private static void
+	TerminateInBackground(final ResultSet cancelled_result_set, final Statement cancelled_statement,
+			      final Connection cancelled_conn, final String key)
+	{
+		Thread 	terminator = new Thread()
+		{
+			public void run()
+			{
+				final boolean[] 	recovered = new boolean[1];
+				Thread 			canceller = new Thread()
+				{
+					public void run()
+					{
+						try
+						{
+							if (cancelled_statement != null)
+							{
+								ForgetCachedStatement(cancelled_conn, cancelled_statement);
+								cancelled_statement.cancel();
+							}
+							if (cancelled_result_set != null)
+							{
+								cancelled_result_set.close();
+							}
+							if (cancelled_statement != null)
+							{
+								cancelled_statement.close();
+							}
+							recovered[0] = cancelled_conn.isValid(1);
+						}
+						catch (Throwable cancel_exception)
+						{
+							recovered[0] = false;
+						}
+					}
+				};
+
+				canceller.setDaemon(true);
+				canceller.start();
+
+				try
+				{
+					canceller.join(CANCEL_WAIT_MILLIS);
+				}
+				catch (InterruptedException join_exception)
+				{
+					/* Treated like a timeout. */
+				}
+
+				if (!canceller.isAlive() && recovered[0])
+				{
+					ReleaseConnection(key, cancelled_conn);
+				}
+				else
+				{
+					DiscardConnection(cancelled_conn);
+				}
+			}
+		};
+
+		terminator.setDaemon(true);
+		terminator.start();
+	}
+
+/*
+ * BeginTransaction
+ *		Starts a remote transaction on conn at the given isolation level,
+ *		or the default one of the driver if it has no such level, and
+ *		adds it to the remote transactions, with savepoints up to the
+ *		current local subtransaction level.  Returns false if the driver
+ *		has no transactions, and statements then run in autocommit mode.
+ */
+	private static synchronized boolean
+	BeginTransaction(String key, Connection conn, DatabaseMetaData db_metadata, String isolation_level,
+			 int level) throws SQLException
+	{
+		RemoteTransaction 	xact;
+		int 			isolation = IsolationLevelCode(isolation_level);
+
+		if (!db_metadata.supportsTransactions())
+		{
+			return false;
+		}
+
+		conn.setAutoCommit(false);
+		if (db_metadata.supportsTransactionIsolationLevel(isolation))
+		{
+			conn.setTransactionIsolation(isolation);
+		}
+
+		xact = new RemoteTransaction();
+		xact.key = key;
+		xact.conn = conn;
+		xact.busy = true;
+		xact.savepoints_supported = db_metadata.supportsSavepoints();
+		remote_transactions.add(xact);
+
+		AddSavepoints(xact, level);
+
+		return true;
+	}
+
+/*
+ * IsolationLevelCode
+ *		Returns the JDBC constant of an isolation_level value.
+ */
+	private static int
+	IsolationLevelCode(String isolation_level)
+	{
+		if (isolation_level.equals("read uncommitted"))
+			return Connection.TRANSACTION_READ_UNCOMMITTED;
+		if (isolation_level.equals("read committed"))
+			return Connection.TRANSACTION_READ_COMMITTED;
+		if (isolation_level.equals("serializable"))
+			return Connection.TRANSACTION_SERIALIZABLE;
+		return Connection.TRANSACTION_REPEATABLE_READ;
+	}
+
+/*
+ * TakeTransactionConnection
+ *		Returns a connection for the given key that is in the remote
+ *		transaction and not used by another scan, or null.
+ */
+	private static synchronized Connection
+	TakeTransactionConnection(String key, int level) throws SQLException
+	{
+		for (RemoteTransaction xact : remote_transactions)
+		{
+			if (!xact.busy && xact.key.equals(key))
+			{
+				xact.busy = true;
+				AddSavepoints(xact, level);
+				return xact.conn;
+			}
+		}
+
+		return null;
+	}
+
+/*
+ * AddSavepoints
+ *		Sets a savepoint for each local subtransaction up to level that
+ *		the connection has none for yet, so that their aborts can undo
+ *		what it does from now on.
+ */
+	private static void
+	AddSavepoints(RemoteTransaction xact, int level) throws SQLException
+	{
+		while (xact.savepoints.size() < level - 1)
+		{
+			xact.savepoints.add(xact.savepoints_supported ? xact.conn.setSavepoint() : null);
+		}
+	}
+
+/*
+ * ReleaseTransactionConnection
+ *		Makes a connection of the remote transaction available to later
+ *		scans.  If the transaction ended meanwhile, the connection is
+ *		released like any other.
+ */
+	private static synchronized void
+	ReleaseTransactionConnection(String key, Connection released_conn)
+	{
+		for (RemoteTransaction xact : remote_transactions)
+		{
+			if (xact.conn == released_conn)
+			{
+				xact.busy = false;
+				return;
+			}
+		}
+
+		ReleaseConnection(key, released_conn);
+	}
+
+/*
+ * LeaveTransaction
+ *		Removes a connection from the remote transactions, which then
+ *		fail to commit with the given reason.
+ */
+	private static synchronized void
+	LeaveTransaction(Connection left_conn, String reason)
+	{
+		Iterator<RemoteTransaction> 	iterator = remote_transactions.iterator();
+
+		while (iterator.hasNext())
+		{
+			if (iterator.next().conn == left_conn)
+			{
+				iterator.remove();
+			}
+		}
+
+		if (remote_transaction_error == null)
+		{
+			remote_transaction_error = reason;
+		}
+	}
+
+/*
+ * EndTransactions
+ *		Commits or rolls back the remote transactions when the local
+ *		transaction ends, and releases their connections.  If a commit
+ *		fails, the error is returned and nothing is released, as the
+ *		local transaction then aborts and calls this again to roll the
+ *		others back.  The remote transactions commit one after the
+ *		other, so one may commit before another fails.
+ */
+	public static synchronized String
+	EndTransactions(boolean commit)
+	{
+		StringWriter 	string_writer;
+
+		if (commit)
+		{
+			try
+			{
+				if (remote_transaction_error != null)
+				{
+					throw new SQLException(remote_transaction_error);
+				}
+
+				for (RemoteTransaction xact : remote_transactions)
+				{
+					xact.conn.commit();
+				}
+			}
+			catch (Throwable commit_exception)
+			{
+				/* If an exception occurs,it is returned back to the
+				 * calling C code by returning a Java String object
+				 * that has the exception's stack trace.
+				 * If all goes well,a null String is returned. */
+
+				string_writer = new StringWriter();
+				commit_exception.printStackTrace(new PrintWriter(string_writer));
+				return string_writer.toString();
+			}
+		}
+
+		/* A connection still in use belongs to a scan that will never
+		 * be closed, such as one of an aborted subtransaction. */
+		for (RemoteTransaction xact : remote_transactions)
+		{
+			if (xact.busy)
+			{
+				DiscardConnection(xact.conn);
+			}
+			else
+			{
+				ReleaseConnection(xact.key, xact.conn);
+			}
+		}
+
+		remote_transactions.clear();
+		remote_transaction_error = null;
+
+		return null;
+	}
+
+/*
+ * EndSubtransaction
+ *		Releases the savepoints of the local subtransaction at the given
+ *		level when it commits, and rolls back to them when it aborts.
+ *		If a connection used in an aborted subtransaction has no
+ *		savepoint, its remote transaction can no longer commit.
+ */
+	public static synchronized String
+	EndSubtransaction(int level, boolean commit)
+	{
+		StringWriter 	string_writer;
+		Savepoint 	savepoint;
+
+		for (RemoteTransaction xact : remote_transactions)
+		{
+			if (xact.savepoints.size() < level - 1)
+			{
+				continue;
+			}
+
+			savepoint = xact.savepoints.get(level - 2);
+			try
+			{
+				if (!commit && savepoint == null)
+				{
+					throw new SQLException("the remote server has no savepoints, so the work of an aborted subtransaction could not be undone");
+				}
+
+				if (!commit)
+				{
+					xact.conn.rollback(savepoint);
+				}
+
+				if (savepoint != null)
+				{
+					try
+					{
+						xact.conn.releaseSavepoint(savepoint);
+					}
+					catch (SQLFeatureNotSupportedException release_exception)
+					{
+						/* The savepoint goes with the transaction. */
+					}
+				}
+			}
+			catch (Throwable savepoint_exception)
+			{
+				/* A failed release aborts the subtransaction, which
+				 * calls this again to roll back to the savepoints. */
+				if (commit)
+				{
+					string_writer = new StringWriter();
+					savepoint_exception.printStackTrace(new PrintWriter(string_writer));
+					return string_writer.toString();
+				}
+
+				if (remote_transaction_error == null)
+				{
+					remote_transaction_error = savepoint_exception.toString();
+				}
+			}
+
+			while (xact.savepoints.size() > level - 2)
+			{
+				xact.savepoints.remove(xact.savepoints.size() - 1);
+			}
+		}
+
+		return null;
+	}
+
+/*
+ * TakeIdleConnection
+ *		Returns an open idle connection for the given key, or null.
+ */
+	private static synchronized Connection
+	TakeIdleConnection(String key)
+	{
+		LinkedList<Connection> 	connections = idle_connections.get(key);
+		Connection 		idle_conn;
+
+		while (connections != null && !connections.isEmpty())
+		{
+			idle_conn = connections.removeFirst();
+			try
+			{
+				if (!idle_conn.isClosed())
+				{
+					return idle_conn;
+				}
+			}
+			catch (SQLException isclosed_exception)
+			{
+				DiscardConnection(idle_conn);
+			}
+		}
+
+		return null;
+	}
+
+/*
+ * ReleaseConnection
+ *		Keeps a connection that is no longer used by a scan for reuse,
+ *		or closes it if enough connections are idle already.
+ */
+	private static synchronized void
+	ReleaseConnection(String key, Connection released_conn)
+	{
+		LinkedList<Connection> 	connections = idle_connections.get(key);
+
+		/* A streaming scan may have left a read transaction open. */
+		try
+		{
+			if (!released_conn.getAutoCommit())
+			{
+				released_conn.rollback();
+			}
+		}
+		catch (SQLException rollback_exception)
+		{
+			DiscardConnection(released_conn);
+			return;
+		}
+
+		if (connections == null)
+		{
+			connections = new LinkedList<Connection>();
+			idle_connections.put(key, connections);
+		}
+
+		if (connections.size() < MAX_IDLE_CONNECTIONS)
+		{
+			connections.addFirst(released_conn);
+		}
+		else
+		{
+			DiscardConnection(released_conn);
+		}
+	}
+
+/*
+ * PrepareCachedStatement
+ *		Returns a statement for query on conn, prepared by an earlier
+ *		scan if possible.  Past MAX_CACHED_STATEMENTS statements per
+ *		connection, the least recently used one is closed.
+ */
+	private static synchronized PreparedStatement
+	PrepareCachedStatement(Connection statement_conn, String statement_query) throws SQLException
+	{
+		LinkedHashMap<String, PreparedStatement> 	cache = statement_caches.get(statement_conn);
+		PreparedStatement 				statement;
+
+		if (cache == null)
+		{
+			cache = new LinkedHashMap<String, PreparedStatement>(16, 0.75f, true)
+			{
+				protected boolean removeEldestEntry(Map.Entry<String, PreparedStatement> eldest)
+				{
+					if (size() <= MAX_CACHED_STATEMENTS)
+					{
+						return false;
+					}
+
+					try
+					{
+						eldest.getValue().close();
+					}
+					catch (SQLException evict_exception)
+					{
+						/* The statement is dropped either way. */
+					}
+					return true;
+				}
+			};
+			statement_caches.put(statement_conn, cache);
+		}
+
+		statement = cache.get(statement_query);
+		if (statement != null && !statement.isClosed())
+		{
+			return statement;
+		}
+
+		statement = statement_conn.prepareStatement(statement_query, ResultSet.TYPE_FORWARD_ONLY, ResultSet.CONCUR_READ_ONLY);
+		cache.put(statement_query, statement);
+
+		return statement;
+	}
+
+/*
+ * ForgetCachedStatement
+ *		Removes a statement that is about to be closed from the cache
+ *		of its connection.
+ */
+	private static synchronized void
+	ForgetCachedStatement(Connection statement_conn, Statement statement)
+	{
+		LinkedHashMap<String, PreparedStatement> 	cache = statement_caches.get(statement_conn);
+
+		if (cache != null)
+		{
+			cache.values().remove(statement);
+		}
+	}
+
+/*
+ * DiscardConnection
+ *		Closes a connection, ignoring any error.
+ */
+	private static void
+	DiscardConnection(Connection discarded_conn)
+	{
+		synchronized (JDBCUtils.class)
+		{
+			statement_caches.remove(discarded_conn);
+		}
+
+		try
+		{
+			discarded_conn.close();
+		}
+		catch (Throwable discard_exception)
+		{
+			/* The connection is unusable either way. */
+		}
+	}
 }
@@ -0,0 +1,22 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for jdbc
+ *
+ * Copyright (c) 2012, PostgreSQL Global Development Group
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * Author: Atri Sharma <atri.jiit@gmail.com>
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/jdbc_fdw--1.0--1.1.sql
+ *
+ *-------------------------------------------------------------------------
+ */
+
+\echo Use "ALTER EXTENSION jdbc_fdw UPDATE TO '1.1'" to load this file. \quit
+
+CREATE FUNCTION jdbc_fdw_invalidate_cache(foreign_table regclass DEFAULT NULL)
+RETURNS bigint
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
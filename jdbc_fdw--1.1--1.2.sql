@@ -0,0 +1,190 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for jdbc
+ *
+ * Copyright (c) 2012, PostgreSQL Global Development Group
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * Author: Atri Sharma <atri.jiit@gmail.com>
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/jdbc_fdw--1.1--1.2.sql
+ *
+ *-------------------------------------------------------------------------
+ */
+
+\echo Use "ALTER EXTENSION jdbc_fdw UPDATE TO '1.2'" to load this file. \quit
+
+CREATE TABLE jdbc_fdw_sync_state (
+    local_table text PRIMARY KEY,
+    foreign_table text NOT NULL,
+    watermark_column name NOT NULL,
+    last_value text,
+    synced_at timestamptz
+);
+
+SELECT pg_catalog.pg_extension_config_dump('jdbc_fdw_sync_state', '');
+
+/*
+ * jdbc_fdw_sync
+ *		Brings local_table up to date with the rows of foreign_table whose
+ *		watermark column is above the value seen by the previous call,
+ *		which the remote server filters on.  The rows are upserted on the
+ *		primary key of local_table, or deleted when tombstone_column is
+ *		true (or not null, for a column that is not a boolean).  Returns
+ *		the number of rows applied.
+ */
+CREATE FUNCTION jdbc_fdw_sync(local_table regclass, foreign_table regclass,
+                              watermark_column name, tombstone_column name DEFAULT NULL)
+RETURNS bigint
+LANGUAGE plpgsql
+SET datestyle = 'ISO, YMD'
+AS $$
+DECLARE
+    state_table text;
+    local_name text;
+    foreign_name text;
+    watermark_type text;
+    tombstone_test text;
+    key_columns text;
+    key_join text;
+    columns text;
+    updates text;
+    last_value text;
+    new_value text;
+    applied bigint;
+BEGIN
+    SELECT format('%I.jdbc_fdw_sync_state', n.nspname) INTO state_table
+      FROM pg_catalog.pg_extension e
+      JOIN pg_catalog.pg_namespace n ON n.oid = e.extnamespace
+     WHERE e.extname = 'jdbc_fdw';
+
+    SELECT format('%I.%I', n.nspname, c.relname) INTO local_name
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+     WHERE c.oid = local_table;
+
+    SELECT format('%I.%I', n.nspname, c.relname) INTO foreign_name
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+     WHERE c.oid = foreign_table;
+
+    SELECT pg_catalog.format_type(a.atttypid, a.atttypmod) INTO watermark_type
+      FROM pg_catalog.pg_attribute a
+     WHERE a.attrelid = foreign_table AND a.attname = watermark_column
+       AND a.attnum > 0 AND NOT a.attisdropped;
+
+    IF watermark_type IS NULL THEN
+        RAISE EXCEPTION 'column "%" of relation % does not exist', watermark_column, foreign_table;
+    END IF;
+
+    IF tombstone_column IS NOT NULL THEN
+        SELECT CASE WHEN a.atttypid = 'pg_catalog.bool'::regtype
+                    THEN format('c.%I IS TRUE', tombstone_column)
+                    ELSE format('c.%I IS NOT NULL', tombstone_column) END
+          INTO tombstone_test
+          FROM pg_catalog.pg_attribute a
+         WHERE a.attrelid = foreign_table AND a.attname = tombstone_column
+           AND a.attnum > 0 AND NOT a.attisdropped;
+
+        IF tombstone_test IS NULL THEN
+            RAISE EXCEPTION 'column "%" of relation % does not exist', tombstone_column, foreign_table;
+        END IF;
+    ELSE
+        tombstone_test := 'false';
+    END IF;
+
+    /* Columns of the local table that the foreign table also has */
+    SELECT string_agg(format('%I', l.attname), ', ' ORDER BY l.attnum),
+           string_agg(format('%1$I = EXCLUDED.%1$I', l.attname), ', ' ORDER BY l.attnum)
+             FILTER (WHERE l.attnum <> ALL (i.indkey::int2[]))
+      INTO columns, updates
+      FROM pg_catalog.pg_attribute l
+      JOIN pg_catalog.pg_attribute f
+        ON f.attrelid = foreign_table AND f.attname = l.attname
+       AND f.attnum > 0 AND NOT f.attisdropped
+      LEFT JOIN pg_catalog.pg_index i
+        ON i.indrelid = local_table AND i.indisprimary
+     WHERE l.attrelid = local_table AND l.attnum > 0 AND NOT l.attisdropped
+       AND (tombstone_column IS NULL OR l.attname <> tombstone_column);
+
+    SELECT string_agg(format('%I', a.attname), ', ' ORDER BY k.n),
+           string_agg(format('l.%1$I = c.%1$I', a.attname), ' AND ' ORDER BY k.n)
+      INTO key_columns, key_join
+      FROM pg_catalog.pg_index i
+     CROSS JOIN LATERAL unnest(i.indkey::int2[]) WITH ORDINALITY AS k(attnum, n)
+      JOIN pg_catalog.pg_attribute a
+        ON a.attrelid = i.indrelid AND a.attnum = k.attnum
+     WHERE i.indrelid = local_table AND i.indisprimary;
+
+    IF key_columns IS NULL THEN
+        RAISE EXCEPTION 'relation % has no primary key', local_table;
+    END IF;
+
+    IF EXISTS (SELECT 1
+                 FROM pg_catalog.pg_index i
+                 JOIN pg_catalog.pg_attribute a
+                   ON a.attrelid = i.indrelid AND a.attnum = ANY (i.indkey::int2[])
+                WHERE i.indrelid = local_table AND i.indisprimary
+                  AND NOT EXISTS (SELECT 1
+                                    FROM pg_catalog.pg_attribute f
+                                   WHERE f.attrelid = foreign_table AND f.attname = a.attname
+                                     AND f.attnum > 0 AND NOT f.attisdropped)) THEN
+        RAISE EXCEPTION 'primary key of relation % is not in relation %', local_table, foreign_table;
+    END IF;
+
+    /* Keep two calls from applying the same rows */
+    EXECUTE format('LOCK TABLE %s IN SHARE ROW EXCLUSIVE MODE', local_name);
+
+    EXECUTE format('SELECT s.last_value FROM %s s
+                     WHERE s.local_table = $1 AND s.foreign_table = $2 AND s.watermark_column = $3
+                       FOR UPDATE', state_table)
+       INTO last_value
+      USING local_name, foreign_name, watermark_column;
+
+    /*
+     * The last value is written as a constant of the column type, so the
+     * condition on the watermark is sent to the remote server.  A key
+     * changed several times only keeps its latest row.
+     */
+    EXECUTE format('WITH changed AS (
+                        SELECT DISTINCT ON (%3$s) %4$s, %5$I AS jdbc_fdw_watermark,
+                               %6$s AS jdbc_fdw_tombstone
+                          FROM (SELECT * FROM %2$s %7$s) c
+                         ORDER BY %3$s, %5$I DESC
+                    ),
+                    upserted AS (
+                        INSERT INTO %1$s (%4$s)
+                        SELECT %4$s FROM changed WHERE NOT jdbc_fdw_tombstone
+                            ON CONFLICT (%3$s) DO %8$s
+                        RETURNING 1
+                    ),
+                    deleted AS (
+                        DELETE FROM %1$s l USING changed c
+                         WHERE c.jdbc_fdw_tombstone AND %9$s
+                        RETURNING 1
+                    )
+                    SELECT (SELECT max(jdbc_fdw_watermark)::text FROM changed),
+                           (SELECT count(*) FROM upserted) + (SELECT count(*) FROM deleted)',
+                   local_name, foreign_name, key_columns, columns, watermark_column,
+                   tombstone_test,
+                   CASE WHEN last_value IS NULL THEN ''
+                        ELSE format('WHERE %I > %L::%s', watermark_column, last_value, watermark_type) END,
+                   CASE WHEN updates IS NULL THEN 'NOTHING'
+                        ELSE 'UPDATE SET ' || updates END,
+                   key_join)
+       INTO new_value, applied;
+
+    EXECUTE format('INSERT INTO %s AS s (local_table, foreign_table, watermark_column, last_value, synced_at)
+                    VALUES ($1, $2, $3, $4, now())
+                        ON CONFLICT (local_table) DO UPDATE
+                       SET foreign_table = EXCLUDED.foreign_table,
+                           watermark_column = EXCLUDED.watermark_column,
+                           last_value = EXCLUDED.last_value,
+                           synced_at = EXCLUDED.synced_at', state_table)
+      USING local_name, foreign_name, watermark_column, coalesce(new_value, last_value);
+
+    RETURN applied;
+END;
+$$;
@@ -16,37 +16,124 @@
 
 #include "postgres.h"
 
+#include <ctype.h>
+#include <math.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <libpq/pqsignal.h>
 #include "funcapi.h"
 #include "access/reloptions.h"
+#include "access/sysattr.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "catalog/pg_attribute.h"
+#include "catalog/pg_collation.h"
 #include "catalog/pg_foreign_server.h"
 #include "catalog/pg_foreign_table.h"
 #include "catalog/pg_user_mapping.h"
 #include "catalog/pg_type.h"
 #include "commands/defrem.h"
 #include "commands/explain.h"
+#include "executor/executor.h"
 #include "foreign/fdwapi.h"
 #include "foreign/foreign.h"
 #include "miscadmin.h"
 #include "mb/pg_wchar.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
 #include "optimizer/cost.h"
 #include "storage/fd.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/datetime.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+#include "utils/tuplestore.h"
 #include "storage/ipc.h"
 
 #if (PG_VERSION_NUM >= 90200)
 #include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
 #include "optimizer/restrictinfo.h"
 #include "optimizer/planmain.h"
+#if PG_VERSION_NUM >= 120000
+#include "optimizer/optimizer.h"
+#else
+#include "optimizer/clauses.h"
+#include "optimizer/var.h"
+#endif
+#endif
+
+#if PG_VERSION_NUM >= 120000
+#include "access/htup_details.h"
+#include "access/table.h"
+#include "lib/ilist.h"
+#include "nodes/extensible.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/datum.h"
+#include "utils/dsa.h"
+#include "utils/guc.h"
+#if PG_VERSION_NUM >= 130000
+#include "common/hashfn.h"
+#else
+#include "utils/hashutils.h"
+#endif
+#else
+#include "access/heapam.h"
+#define table_open(relid, lockmode) heap_open(relid, lockmode)
+#define table_close(rel, lockmode) heap_close(rel, lockmode)
+#endif
+
+#if PG_VERSION_NUM >= 90600 && PG_VERSION_NUM < 140000
+#include "parser/parsetree.h"
+#endif
+#if PG_VERSION_NUM >= 140000
+#include "optimizer/appendinfo.h"
+#endif
+#if PG_VERSION_NUM >= 160000
+#include "optimizer/inherit.h"
 #endif
 
 #include "jni.h"
 
+#if PG_VERSION_NUM < 100000
+#define TupleDescAttr(tupdesc, i) ((tupdesc)->attrs[(i)])
+#endif
+
+#if PG_VERSION_NUM >= 90600
+#include "access/stratnum.h"
+#endif
+
+/*
+ * Objects with OIDs below this limit are built into PostgreSQL, so their
+ * behaviour is known.
+ */
+#if PG_VERSION_NUM >= 120000
+#define JDBC_BUILTIN_OID_LIMIT	FirstGenbkiObjectId
+#else
+#define JDBC_BUILTIN_OID_LIMIT	FirstBootstrapObjectId
+#endif
+
+/*
+ * Whether a pathkey sorts in descending order, and the pathkey of an
+ * ascending sort.
+ */
+#if PG_VERSION_NUM >= 180000
+#define JDBC_PATHKEY_IS_DESC(pathkey)	((pathkey)->pk_cmptype == COMPARE_GT)
+#define JDBC_PATHKEY_ASC		COMPARE_LT
+#else
+#define JDBC_PATHKEY_IS_DESC(pathkey)	((pathkey)->pk_strategy == BTGreaterStrategyNumber)
+#define JDBC_PATHKEY_ASC		BTLessStrategyNumber
+#endif
+
 #define Str(arg) #arg
 #define StrValue(arg) Str(arg)
 #define STR_PKGLIBDIR StrValue(PKG_LIB_DIR)
@@ -56,7 +143,15 @@ PG_MODULE_MAGIC;
 
 static JNIEnv *env;
 static JavaVM *jvm;
-static bool InterruptFlag;   /* Used for checking for SIGINT interrupt */
+static volatile bool InterruptFlag;   /* Used for checking for SIGINT interrupt */
+
+/*
+ * Whether a remote transaction was opened in the current local
+ * transaction, and whether the callbacks ending remote transactions
+ * are registered.
+ */
+static bool RemoteXactOpened = false;
+static bool XactCallbacksRegistered = false;
 
 
 /*
@@ -81,15 +176,192 @@ static struct jdbcFdwOption valid_options[] =
 	{ "querytimeout",	ForeignServerRelationId },
 	{ "jarfile",		ForeignServerRelationId },
 	{ "maxheapsize",	ForeignServerRelationId },
+	{ "streaming_profile",	ForeignServerRelationId },
+	{ "isolation_level",	ForeignServerRelationId },
 	{ "username",		UserMappingRelationId },
 	{ "password",		UserMappingRelationId },
 	{ "query",		ForeignTableRelationId },
 	{ "table",		ForeignTableRelationId },
 
+	/* Transfer options, which may be set on the server or the table */
+	{ "transfer_mode",	ForeignServerRelationId },
+	{ "transfer_mode",	ForeignTableRelationId },
+	{ "fetch_size",		ForeignServerRelationId },
+	{ "fetch_size",		ForeignTableRelationId },
+	{ "lookup_batch_size",	ForeignServerRelationId },
+	{ "lookup_batch_size",	ForeignTableRelationId },
+	{ "page_size",		ForeignServerRelationId },
+	{ "page_size",		ForeignTableRelationId },
+	{ "page_key",		ForeignTableRelationId },
+	{ "cache_ttl",		ForeignTableRelationId },
+	{ "batch_size",		ForeignServerRelationId },
+	{ "batch_size",		ForeignTableRelationId },
+	{ "bulk_load",		ForeignServerRelationId },
+	{ "bulk_load",		ForeignTableRelationId },
+	{ "use_remote_indexes",	ForeignServerRelationId },
+	{ "use_remote_indexes",	ForeignTableRelationId },
+
+	/* Column options */
+	{ "column_name",	AttributeRelationId },
+	{ "key",		AttributeRelationId },
+
 	/* Sentinel */
 	{ NULL,			InvalidOid }
 };
 
+/*
+ * Default number of rows transferred from the JVM in one batch when
+ * transfer_mode is 'buffer'.
+ */
+#define DEFAULT_FETCH_SIZE	100
+
+/*
+ * Default number of rows sent to the remote server in one JDBC batch by
+ * INSERT.
+ */
+#define DEFAULT_BATCH_SIZE	1000
+
+/*
+ * Number of elements of the String array passed to JDBCUtils.Initialize.
+ */
+#define NUM_INITIALIZE_OPTIONS	18
+
+/*
+ * Planner estimates: the cost of starting a remote query and of
+ * transferring one row, and the row count assumed for a remote table
+ * without statistics.
+ */
+#define DEFAULT_FDW_STARTUP_COST	100.0
+#define DEFAULT_FDW_TUPLE_COST		0.01
+#define DEFAULT_FDW_ROWS		1000
+
+/*
+ * Buffer size for printing an int as a decimal string.
+ */
+#define MAX_INT32_STRLEN	12
+
+/*
+ * Options of a jdbc_fdw foreign table, collected from the table, its
+ * server and the user mapping.
+ */
+typedef struct jdbcFdwOptions
+{
+	char		*drivername;
+	char		*url;
+	int		querytimeout;
+	char		*jarfile;
+	int		maxheapsize;
+	char		*username;
+	char		*password;
+	char		*query;
+	char		*table;
+	bool		use_buffer;	/* transfer_mode 'buffer' */
+	int		fetch_size;
+	int		lookup_batch_size; /* keys per batched lookup, 0 if off */
+	char		*streaming_profile; /* driver settings for streaming results */
+	int		page_size;	/* rows per keyset page, 0 if off */
+	char		*page_key;	/* remote column ordering the pages */
+	int		batch_size;	/* rows per JDBC batch of modifications */
+	bool		bulk_load;	/* COPY through the driver's bulk API */
+	bool		use_remote_indexes; /* cost with the remote indexes */
+	char		*isolation_level; /* of remote transactions, or autocommit */
+	int		cache_ttl;	/* seconds scans stay in the result cache */
+} jdbcFdwOptions;
+
+/*
+ * Entry of the per-backend cache of foreign table options, keyed by the
+ * foreign table and the user whose mapping applies.  The options are
+ * kept in cxt, and the entry is rebuilt once an invalidation of the
+ * table, server or user mapping catalogs marks it not valid.  The remote
+ * indexes and primary key are read into cxt when first needed.
+ */
+typedef struct jdbcOptionsCacheKey
+{
+	Oid		foreigntableid;
+	Oid		userid;
+} jdbcOptionsCacheKey;
+
+typedef struct jdbcOptionsCacheEntry
+{
+	jdbcOptionsCacheKey key;	/* hash key (must be first) */
+	bool		valid;
+	MemoryContext	cxt;
+	jdbcFdwOptions	opts;
+	bool		indexes_loaded;	/* indexes was read */
+	bool		indexes_known;	/* the driver described the indexes */
+	List		*indexes;	/* Lists of remote column names */
+	bool		pkey_loaded;	/* pkey was read */
+	List		*pkey;		/* remote primary key column names */
+} jdbcOptionsCacheEntry;
+
+static HTAB *OptionsCache = NULL;
+
+/*
+ * What a remote database accepts in the SQL sent to it, asked once per
+ * backend for each server and kept in DialectCache until the server
+ * changes.
+ */
+typedef struct jdbcDialect
+{
+	bool		known;		/* the remote server described itself */
+	char		product[NAMEDATALEN];	/* database product name */
+	char		version[NAMEDATALEN];	/* and version */
+	char		null_order;	/* where NULLs sort: 'h'igh, 'l'ow, at
+					 * the 's'tart or 'e'nd, or '\0' */
+	bool		nulls_clause;	/* ORDER BY accepts NULLS FIRST/LAST */
+	char		quote[8];	/* quotes identifiers, "" if nothing does */
+} jdbcDialect;
+
+typedef struct jdbcDialectCacheEntry
+{
+	Oid		serverid;	/* hash key (must be first) */
+	bool		valid;
+	jdbcDialect	dialect;
+} jdbcDialectCacheEntry;
+
+static HTAB *DialectCache = NULL;
+
+/*
+ * Indexes of the items of ForeignScan.fdw_private.
+ */
+enum FdwScanPrivateIndex
+{
+	/* Integer list of the attribute numbers the query references */
+	FdwScanPrivateRetrievedAttrs,
+	/* String with the quals JDBCUtils evaluates before returning a row */
+	FdwScanPrivateJavaFilter,
+	/* Integer bound on the rows the scan will read, or 0 if unknown */
+	FdwScanPrivateMaxRows,
+	/* String with the query sent to the remote server */
+	FdwScanPrivateSelectSql
+};
+
+/*
+ * Planner information of a jdbc_fdw foreign table, kept in
+ * RelOptInfo.fdw_private.
+ */
+typedef struct jdbcFdwRelationInfo
+{
+	jdbcFdwOptions	opts;
+	jdbcDialect	dialect;	/* of the server, read for sorted paths */
+	bool		indexes_known;	/* remote_indexes describes the indexes */
+	List		*remote_indexes; /* attribute number Lists of the leading
+					  * columns of each remote index */
+} jdbcFdwRelationInfo;
+
+/*
+ * Dictionary of a dictionary encoded result column in 'buffer' transfer
+ * mode.  The JVM sends each distinct value once; values[code] caches the
+ * converted Datum for all rows carrying that code.
+ */
+typedef struct jdbcColumnDictionary
+{
+	bool		active;		/* column is dictionary encoded in this batch */
+	int		count;		/* number of entries in values */
+	int		allocated;	/* allocated length of values */
+	Datum		*values;
+} jdbcColumnDictionary;
+
 /*
  * FDW-specific information for ForeignScanState.fdw_state.
  */
@@ -100,16 +372,102 @@ typedef struct jdbcFdwExecutionState
 	int		NumberOfRows;
 	jobject 	java_call;
 	int 		NumberOfColumns;
+	bool		use_buffer;	/* rows arrive in a direct ByteBuffer */
+	AttInMetadata	*attinmeta;	/* input functions of the result columns */
+	char		*batch_ptr;	/* read position in the current batch */
+	int		batch_rows_left; /* rows of the current batch not yet read */
+	jdbcColumnDictionary *dictionaries; /* one per result column */
+	MemoryContext	dictionary_cxt;	/* holds the dictionary Datums */
+	bool		query_started;	/* query executed since Begin or ReScan */
+	int		numParams;	/* number of query parameters */
+	List		*param_exprs;	/* ExprStates computing the parameters */
+	Oid		*param_typids;	/* types of the parameters */
+	FmgrInfo	*param_flinfo;	/* output functions of the parameters */
+	Tuplestorestate	*tuplestore;	/* rows read so far, for rescans, or NULL */
+	TupleTableSlot	*replay_slot;	/* (12+) reads rows back from tuplestore */
+	bool		remote_done;	/* all remote rows are in tuplestore */
+	jdbcFdwOptions	opts;		/* what connecting needs */
+	char		*retrievedattrsstr;
+	char		*javafilterstr;
+	int		maxrows;
+	bool		modify;
+	struct jdbcResultCacheScan *cache; /* (12+) result cache use, or NULL */
 } jdbcFdwExecutionState;
 
+/*
+ * Indexes of the items of the fdw_private list of a foreign table
+ * modification.
+ */
+enum FdwModifyPrivateIndex
+{
+	/* String with the INSERT, UPDATE or DELETE statement */
+	FdwModifyPrivateUpdateSql,
+	/* Integer list of the attribute numbers whose new values are bound */
+	FdwModifyPrivateTargetAttnums,
+	/* Integer list of the attribute numbers of the key bound in WHERE */
+	FdwModifyPrivateKeyAttnums
+};
+
+/*
+ * Indexes of the items of the fdw_private list of a ForeignScan that
+ * modifies the remote table directly.
+ */
+enum FdwDirectModifyPrivateIndex
+{
+	/* String with the UPDATE or DELETE statement */
+	FdwDirectModifyPrivateUpdateSql,
+	/* Integer, 1 if the affected rows count towards es_processed */
+	FdwDirectModifyPrivateSetProcessed
+};
+
+/*
+ * Context of jdbcDeparseRemoteExpr: the expressions it binds to "?" are
+ * appended to params.
+ */
+typedef struct jdbcRemoteExprContext
+{
+	Index		relid;		/* range table index of the target */
+	Oid		foreigntableid;	/* foreign table of the target */
+	StringInfo	buf;		/* output buffer */
+	List		*params;	/* expressions computed locally */
+} jdbcRemoteExprContext;
+
+/*
+ * FDW-specific information for ResultRelInfo.ri_FdwState.  Rows are
+ * bound to the prepared statement and sent in JDBC batches.
+ */
+typedef struct jdbcFdwModifyState
+{
+	jdbcFdwExecutionState *festate;	/* connection and prepared statement */
+	Relation	rel;		/* the foreign table */
+	CmdType		operation;	/* INSERT, UPDATE or DELETE */
+	List		*target_attrs;	/* attribute numbers of new values bound */
+	int		num_target;	/* length of target_attrs */
+	AttrNumber	*key_junk_attnos;	/* junk columns of the old key values */
+	int		numParams;	/* number of bound values, keys last */
+	const char	**param_types;	/* JDBCUtils binding of each attribute */
+	Oid		*param_typids;	/* types of the bound attributes */
+	FmgrInfo	*param_flinfo;	/* output functions of the attributes */
+	int		batch_size;	/* rows per JDBC batch */
+	int		num_pending;	/* rows added but not sent yet */
+	bool		bulk_load;	/* rows go through the driver's bulk API */
+	MemoryContext	temp_cxt;	/* per-row working memory */
+} jdbcFdwModifyState;
+
 /*
  * SQL functions
  */
 extern Datum jdbc_fdw_handler(PG_FUNCTION_ARGS);
 extern Datum jdbc_fdw_validator(PG_FUNCTION_ARGS);
+extern Datum jdbc_fdw_invalidate_cache(PG_FUNCTION_ARGS);
 
 PG_FUNCTION_INFO_V1(jdbc_fdw_handler);
 PG_FUNCTION_INFO_V1(jdbc_fdw_validator);
+PG_FUNCTION_INFO_V1(jdbc_fdw_invalidate_cache);
+
+#if PG_VERSION_NUM >= 120000
+void _PG_init(void);
+#endif
 
 /*
  * FDW callback routines
@@ -145,22 +503,176 @@ static TupleTableSlot *jdbcIterateForeignScan(ForeignScanState *node);
 static void jdbcReScanForeignScan(ForeignScanState *node);
 static void jdbcEndForeignScan(ForeignScanState *node);
 
+#if (PG_VERSION_NUM >= 90300)
+static int jdbcIsForeignRelUpdatable(Relation rel);
+#if (PG_VERSION_NUM >= 140000)
+static void jdbcAddForeignUpdateTargets(PlannerInfo *root, Index rtindex,
+					RangeTblEntry *target_rte, Relation target_relation);
+#else
+static void jdbcAddForeignUpdateTargets(Query *parsetree, RangeTblEntry *target_rte,
+					Relation target_relation);
+#endif
+static List *jdbcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+				   int subplan_index);
+static void jdbcBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinfo,
+				   List *fdw_private, int subplan_index, int eflags);
+static TupleTableSlot *jdbcExecForeignInsert(EState *estate, ResultRelInfo *rinfo,
+					     TupleTableSlot *slot, TupleTableSlot *planSlot);
+static TupleTableSlot *jdbcExecForeignUpdate(EState *estate, ResultRelInfo *rinfo,
+					     TupleTableSlot *slot, TupleTableSlot *planSlot);
+static TupleTableSlot *jdbcExecForeignDelete(EState *estate, ResultRelInfo *rinfo,
+					     TupleTableSlot *slot, TupleTableSlot *planSlot);
+static void jdbcEndForeignModify(EState *estate, ResultRelInfo *rinfo);
+#endif
+#if (PG_VERSION_NUM >= 90500)
+static List *jdbcImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid);
+#endif
+#if (PG_VERSION_NUM >= 90600)
+static bool jdbcPlanDirectModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+				 int subplan_index);
+static void jdbcBeginDirectModify(ForeignScanState *node, int eflags);
+static TupleTableSlot *jdbcIterateDirectModify(ForeignScanState *node);
+static void jdbcEndDirectModify(ForeignScanState *node);
+static void jdbcExplainDirectModify(ForeignScanState *node, ExplainState *es);
+#endif
+#if (PG_VERSION_NUM >= 110000)
+static void jdbcBeginForeignInsert(ModifyTableState *mtstate, ResultRelInfo *rinfo);
+static void jdbcEndForeignInsert(EState *estate, ResultRelInfo *rinfo);
+#endif
+#if (PG_VERSION_NUM >= 140000)
+static int jdbcGetForeignModifyBatchSize(ResultRelInfo *rinfo);
+static TupleTableSlot **jdbcExecForeignBatchInsert(EState *estate, ResultRelInfo *rinfo,
+						   TupleTableSlot **slots, TupleTableSlot **planSlots,
+						   int *numSlots);
+static void jdbcExecForeignTruncate(List *rels, DropBehavior behavior, bool restart_seqs);
+#endif
+
 /*
  * Helper functions
  */
 static bool jdbcIsValidOption(const char *option, Oid context);
-static void jdbcGetOptions(
-    Oid foreigntableid, 
-    char **drivername, 
-    char **url, 
-    int *querytimeout, 
-    char **jarfile, 
-    int* maxheapsize, 
-    char **username, 
-    char **password, 
-    char **query, 
-    char **table
-);
+static void jdbcGetOptions(Oid foreigntableid, jdbcFdwOptions *opts);
+static jdbcOptionsCacheEntry *jdbcGetOptionsCacheEntry(Oid foreigntableid);
+static void jdbcParseOptions(Oid foreigntableid, Oid serverid, jdbcFdwOptions *opts);
+static void jdbcCopyOptions(jdbcFdwOptions *dest, jdbcFdwOptions *src);
+#if PG_VERSION_NUM >= 90200
+static void jdbcInvalidateOptionsCache(Datum arg, int cacheid, uint32 hashvalue);
+#else
+static void jdbcInvalidateOptionsCache(Datum arg, int cacheid, ItemPointer tuplePtr);
+#endif
+static jdbcFdwExecutionState *jdbcCreateExecutionState(jdbcFdwOptions *opts, TupleDesc tupdesc, char *query,
+						       char *retrievedattrsstr, char *javafilterstr,
+						       int maxrows, int numParams, bool modify);
+static jdbcFdwExecutionState *jdbcNewExecutionState(jdbcFdwOptions *opts, TupleDesc tupdesc, char *query,
+						    char *retrievedattrsstr, char *javafilterstr,
+						    int maxrows, int numParams, bool modify);
+static void jdbcConnectExecutionState(jdbcFdwExecutionState *festate);
+#if PG_VERSION_NUM >= 120000
+static void jdbcDefineResultCache(void);
+static bool jdbcResultCacheBegin(jdbcFdwExecutionState *festate, Oid relid, TupleDesc tupdesc, int ttl);
+static bool jdbcResultCacheLookup(jdbcFdwExecutionState *festate, const char **types, char **values);
+static void jdbcResultCacheFetchRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc,
+				    TupleTableSlot *slot);
+static void jdbcResultCacheNoteWrite(Oid relid);
+#endif
+static jobjectArray jdbcNewStringArray(int n, const char **strings);
+static const char *jdbcIsolationLevel(jdbcFdwOptions *opts);
+static void jdbcXactCallback(XactEvent event, void *arg);
+static void jdbcSubXactCallback(SubXactEvent event, SubTransactionId mySubid,
+				SubTransactionId parentSubid, void *arg);
+static void jdbcCallTransactionMethod(const char *method, const char *signature,
+				      jvalue *args, int elevel);
+#if (PG_VERSION_NUM >= 90300)
+static char *jdbcDeparseInsertSql(Relation rel, jdbcFdwOptions *opts, List **target_attrs);
+static char *jdbcDeparseUpdateSql(Relation rel, jdbcFdwOptions *opts, List *target_attrs,
+				  List *key_attrs);
+static char *jdbcDeparseDeleteSql(Relation rel, jdbcFdwOptions *opts, List *key_attrs);
+static void jdbcDeparseKeyCondition(StringInfo buf, Relation rel, List *key_attrs);
+static List *jdbcGetKeyAttrs(Relation rel, jdbcFdwOptions *opts, bool missing_ok);
+static List *jdbcGetRemoteKeyAttrs(Relation rel, jdbcFdwOptions *opts, bool missing_ok);
+static void jdbcKeyJunkName(char *name, AttrNumber attnum);
+static char *jdbcUnquoteName(const char *name, const char *quote);
+static AttrNumber jdbcRemoteColumnAttno(Relation rel, const char *column);
+static List *jdbcUpdatedAttrs(PlannerInfo *root, Index resultRelation, Relation rel);
+static jdbcFdwModifyState *jdbcCreateModifyState(Relation rel, CmdType operation, char *query,
+						 List *target_attrs, List *key_attrs, Plan *subplan,
+						 int batch_size);
+static int jdbcModifyBatchSize(ResultRelInfo *rinfo, CmdType operation, int batch_size);
+static void jdbcModifyAddRow(jdbcFdwModifyState *fmstate, TupleTableSlot *slot,
+			     TupleTableSlot *planSlot);
+static void jdbcModifyFlush(jdbcFdwModifyState *fmstate);
+static void jdbcFinishModify(jdbcFdwModifyState *fmstate);
+static void jdbcModifyCallBulkLoad(jdbcFdwModifyState *fmstate, const char *method,
+				   const char *signature, jobject table, jobject columns);
+static const char *jdbcModifyParamType(Oid type);
+#endif
+#if (PG_VERSION_NUM >= 90600)
+static bool jdbcDeparseRemoteQual(Expr *expr, jdbcRemoteExprContext *context);
+static bool jdbcDeparseRemoteExpr(Expr *expr, jdbcRemoteExprContext *context, bool any_type);
+static char jdbcRemoteTypeKind(Oid type);
+static bool jdbcIsRemoteOperator(const char *opname, Oid left_type, Oid right_type);
+#endif
+static void jdbcFetchRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc, TupleTableSlot *slot);
+static void jdbcFetchBufferRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc, TupleTableSlot *slot);
+static void jdbcCloseExecutionState(jdbcFdwExecutionState **festate);
+static void jdbcFetchBatch(jdbcFdwExecutionState *festate, TupleDesc tupdesc);
+static char *jdbcReadDictionaries(jdbcFdwExecutionState *festate, TupleDesc tupdesc, char *ptr);
+static void jdbcExecuteQuery(ForeignScanState *node);
+static void jdbcStartSpool(jdbcFdwExecutionState *festate, TupleDesc tupdesc);
+static void jdbcRunQuery(jdbcFdwExecutionState *festate, const char **types, char **values);
+static void jdbcPrepareParams(ForeignScanState *node, jdbcFdwExecutionState *festate, List *fdw_exprs);
+static const char *jdbcParamType(Oid type);
+static char *jdbcParamValueString(Datum value, Oid type, FmgrInfo *flinfo);
+#if (PG_VERSION_NUM >= 90200)
+static List *jdbcRetrievedAttrs(RelOptInfo *baserel, List *scan_clauses);
+static ForeignPath *jdbcCreateForeignPath(PlannerInfo *root, RelOptInfo *baserel, double rows,
+					  Cost startup_cost, Cost total_cost, List *pathkeys,
+					  Relids required_outer);
+static void jdbcEstimateCosts(PlannerInfo *root, RelOptInfo *baserel, ParamPathInfo *param_info,
+			      double *rows, Cost *startup_cost, Cost *total_cost);
+static char *jdbcDeparseSelectSql(Oid foreigntableid, jdbcFdwOptions *opts, List *param_vars,
+				  List *param_ops, const char *order_by);
+static char *jdbcColumnName(Oid foreigntableid, AttrNumber attnum);
+#endif
+#if (PG_VERSION_NUM >= 90600)
+static void jdbcAddParamPaths(PlannerInfo *root, RelOptInfo *baserel);
+static bool jdbcEcMemberMatches(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec,
+				EquivalenceMember *em, void *arg);
+static bool jdbcIsParamJoinClause(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr);
+static bool jdbcIsRangeQual(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr,
+			    char **opname);
+static bool jdbcParamClauseParts(RelOptInfo *baserel, RestrictInfo *rinfo, OpExpr **op, Var **column,
+				 Expr **other, bool *commuted);
+static bool jdbcIsPushedQual(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr,
+			     char **opname);
+static bool jdbcGetRemoteIndexes(Oid foreigntableid, List **indexes);
+static Cost jdbcRemoteScanCost(RelOptInfo *baserel, Bitmapset *eq_attrs, Bitmapset *range_attrs,
+			       double retrieved_rows);
+static void jdbcAddSortedPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid);
+static List *jdbcUsefulPathkeys(PlannerInfo *root, RelOptInfo *baserel);
+static Var *jdbcOrderByVar(RelOptInfo *baserel, PathKey *pathkey);
+static char *jdbcDeparseOrderBy(RelOptInfo *baserel, Oid foreigntableid, List *pathkeys);
+static char jdbcNullsOrdering(jdbcDialect *dialect, Relation rel, Var *var, PathKey *pathkey);
+#endif
+static void jdbcGetDialect(Oid foreigntableid, jdbcDialect *dialect);
+#if PG_VERSION_NUM >= 90200
+static void jdbcInvalidateDialectCache(Datum arg, int cacheid, uint32 hashvalue);
+#else
+static void jdbcInvalidateDialectCache(Datum arg, int cacheid, ItemPointer tuplePtr);
+#endif
+static char *jdbcQuoteName(const char *name, const char *quote);
+static char *jdbcRetrievedAttrsString(List *retrieved_attrs);
+#if (PG_VERSION_NUM >= 90200)
+static char *jdbcDeparseJavaFilter(RelOptInfo *baserel, List *scan_clauses);
+static int jdbcGetMaxRows(PlannerInfo *root, RelOptInfo *baserel, List *pathkeys);
+static bool jdbcDeparseJavaFilterClause(Expr *clause, Index relid, StringInfo buf);
+static Var *jdbcJavaFilterVar(Node *node, Index relid);
+static char jdbcJavaFilterKind(Oid type, int32 typmod);
+static bool jdbcJavaFilterCollation(Oid collid);
+static bool jdbcIsJavaSafeString(const char *str);
+static bool jdbcIsPortableRegex(const char *pattern);
+static void jdbcAppendJavaFilterToken(StringInfo buf, const char *token);
+#endif
 
 /*
  * Uses a String object's content to create an instance of C String
@@ -170,6 +682,7 @@ static char* ConvertStringToCString(jobject);
  * JVM Initialization function
  */
 static void JVMInitialization(Oid);
+static void JVMCreate(jdbcFdwOptions *opts);
 /*
  * JVM destroy function
  */
@@ -193,13 +706,28 @@ static void releaseJdbcFdwExecutionState(jdbcFdwExecutionState **);
  */
 static void releaseJdbcFdwExecutionState(jdbcFdwExecutionState **festate)
 {
+	if ((*festate)->tuplestore)
+	{
+		tuplestore_end((*festate)->tuplestore);
+		(*festate)->tuplestore = NULL;
+	}
+#if PG_VERSION_NUM >= 120000
+	if ((*festate)->replay_slot)
+	{
+		ExecDropSingleTupleTableSlot((*festate)->replay_slot);
+		(*festate)->replay_slot = NULL;
+	}
+#endif
 	if ((*festate)->query)
 	{
 		pfree((*festate)->query);
 		(*festate)->query = 0;
 	}
-	(*env)->DeleteGlobalRef(env, (*festate)->java_call);
-	(*festate)->java_call = NULL;
+	if ((*festate)->java_call)
+	{
+		(*env)->DeleteGlobalRef(env, (*festate)->java_call);
+		(*festate)->java_call = NULL;
+	}
 	pfree(*festate);
 	(*festate) = NULL;
 }
@@ -223,7 +751,7 @@ SIGINTInterruptCheckProcess(jdbcFdwExecutionState **festate)
 
 	PG_TRY();
 	{
-		if (festate != NULL)
+		if (festate != NULL && (*festate)->java_call != NULL)
 		{
 			JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
 			if (JDBCUtilsClass == NULL) 
@@ -311,35 +839,33 @@ DestroyJVM()
  */
 static void
 JVMInitialization(Oid foreigntableid)
+{
+	jdbcFdwOptions	opts;
+
+	if (jvm == NULL)
+	{
+		jdbcGetOptions(foreigntableid, &opts);
+		JVMCreate(&opts);
+	}
+}
+
+/*
+ * JVMCreate
+ *		Create the JVM with the options of a foreign table or server,
+ *		unless it exists already.
+ */
+static void
+JVMCreate(jdbcFdwOptions *opts)
 {
 	jint 		res = -5;/* Initializing the value of res so that we can check it later to see whether JVM has been correctly created or not*/
 	JavaVMInitArgs 	vm_args;
-	static bool 	FunctionCallCheck = false;   /* This flag safeguards against multiple calls of JVMInitialization().*/
+	static bool 	FunctionCallCheck = false;   /* This flag safeguards against multiple calls of JVMCreate().*/
 	char 		strpkglibdir[] = STR_PKGLIBDIR;
 	char 		*classpath;
-	char		*svr_drivername = NULL;
-	char 		*svr_url = NULL;
-	char		*svr_username = NULL;
-	char		*svr_password = NULL;
-	char		*svr_query = NULL;
-	char		*svr_table = NULL;
-	char 		*svr_jarfile = NULL;
 	char 		*maxheapsizeoption = NULL;
-	int 		svr_querytimeout = 0;
-	int 		svr_maxheapsize = 0;
-
-	jdbcGetOptions(
-	    foreigntableid, 
-	    &svr_drivername, 
-	    &svr_url, 
-	    &svr_querytimeout, 
-	    &svr_jarfile,
-	    &svr_maxheapsize, 
-	    &svr_username, 
-	    &svr_password, 
-	    &svr_query, 
-	    &svr_table
-	);
+	jclass 		JDBCUtilsClass;
+	jmethodID 	id_setinterruptflag;
+	jobject 	interrupt_flag;
 
 	if (FunctionCallCheck == false)
 	{
@@ -350,10 +876,10 @@ JVMInitialization(Oid foreigntableid)
 		classpath = (char*)palloc(strlen(strpkglibdir) + 19);
 		snprintf(classpath, strlen(strpkglibdir) + 19, "-Djava.class.path=%s", strpkglibdir);
 
-		if (svr_maxheapsize != 0)   /* If the user has given a value for setting the max heap size of the JVM */
+		if (opts->maxheapsize != 0)   /* If the user has given a value for setting the max heap size of the JVM */
 		{
 			maxheapsizeoption = (char*)palloc(sizeof(int) + 6);
-			snprintf(maxheapsizeoption, sizeof(int) + 6, "-Xmx%dm", svr_maxheapsize);
+			snprintf(maxheapsizeoption, sizeof(int) + 6, "-Xmx%dm", opts->maxheapsize);
 			vm_args.nOptions++;
 		}
 
@@ -378,6 +904,31 @@ JVMInitialization(Oid foreigntableid)
 		on_proc_exit(DestroyJVM, 0);
 		FunctionCallCheck = true;
 		pfree(vm_args.options);
+
+		/*
+		 * Let Java see a pending query cancel, so that it stops
+		 * waiting to retry a failed page.
+		 */
+		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+		if (JDBCUtilsClass == NULL)
+		{
+			elog(ERROR, "JDBCUtilsClass is NULL");
+		}
+
+		id_setinterruptflag = (*env)->GetStaticMethodID(env, JDBCUtilsClass, "SetInterruptFlag", "(Ljava/nio/ByteBuffer;)V");
+		if (id_setinterruptflag == NULL)
+		{
+			elog(ERROR, "id_setinterruptflag is NULL");
+		}
+
+		interrupt_flag = (*env)->NewDirectByteBuffer(env, (void *) &InterruptFlag, sizeof(InterruptFlag));
+		if (interrupt_flag == NULL)
+		{
+			elog(ERROR, "interrupt_flag is NULL");
+		}
+
+		(*env)->CallStaticVoidMethod(env, JDBCUtilsClass, id_setinterruptflag, interrupt_flag);
+		(*env)->DeleteLocalRef(env, interrupt_flag);
 	}
 }
 /*
@@ -416,6 +967,40 @@ jdbc_fdw_handler(PG_FUNCTION_ARGS)
 	fdwroutine->ReScanForeignScan = jdbcReScanForeignScan;
 	fdwroutine->EndForeignScan = jdbcEndForeignScan;
 
+	#if (PG_VERSION_NUM >= 90300)
+	fdwroutine->IsForeignRelUpdatable = jdbcIsForeignRelUpdatable;
+	fdwroutine->AddForeignUpdateTargets = jdbcAddForeignUpdateTargets;
+	fdwroutine->PlanForeignModify = jdbcPlanForeignModify;
+	fdwroutine->BeginForeignModify = jdbcBeginForeignModify;
+	fdwroutine->ExecForeignInsert = jdbcExecForeignInsert;
+	fdwroutine->ExecForeignUpdate = jdbcExecForeignUpdate;
+	fdwroutine->ExecForeignDelete = jdbcExecForeignDelete;
+	fdwroutine->EndForeignModify = jdbcEndForeignModify;
+	#endif
+
+	#if (PG_VERSION_NUM >= 90500)
+	fdwroutine->ImportForeignSchema = jdbcImportForeignSchema;
+	#endif
+
+	#if (PG_VERSION_NUM >= 90600)
+	fdwroutine->PlanDirectModify = jdbcPlanDirectModify;
+	fdwroutine->BeginDirectModify = jdbcBeginDirectModify;
+	fdwroutine->IterateDirectModify = jdbcIterateDirectModify;
+	fdwroutine->EndDirectModify = jdbcEndDirectModify;
+	fdwroutine->ExplainDirectModify = jdbcExplainDirectModify;
+	#endif
+
+	#if (PG_VERSION_NUM >= 110000)
+	fdwroutine->BeginForeignInsert = jdbcBeginForeignInsert;
+	fdwroutine->EndForeignInsert = jdbcEndForeignInsert;
+	#endif
+
+	#if (PG_VERSION_NUM >= 140000)
+	fdwroutine->GetForeignModifyBatchSize = jdbcGetForeignModifyBatchSize;
+	fdwroutine->ExecForeignBatchInsert = jdbcExecForeignBatchInsert;
+	fdwroutine->ExecForeignTruncate = jdbcExecForeignTruncate;
+	#endif
+
 	pqsignal(SIGINT, SIGINTInterruptHandler);
 
 	PG_RETURN_POINTER(fdwroutine);
@@ -441,6 +1026,19 @@ jdbc_fdw_validator(PG_FUNCTION_ARGS)
 	char 		*svr_jarfile = NULL;
 	int 		svr_querytimeout = 0;
 	int 		svr_maxheapsize = 0;
+	char		*svr_transfer_mode = NULL;
+	int		svr_fetch_size = 0;
+	char		*svr_column_name = NULL;
+	bool		svr_key = false;
+	bool		svr_lookup_batch_size = false;
+	char		*svr_streaming_profile = NULL;
+	char		*svr_isolation_level = NULL;
+	bool		svr_cache_ttl = false;
+	int		svr_page_size = -1;
+	char		*svr_page_key = NULL;
+	int		svr_batch_size = 0;
+	bool		svr_bulk_load = false;
+	bool		svr_use_remote_indexes = false;
 	ListCell	*cell;
 
 	/*
@@ -577,83 +1175,449 @@ jdbc_fdw_validator(PG_FUNCTION_ARGS)
 
 			svr_table = defGetString(def);
 		}
-	}
+		else if (strcmp(def->defname, "transfer_mode") == 0)
+		{
+			if (svr_transfer_mode)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: transfer_mode (%s)", defGetString(def))
+					));
 
-	if (catalog == ForeignServerRelationId && svr_drivername == NULL)
-	{
-		ereport(ERROR,
-		(errcode(ERRCODE_SYNTAX_ERROR),
-		errmsg("Driver name must be specified")
-		));
-	}
-	
-	if (catalog == ForeignServerRelationId && svr_url == NULL)
-	{
-		ereport(ERROR,
-		(errcode(ERRCODE_SYNTAX_ERROR),
-		errmsg("URL must be specified")
-		));
-	}
+			svr_transfer_mode = defGetString(def);
 
-	if (catalog == ForeignServerRelationId && svr_jarfile == NULL)
-	{
-		ereport(ERROR,
-		(errcode(ERRCODE_SYNTAX_ERROR),
-		errmsg("JAR file must be specified")
-		));
-	}
+			if (strcmp(svr_transfer_mode, "string") != 0 && strcmp(svr_transfer_mode, "buffer") != 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("invalid value for transfer_mode: \"%s\"", svr_transfer_mode),
+					errhint("Valid values are \"string\" and \"buffer\".")
+					));
+		}
+		else if (strcmp(def->defname, "fetch_size") == 0)
+		{
+			if (svr_fetch_size)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: fetch_size (%s)", defGetString(def))
+					));
 
-	if (catalog == ForeignTableRelationId && svr_query == NULL && svr_table == NULL)
-	{
-		ereport(ERROR,
-		(errcode(ERRCODE_SYNTAX_ERROR),
-		errmsg("either a table or a query must be specified")
-		));
-	}
+			svr_fetch_size = atoi(defGetString(def));
 
-	PG_RETURN_VOID();
-}
+			if (svr_fetch_size <= 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("fetch_size requires a positive integer value")
+					));
+		}
+		else if (strcmp(def->defname, "lookup_batch_size") == 0)
+		{
+			if (svr_lookup_batch_size)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: lookup_batch_size (%s)", defGetString(def))
+					));
 
-/*
- * Check if the provided option is one of the valid options.
- * context is the Oid of the catalog holding the object the option is for.
- */
-static bool
-jdbcIsValidOption(const char *option, Oid context)
-{
-	struct jdbcFdwOption 	*opt;
+			svr_lookup_batch_size = true;
 
-	for (opt = valid_options; opt->optname; opt++)
-	{
-		if (context == opt->optcontext && strcmp(opt->optname, option) == 0)
-			return true;
-	}
-	return false;
-}
+			if (atoi(defGetString(def)) < 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("lookup_batch_size requires a non-negative integer value")
+					));
+		}
+		else if (strcmp(def->defname, "streaming_profile") == 0)
+		{
+			if (svr_streaming_profile)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: streaming_profile (%s)", defGetString(def))
+					));
 
-/*
- * Fetch the options for a jdbc_fdw foreign table.
- */
-static void
-jdbcGetOptions(Oid foreigntableid, char **drivername, char **url, int *querytimeout, char **jarfile, int *maxheapsize, char **username, char **password, char **query, char **table)
-{
-	ForeignTable	*f_table;
-	ForeignServer	*f_server;
-	UserMapping	*f_mapping;
-	List		*options;
-	ListCell	*lc;
+			svr_streaming_profile = defGetString(def);
 
-	/*
-	 * Extract options from FDW objects.
-	 */
-	f_table = GetForeignTable(foreigntableid);
-	f_server = GetForeignServer(f_table->serverid);
-	f_mapping = GetUserMapping(GetUserId(), f_table->serverid);
+			if (strcmp(svr_streaming_profile, "auto") != 0 &&
+			    strcmp(svr_streaming_profile, "none") != 0 &&
+			    strcmp(svr_streaming_profile, "generic") != 0 &&
+			    strcmp(svr_streaming_profile, "postgresql") != 0 &&
+			    strcmp(svr_streaming_profile, "mysql") != 0 &&
+			    strcmp(svr_streaming_profile, "sqlserver") != 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("invalid value for streaming_profile: \"%s\"", svr_streaming_profile),
+					errhint("Valid values are \"auto\", \"none\", \"generic\", \"postgresql\", \"mysql\" and \"sqlserver\".")
+					));
+		}
+		else if (strcmp(def->defname, "isolation_level") == 0)
+		{
+			if (svr_isolation_level)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: isolation_level (%s)", defGetString(def))
+					));
 
-	options = NIL;
-	options = list_concat(options, f_table->options);
+			svr_isolation_level = defGetString(def);
+
+			if (strcmp(svr_isolation_level, "auto") != 0 &&
+			    strcmp(svr_isolation_level, "autocommit") != 0 &&
+			    strcmp(svr_isolation_level, "read uncommitted") != 0 &&
+			    strcmp(svr_isolation_level, "read committed") != 0 &&
+			    strcmp(svr_isolation_level, "repeatable read") != 0 &&
+			    strcmp(svr_isolation_level, "serializable") != 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("invalid value for isolation_level: \"%s\"", svr_isolation_level),
+					errhint("Valid values are \"auto\", \"autocommit\", \"read uncommitted\", \"read committed\", \"repeatable read\" and \"serializable\".")
+					));
+		}
+		else if (strcmp(def->defname, "page_size") == 0)
+		{
+			if (svr_page_size >= 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: page_size (%s)", defGetString(def))
+					));
+
+			svr_page_size = atoi(defGetString(def));
+
+			if (svr_page_size < 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("page_size requires a non-negative integer value")
+					));
+		}
+		else if (strcmp(def->defname, "cache_ttl") == 0)
+		{
+			if (svr_cache_ttl)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: cache_ttl (%s)", defGetString(def))
+					));
+
+			svr_cache_ttl = true;
+
+			if (atoi(defGetString(def)) < 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("cache_ttl requires a non-negative integer value")
+					));
+		}
+		else if (strcmp(def->defname, "page_key") == 0)
+		{
+			if (svr_page_key)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: page_key (%s)", defGetString(def))
+					));
+
+			svr_page_key = defGetString(def);
+		}
+		else if (strcmp(def->defname, "batch_size") == 0)
+		{
+			if (svr_batch_size)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: batch_size (%s)", defGetString(def))
+					));
+
+			svr_batch_size = atoi(defGetString(def));
+
+			if (svr_batch_size <= 0)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("batch_size requires a positive integer value")
+					));
+		}
+		else if (strcmp(def->defname, "bulk_load") == 0)
+		{
+			if (svr_bulk_load)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: bulk_load (%s)", defGetString(def))
+					));
+
+			svr_bulk_load = true;
+			(void) defGetBoolean(def);
+		}
+		else if (strcmp(def->defname, "use_remote_indexes") == 0)
+		{
+			if (svr_use_remote_indexes)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: use_remote_indexes (%s)", defGetString(def))
+					));
+
+			svr_use_remote_indexes = true;
+			(void) defGetBoolean(def);
+		}
+		else if (strcmp(def->defname, "column_name") == 0)
+		{
+			if (svr_column_name)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: column_name (%s)", defGetString(def))
+					));
+
+			svr_column_name = defGetString(def);
+		}
+		else if (strcmp(def->defname, "key") == 0)
+		{
+			if (svr_key)
+				ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					errmsg("conflicting or redundant options: key (%s)", defGetString(def))
+					));
+
+			svr_key = true;
+			(void) defGetBoolean(def);
+		}
+	}
+
+	if (catalog == ForeignServerRelationId && svr_drivername == NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("Driver name must be specified")
+		));
+	}
+	
+	if (catalog == ForeignServerRelationId && svr_url == NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("URL must be specified")
+		));
+	}
+
+	if (catalog == ForeignServerRelationId && svr_jarfile == NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("JAR file must be specified")
+		));
+	}
+
+	if (catalog == ForeignTableRelationId && svr_query == NULL && svr_table == NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("either a table or a query must be specified")
+		));
+	}
+
+	if (catalog == ForeignTableRelationId && svr_page_size > 0 && svr_page_key == NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("page_size requires page_key to be specified")
+		));
+	}
+
+	if (catalog == ForeignTableRelationId && svr_page_size == 0 && svr_page_key != NULL)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("page_key requires a positive page_size")
+		));
+	}
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Check if the provided option is one of the valid options.
+ * context is the Oid of the catalog holding the object the option is for.
+ */
+static bool
+jdbcIsValidOption(const char *option, Oid context)
+{
+	struct jdbcFdwOption 	*opt;
+
+	for (opt = valid_options; opt->optname; opt++)
+	{
+		if (context == opt->optcontext && strcmp(opt->optname, option) == 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Fetch the options for a jdbc_fdw foreign table, parsing them only when
+ * they are not in the options cache yet.
+ */
+static void
+jdbcGetOptions(Oid foreigntableid, jdbcFdwOptions *opts)
+{
+	jdbcOptionsCacheKey	key;
+	jdbcOptionsCacheEntry	*entry;
+	bool			found;
+	MemoryContext		oldcontext;
+
+	if (OptionsCache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(jdbcOptionsCacheKey);
+		ctl.entrysize = sizeof(jdbcOptionsCacheEntry);
+		ctl.hash = tag_hash;
+		ctl.hcxt = CacheMemoryContext;
+		OptionsCache = hash_create("jdbc_fdw options", 64, &ctl,
+					   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		CacheRegisterSyscacheCallback(FOREIGNTABLEREL, jdbcInvalidateOptionsCache, (Datum) 0);
+		CacheRegisterSyscacheCallback(FOREIGNSERVEROID, jdbcInvalidateOptionsCache, (Datum) 0);
+		CacheRegisterSyscacheCallback(USERMAPPINGOID, jdbcInvalidateOptionsCache, (Datum) 0);
+	}
+
+	MemSet(&key, 0, sizeof(key));
+	key.foreigntableid = foreigntableid;
+	key.userid = GetUserId();
+
+	entry = (jdbcOptionsCacheEntry *) hash_search(OptionsCache, &key, HASH_ENTER, &found);
+	if (!found)
+	{
+		entry->valid = false;
+		entry->cxt = NULL;
+	}
+
+	if (!entry->valid)
+	{
+		jdbcFdwOptions	parsed;
+
+		jdbcParseOptions(foreigntableid, InvalidOid, &parsed);
+
+		if (entry->cxt != NULL)
+		{
+			MemoryContextDelete(entry->cxt);
+		}
+		entry->cxt = AllocSetContextCreate(CacheMemoryContext,
+						   "jdbc_fdw options",
+						   ALLOCSET_SMALL_MINSIZE,
+						   ALLOCSET_SMALL_INITSIZE,
+						   ALLOCSET_SMALL_MAXSIZE);
+
+		oldcontext = MemoryContextSwitchTo(entry->cxt);
+		jdbcCopyOptions(&entry->opts, &parsed);
+		MemoryContextSwitchTo(oldcontext);
+
+		entry->valid = true;
+		entry->indexes_loaded = false;
+		entry->indexes = NIL;
+		entry->pkey_loaded = false;
+		entry->pkey = NIL;
+	}
+
+	/*
+	 * The caller gets its own copy, which stays valid when the entry is
+	 * rebuilt.
+	 */
+	jdbcCopyOptions(opts, &entry->opts);
+}
+
+/*
+ * jdbcGetOptionsCacheEntry
+ *		The valid options cache entry of a foreign table, which also
+ *		keeps what was read about its remote table.
+ */
+static jdbcOptionsCacheEntry *
+jdbcGetOptionsCacheEntry(Oid foreigntableid)
+{
+	jdbcOptionsCacheKey	key;
+	jdbcOptionsCacheEntry	*entry;
+	jdbcFdwOptions		opts;
+
+	/* Make sure the cache entry is valid */
+	jdbcGetOptions(foreigntableid, &opts);
+
+	MemSet(&key, 0, sizeof(key));
+	key.foreigntableid = foreigntableid;
+	key.userid = GetUserId();
+	entry = (jdbcOptionsCacheEntry *) hash_search(OptionsCache, &key, HASH_FIND, NULL);
+	Assert(entry != NULL && entry->valid);
+
+	return entry;
+}
+
+/*
+ * jdbcCopyOptions
+ *		Copy options into dest, with the strings in the current memory
+ *		context.
+ */
+static void
+jdbcCopyOptions(jdbcFdwOptions *dest, jdbcFdwOptions *src)
+{
+	*dest = *src;
+	dest->drivername = src->drivername ? pstrdup(src->drivername) : NULL;
+	dest->url = src->url ? pstrdup(src->url) : NULL;
+	dest->jarfile = src->jarfile ? pstrdup(src->jarfile) : NULL;
+	dest->username = src->username ? pstrdup(src->username) : NULL;
+	dest->password = src->password ? pstrdup(src->password) : NULL;
+	dest->query = src->query ? pstrdup(src->query) : NULL;
+	dest->table = src->table ? pstrdup(src->table) : NULL;
+	dest->streaming_profile = src->streaming_profile ? pstrdup(src->streaming_profile) : NULL;
+	dest->page_key = src->page_key ? pstrdup(src->page_key) : NULL;
+	dest->isolation_level = src->isolation_level ? pstrdup(src->isolation_level) : NULL;
+}
+
+/*
+ * jdbcInvalidateOptionsCache
+ *		Syscache callback: mark all cached options not valid.  Changes of
+ *		foreign tables, servers and user mappings are rare, so there is
+ *		no point in finding the affected entries.
+ */
+static void
+#if PG_VERSION_NUM >= 90200
+jdbcInvalidateOptionsCache(Datum arg, int cacheid, uint32 hashvalue)
+#else
+jdbcInvalidateOptionsCache(Datum arg, int cacheid, ItemPointer tuplePtr)
+#endif
+{
+	HASH_SEQ_STATUS		scan;
+	jdbcOptionsCacheEntry	*entry;
+
+	hash_seq_init(&scan, OptionsCache);
+	while ((entry = (jdbcOptionsCacheEntry *) hash_seq_search(&scan)) != NULL)
+	{
+		entry->valid = false;
+	}
+}
+
+/*
+ * jdbcParseOptions
+ *		Fetch the options of a foreign table from the catalogs, or if
+ *		foreigntableid is InvalidOid, those of the server serverid.
+ */
+static void
+jdbcParseOptions(Oid foreigntableid, Oid serverid, jdbcFdwOptions *opts)
+{
+	ForeignTable	*f_table = NULL;
+	ForeignServer	*f_server;
+	UserMapping	*f_mapping;
+	List		*options;
+	ListCell	*lc;
+
+	memset(opts, 0, sizeof(jdbcFdwOptions));
+	opts->fetch_size = DEFAULT_FETCH_SIZE;
+	opts->batch_size = DEFAULT_BATCH_SIZE;
+	opts->bulk_load = true;
+	opts->use_remote_indexes = true;
+
+	/*
+	 * Extract options from FDW objects.  Table options come last so that
+	 * they override options also given on the server.
+	 */
+	if (OidIsValid(foreigntableid))
+	{
+		f_table = GetForeignTable(foreigntableid);
+		serverid = f_table->serverid;
+	}
+	f_server = GetForeignServer(serverid);
+	f_mapping = GetUserMapping(GetUserId(), serverid);
+
+	options = NIL;
 	options = list_concat(options, f_server->options);
 	options = list_concat(options, f_mapping->options);
+	if (f_table != NULL)
+		options = list_concat(options, f_table->options);
 
 	/* Loop through the options, and get the server/port */
 	foreach(lc, options)
@@ -662,49 +1626,116 @@ jdbcGetOptions(Oid foreigntableid, char **drivername, char **url, int *querytime
 
 		if (strcmp(def->defname, "drivername") == 0)
 		{
-			*drivername = defGetString(def);
+			opts->drivername = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "username") == 0)
 		{
-			*username = defGetString(def);
+			opts->username = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "querytimeout") == 0)
 		{
-			*querytimeout = atoi(defGetString(def));
+			opts->querytimeout = atoi(defGetString(def));
 		}
 
 		if (strcmp(def->defname, "jarfile") == 0)
 		{
-			*jarfile = defGetString(def);
+			opts->jarfile = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "maxheapsize") == 0)
 		{
-			*maxheapsize = atoi(defGetString(def));
+			opts->maxheapsize = atoi(defGetString(def));
 		}
 
 		if (strcmp(def->defname, "password") == 0)
 		{
-			*password = defGetString(def);
+			opts->password = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "query") == 0)
 		{
-			*query = defGetString(def);
+			opts->query = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "table") == 0)
 		{
-			*table = defGetString(def);
+			opts->table = defGetString(def);
 		}
 
 		if (strcmp(def->defname, "url") == 0)
 		{
-			*url = defGetString(def);
+			opts->url = defGetString(def);
+		}
+
+		if (strcmp(def->defname, "transfer_mode") == 0)
+		{
+			opts->use_buffer = (strcmp(defGetString(def), "buffer") == 0);
+		}
+
+		if (strcmp(def->defname, "fetch_size") == 0)
+		{
+			opts->fetch_size = atoi(defGetString(def));
+		}
+
+		if (strcmp(def->defname, "lookup_batch_size") == 0)
+		{
+			opts->lookup_batch_size = atoi(defGetString(def));
+		}
+
+		if (strcmp(def->defname, "streaming_profile") == 0)
+		{
+			opts->streaming_profile = defGetString(def);
+		}
+
+		if (strcmp(def->defname, "isolation_level") == 0)
+		{
+			opts->isolation_level = defGetString(def);
+		}
+
+		if (strcmp(def->defname, "page_size") == 0)
+		{
+			opts->page_size = atoi(defGetString(def));
+		}
+
+		if (strcmp(def->defname, "page_key") == 0)
+		{
+			opts->page_key = defGetString(def);
+		}
+
+		if (strcmp(def->defname, "cache_ttl") == 0)
+		{
+			opts->cache_ttl = atoi(defGetString(def));
+		}
+
+		if (strcmp(def->defname, "batch_size") == 0)
+		{
+			opts->batch_size = atoi(defGetString(def));
+		}
+
+		if (strcmp(def->defname, "bulk_load") == 0)
+		{
+			opts->bulk_load = defGetBoolean(def);
+		}
+
+		if (strcmp(def->defname, "use_remote_indexes") == 0)
+		{
+			opts->use_remote_indexes = defGetBoolean(def);
 		}
 	}
+
+	/*
+	 * page_size may come from the server, so a table with page_key is
+	 * checked once both are known.
+	 */
+	if (opts->page_key != NULL && opts->page_size <= 0)
+	{
+		ereport(ERROR,
+		(errcode(ERRCODE_SYNTAX_ERROR),
+		errmsg("page_key requires a positive page_size")
+		));
+	}
 }
 
 #if (PG_VERSION_NUM < 90200)
@@ -716,15 +1747,7 @@ static FdwPlan*
 jdbcPlanForeignScan(Oid foreigntableid, PlannerInfo *root, RelOptInfo *baserel)
 {
 	FdwPlan 	*fdwplan = NULL;
-	char		*svr_drivername = NULL;
-	char		*svr_username = NULL;
-	char		*svr_password = NULL;
-	char 		*svr_query = NULL;
-	char 		*svr_table = NULL;
-	char 		*svr_url = NULL;
-	char 		*svr_jarfile = NULL;
-	int 		svr_querytimeout = 0;
-	int 		svr_maxheapsize = 0;
+	jdbcFdwOptions	opts;
 	char		*query;
 
 	SIGINTInterruptCheckProcess(NULL);
@@ -734,32 +1757,22 @@ jdbcPlanForeignScan(Oid foreigntableid, PlannerInfo *root, RelOptInfo *baserel)
 	JVMInitialization(foreigntableid);
 
 	/* Fetch options */
-	jdbcGetOptions(
-	    foreigntableid, 
-	    &svr_drivername, 
-	    &svr_url, 
-	    &svr_querytimeout, 
-	    &svr_jarfile,
-	    &svr_maxheapsize, 
-	    &svr_username, 
-	    &svr_password, 
-	    &svr_query, 
-	    &svr_table
-	);
+	jdbcGetOptions(foreigntableid, &opts);
+
 	/* Build the query */
-	if (svr_query)
+	if (opts.query)
 	{
-		size_t len = strlen(svr_query) + 9;
+		size_t len = strlen(opts.query) + 9;
 
 		query = (char *) palloc(len);
-		snprintf(query, len, "EXPLAIN %s", svr_query);
+		snprintf(query, len, "EXPLAIN %s", opts.query);
 	}
 	else
 	{
-		size_t len = strlen(svr_table) + 23;
+		size_t len = strlen(opts.table) + 23;
 
 		query = (char *) palloc(len);
-		snprintf(query, len, "EXPLAIN SELECT * FROM %s", svr_table);
+		snprintf(query, len, "EXPLAIN SELECT * FROM %s", opts.table);
 	}
 
 	return (fdwplan);
@@ -773,29 +1786,15 @@ jdbcPlanForeignScan(Oid foreigntableid, PlannerInfo *root, RelOptInfo *baserel)
 static void
 jdbcExplainForeignScan(ForeignScanState *node, ExplainState *es)
 {
-	char 		    *svr_drivername = NULL;
-	char 		    *svr_url = NULL;
-	char		    *svr_username = NULL;
-	char		    *svr_password = NULL;
-	char		    *svr_query = NULL;
-	char		    *svr_table = NULL;
-	char 		    *svr_jarfile = NULL;
-	int 		    svr_querytimeout = 0;
-	int 		    svr_maxheapsize = 0;
-
-	/* Fetch options  */
-	jdbcGetOptions(
-	    RelationGetRelid(node->ss.ss_currentRelation), 
-	    &svr_drivername, 
-	    &svr_url, 
-	    &svr_querytimeout, 
-	    &svr_jarfile,
-	    &svr_maxheapsize, 
-	    &svr_username, 
-	    &svr_password, 
-	    &svr_query, 
-	    &svr_table
-	);
+#if (PG_VERSION_NUM >= 90200)
+	if (es->verbose && ((ForeignScan *) node->ss.ps.plan)->fdw_private != NIL)
+	{
+		ExplainPropertyText("Remote SQL",
+				    strVal(list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+						    FdwScanPrivateSelectSql)),
+				    es);
+	}
+#endif
 
 	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
 }
@@ -807,119 +1806,254 @@ jdbcExplainForeignScan(ForeignScanState *node, ExplainState *es)
 static void
 jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 {
-	char 			*svr_drivername = NULL;
-	char 			*svr_url = NULL;
-	char			*svr_username = NULL;
-	char			*svr_password = NULL;
-	char			*svr_query = NULL;
-	char			*svr_table = NULL;
-	char 			*svr_jarfile = NULL;
-	int 			svr_querytimeout = 0;
-	int 			svr_maxheapsize = 0;
-	jdbcFdwExecutionState   *festate;
+	jdbcFdwOptions		opts;
 	char			*query;
-	jobject 		java_call = NULL;
-	jclass 			JDBCUtilsClass;
-	jclass		 	JavaString;
-	jstring 		StringArray[7];
-	jstring 		initialize_result = NULL;
-	jmethodID		id_initialize;
-	jobjectArray		arg_array;
-	int 			counter = 0;
-	int 			referencedeletecounter = 0;
-	jfieldID 		id_numberofcolumns;
-	char 			*querytimeoutstr = NULL;
-	char 			*jar_classpath;
-	char 			strpkglibdir[] = STR_PKGLIBDIR;
-	char 			*initialize_result_cstring = NULL;
+	char			*retrievedattrsstr;
+	char			*javafilterstr = "";
+	int			maxrows = 0;
+	List			*fdw_exprs = NIL;
 
 	SIGINTInterruptCheckProcess(NULL);
 
 	/* Fetch options  */
-	jdbcGetOptions(
-	    RelationGetRelid(node->ss.ss_currentRelation), 
-	    &svr_drivername, 
-	    &svr_url, 
-	    &svr_querytimeout, 
-	    &svr_jarfile,
-	    &svr_maxheapsize, 
-	    &svr_username, 
-	    &svr_password, 
-	    &svr_query, 
-	    &svr_table
-	);
+	jdbcGetOptions(RelationGetRelid(node->ss.ss_currentRelation), &opts);
 
-	/* Build the query */
-	if (svr_query != NULL)
+	/*
+	 * The query and the columns it needs come from the plan; before 9.2
+	 * there is no plan data and all columns of the table are read.
+	 */
+#if (PG_VERSION_NUM >= 90200)
+	if (((ForeignScan *) node->ss.ps.plan)->fdw_private != NIL)
 	{
-		query = svr_query;
+		retrievedattrsstr = jdbcRetrievedAttrsString((List *) list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+										FdwScanPrivateRetrievedAttrs));
+		javafilterstr = strVal(list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+						FdwScanPrivateJavaFilter));
+		maxrows = intVal(list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+					  FdwScanPrivateMaxRows));
+		query = pstrdup(strVal(list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+						FdwScanPrivateSelectSql)));
+		fdw_exprs = ((ForeignScan *) node->ss.ps.plan)->fdw_exprs;
 	}
 	else
+#endif
 	{
-		size_t len = strlen(svr_table) + 15;
+		retrievedattrsstr = "*";
+
+		if (opts.query != NULL)
+		{
+			query = pstrdup(opts.query);
+		}
+		else
+		{
+			size_t len = strlen(opts.table) + 15;
+
+			query = (char *)palloc(len);
+			snprintf(query, len, "SELECT * FROM %s", opts.table);
+		}
+	}
+
+	/*
+	 * A scan that the result cache may serve connects only if it has to
+	 * read the remote rows.
+	 */
+	node->fdw_state = (void *) jdbcNewExecutionState(&opts, node->ss.ss_currentRelation->rd_att,
+							  query, retrievedattrsstr, javafilterstr,
+							  maxrows, list_length(fdw_exprs), false);
+#if PG_VERSION_NUM >= 120000
+	if (opts.cache_ttl <= 0 ||
+	    !jdbcResultCacheBegin((jdbcFdwExecutionState *) node->fdw_state,
+				  RelationGetRelid(node->ss.ss_currentRelation),
+				  node->ss.ss_currentRelation->rd_att, opts.cache_ttl))
+#endif
+		jdbcConnectExecutionState((jdbcFdwExecutionState *) node->fdw_state);
+	jdbcPrepareParams(node, (jdbcFdwExecutionState *) node->fdw_state, fdw_exprs);
 
-		query = (char *)palloc(len);
-		snprintf(query, len, "SELECT * FROM %s", svr_table);
+	/*
+	 * A scan expected to be rescanned with the same parameters keeps the
+	 * rows it reads.
+	 */
+	if ((eflags & EXEC_FLAG_REWIND) && !(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+	{
+		jdbcStartSpool((jdbcFdwExecutionState *) node->fdw_state,
+			       node->ss.ss_currentRelation->rd_att);
 	}
+}
+
+/*
+ * jdbcStartSpool
+ *		Keep the rows festate reads from the remote server in a
+ *		tuplestore from now on, so that rescans replay them.
+ */
+static void
+jdbcStartSpool(jdbcFdwExecutionState *festate, TupleDesc tupdesc)
+{
+	festate->tuplestore = tuplestore_begin_heap(false, false, work_mem);
+	festate->remote_done = false;
+#if PG_VERSION_NUM >= 120000
+	festate->replay_slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsMinimalTuple);
+#endif
+}
+
+/*
+ * jdbcCreateExecutionState
+ *		Connect to the server and prepare query, which reads rows of
+ *		tupdesc and has numParams parameters.  The query is executed by
+ *		jdbcRunQuery, or if modify is true it is a modification run
+ *		through jdbcModifyAddRow and jdbcModifyFlush.
+ */
+static jdbcFdwExecutionState *
+jdbcCreateExecutionState(jdbcFdwOptions *opts, TupleDesc tupdesc, char *query,
+			 char *retrievedattrsstr, char *javafilterstr, int maxrows, int numParams,
+			 bool modify)
+{
+	jdbcFdwExecutionState   *festate;
+
+	festate = jdbcNewExecutionState(opts, tupdesc, query, retrievedattrsstr, javafilterstr,
+					maxrows, numParams, modify);
+	jdbcConnectExecutionState(festate);
+
+	return festate;
+}
+
+/*
+ * jdbcNewExecutionState
+ *		Like jdbcCreateExecutionState, but without connecting yet: a scan
+ *		served by the result cache never needs the JVM.
+ */
+static jdbcFdwExecutionState *
+jdbcNewExecutionState(jdbcFdwOptions *opts, TupleDesc tupdesc, char *query,
+		      char *retrievedattrsstr, char *javafilterstr, int maxrows, int numParams,
+		      bool modify)
+{
+	jdbcFdwExecutionState   *festate;
 
 	/* Stash away the state info we have already */
 	festate = (jdbcFdwExecutionState *) palloc(sizeof(jdbcFdwExecutionState));
 	festate->query = query;
+	festate->java_call = NULL;
 	festate->NumberOfColumns = 0;
 	festate->NumberOfRows = 0;
+	festate->use_buffer = opts->use_buffer;
+	festate->attinmeta = TupleDescGetAttInMetadata(tupdesc);
+	festate->batch_ptr = NULL;
+	festate->batch_rows_left = 0;
+	festate->dictionaries = NULL;
+	festate->dictionary_cxt = NULL;
+	festate->query_started = false;
+	festate->numParams = numParams;
+	festate->param_exprs = NIL;
+	festate->param_typids = NULL;
+	festate->param_flinfo = NULL;
+	festate->tuplestore = NULL;
+	festate->replay_slot = NULL;
+	festate->remote_done = false;
+	festate->opts = *opts;
+	festate->retrievedattrsstr = retrievedattrsstr;
+	festate->javafilterstr = javafilterstr;
+	festate->maxrows = maxrows;
+	festate->modify = modify;
+	festate->cache = NULL;
+
+	return festate;
+}
+
+/*
+ * jdbcConnectExecutionState
+ *		Create the JDBCUtils object of festate, which connects to the
+ *		server and prepares the query.
+ */
+static void
+jdbcConnectExecutionState(jdbcFdwExecutionState *festate)
+{
+	jdbcFdwOptions		*opts = &festate->opts;
+	jobject 		java_call = NULL;
+	jclass 			JDBCUtilsClass;
+	jclass		 	JavaString;
+	jstring 		StringArray[NUM_INITIALIZE_OPTIONS];
+	jstring 		initialize_result = NULL;
+	jmethodID		id_initialize;
+	jobjectArray		arg_array;
+	int 			counter = 0;
+	int 			referencedeletecounter = 0;
+	char 			*querytimeoutstr = NULL;
+	char 			*fetchsizestr = NULL;
+	char 			*jar_classpath;
+	char 			strpkglibdir[] = STR_PKGLIBDIR;
+	char 			*initialize_result_cstring = NULL;
+	char			maxrowsstr[MAX_INT32_STRLEN];
+	char			numparamsstr[MAX_INT32_STRLEN];
+	char			pagesizestr[MAX_INT32_STRLEN];
+	char			nestlevelstr[MAX_INT32_STRLEN];
+	const char		*isolation_level = jdbcIsolationLevel(opts);
 
-	/* Connect to the server and execute the query */
+	/*
+	 * Connect to the server and prepare the query.  It is executed at the
+	 * first fetch, once the values of its parameters are known.
+	 */
 	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
 	if (JDBCUtilsClass == NULL) 
 	{
 		elog(ERROR, "JDBCUtilsClass is NULL");
 	}
 
-	id_initialize = (*env)->GetMethodID(env, JDBCUtilsClass, "Initialize", "([Ljava/lang/String;)Ljava/lang/String;");
+	id_initialize = (*env)->GetMethodID(env, JDBCUtilsClass, festate->modify ? "InitializeModify" : "Initialize",
+					    "([Ljava/lang/String;)Ljava/lang/String;");
 	if (id_initialize == NULL) 
 	{
 		elog(ERROR, "id_initialize is NULL");
 	}
 
-	id_numberofcolumns = (*env)->GetFieldID(env, JDBCUtilsClass, "NumberOfColumns" , "I");
-	if (id_numberofcolumns == NULL)
-	{
-		elog(ERROR, "id_numberofcolumns is NULL");
-	}
-	
-	querytimeoutstr = (char*)palloc(sizeof(int));
-	jar_classpath = (char*)palloc(strlen(strpkglibdir) + strlen(svr_jarfile) + 2);
+	querytimeoutstr = (char*)palloc(MAX_INT32_STRLEN);
+	fetchsizestr = (char*)palloc(MAX_INT32_STRLEN);
+	jar_classpath = (char*)palloc(strlen(strpkglibdir) + strlen(opts->jarfile) + 2);
 
-	snprintf(querytimeoutstr, sizeof(int), "%d", svr_querytimeout);
-	snprintf(jar_classpath, (strlen(svr_jarfile) + 1), "%s", svr_jarfile);
+	snprintf(querytimeoutstr, MAX_INT32_STRLEN, "%d", opts->querytimeout);
+	snprintf(fetchsizestr, MAX_INT32_STRLEN, "%d", opts->fetch_size);
+	snprintf(jar_classpath, (strlen(opts->jarfile) + 1), "%s", opts->jarfile);
 	
-	if (svr_username == NULL)
+	if (opts->username == NULL)
 	{
-		svr_username = "";
+		opts->username = "";
 	}
 
-	if (svr_password == NULL)
+	if (opts->password == NULL)
 	{
-		svr_password = "";
+		opts->password = "";
 	}
 	
 	StringArray[0] = (*env)->NewStringUTF(env, (festate->query));
-	StringArray[1] = (*env)->NewStringUTF(env, svr_drivername);
-	StringArray[2] = (*env)->NewStringUTF(env, svr_url);
-	StringArray[3] = (*env)->NewStringUTF(env, svr_username);
-	StringArray[4] = (*env)->NewStringUTF(env, svr_password);
+	StringArray[1] = (*env)->NewStringUTF(env, opts->drivername);
+	StringArray[2] = (*env)->NewStringUTF(env, opts->url);
+	StringArray[3] = (*env)->NewStringUTF(env, opts->username);
+	StringArray[4] = (*env)->NewStringUTF(env, opts->password);
 	StringArray[5] = (*env)->NewStringUTF(env, querytimeoutstr);
 	StringArray[6] = (*env)->NewStringUTF(env, jar_classpath);
+	StringArray[7] = (*env)->NewStringUTF(env, fetchsizestr);
+	StringArray[8] = (*env)->NewStringUTF(env, GetDatabaseEncodingName());
+	StringArray[9] = (*env)->NewStringUTF(env, festate->retrievedattrsstr);
+	StringArray[10] = (*env)->NewStringUTF(env, festate->javafilterstr);
+	snprintf(maxrowsstr, sizeof(maxrowsstr), "%d", festate->maxrows);
+	StringArray[11] = (*env)->NewStringUTF(env, maxrowsstr);
+	snprintf(numparamsstr, sizeof(numparamsstr), "%d", festate->numParams);
+	StringArray[12] = (*env)->NewStringUTF(env, numparamsstr);
+	StringArray[13] = (*env)->NewStringUTF(env, opts->streaming_profile ? opts->streaming_profile : "auto");
+	snprintf(pagesizestr, sizeof(pagesizestr), "%d", opts->page_key ? opts->page_size : 0);
+	StringArray[14] = (*env)->NewStringUTF(env, pagesizestr);
+	StringArray[15] = (*env)->NewStringUTF(env, opts->page_key ? opts->page_key : "");
+	StringArray[16] = (*env)->NewStringUTF(env, isolation_level);
+	snprintf(nestlevelstr, sizeof(nestlevelstr), "%d", GetCurrentTransactionNestLevel());
+	StringArray[17] = (*env)->NewStringUTF(env, nestlevelstr);
 
 	JavaString = (*env)->FindClass(env, "java/lang/String");
 
-	arg_array = (*env)->NewObjectArray(env, 7, JavaString, StringArray[0]);
+	arg_array = (*env)->NewObjectArray(env, NUM_INITIALIZE_OPTIONS, JavaString, StringArray[0]);
 	if (arg_array == NULL)
 	{
 		elog(ERROR, "arg_array is NULL");
 	}
 
-	for (counter = 1; counter < 7; counter++)
+	for (counter = 1; counter < NUM_INITIALIZE_OPTIONS; counter++)
 	{		
 		(*env)->SetObjectArrayElement(env, arg_array, counter, StringArray[counter]);
 	}
@@ -937,6 +2071,22 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 	}
 	festate->java_call = java_call;
 
+	/*
+	 * The connection joins the remote transaction of the local one, which
+	 * the callbacks commit or roll back with it.  If connecting fails
+	 * after the remote transaction began, the abort ends it.
+	 */
+	if (strcmp(isolation_level, "autocommit") != 0)
+	{
+		if (!XactCallbacksRegistered)
+		{
+			RegisterXactCallback(jdbcXactCallback, NULL);
+			RegisterSubXactCallback(jdbcSubXactCallback, NULL);
+			XactCallbacksRegistered = true;
+		}
+		RemoteXactOpened = true;
+	}
+
 	initialize_result = (*env)->CallObjectMethod(env, java_call, id_initialize, arg_array);
 	if (initialize_result != NULL)
 	{
@@ -944,10 +2094,7 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 		elog(ERROR, "%s", initialize_result_cstring);
 	}
 
-	node->fdw_state = (void *) festate;
-	festate->NumberOfColumns = (*env)->GetIntField(env, java_call, id_numberofcolumns);
-
-	for (referencedeletecounter = 0; referencedeletecounter < 7; referencedeletecounter++)
+	for (referencedeletecounter = 0; referencedeletecounter < NUM_INITIALIZE_OPTIONS; referencedeletecounter++)
 	{
 		(*env)->DeleteLocalRef(env, StringArray[referencedeletecounter]);
 	}	
@@ -958,231 +2105,5960 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 }
 
 /*
- * jdbcIterateForeignScan
- *		Read next record from the data file and store it into the
- *		ScanTupleSlot as a virtual tuple
+ * jdbcIsolationLevel
+ *		Returns the isolation level of the remote transactions of the
+ *		server, "autocommit", the default, if statements are not run in
+ *		one.  With "auto", the remote transaction is serializable if the
+ *		local one is and repeatable read otherwise, so that the scans
+ *		reusing a connection see the same remote data.
  */
-static TupleTableSlot*
-jdbcIterateForeignScan(ForeignScanState *node)
+static const char *
+jdbcIsolationLevel(jdbcFdwOptions *opts)
 {
-	char 			**values;
-	HeapTuple		tuple;
-	jmethodID		id_returnresultseterrormessage;
-	jmethodID		id_returnresultset;
-	jclass 			JDBCUtilsClass;
-	jobjectArray 		java_rowarray; 
-	jstring 			error_message = NULL;
-	char 				*error_message_cstring = NULL;
-	int 		        i = 0;
-	int 			j = 0;
-	jstring 		tempString;
-	jdbcFdwExecutionState *festate = (jdbcFdwExecutionState *) node->fdw_state;
-	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
-	jobject 		java_call = festate->java_call;
+	if (opts->isolation_level == NULL)
+	{
+		return "autocommit";
+	}
 
-	/* Cleanup */
-	ExecClearTuple(slot);
+	if (strcmp(opts->isolation_level, "auto") != 0)
+	{
+		return opts->isolation_level;
+	}
 
-	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+	return IsolationIsSerializable() ? "serializable" : "repeatable read";
+}
 
-	if ((*env)->PushLocalFrame(env, (festate->NumberOfColumns + 10)) < 0) 
+/*
+ * jdbcXactCallback
+ *		Commits the remote transactions before the local transaction
+ *		commits, so that a remote failure aborts it, and rolls them back
+ *		when it aborts.  The remote transactions are not prepared, so a
+ *		transaction that used them cannot be prepared either.
+ */
+static void
+jdbcXactCallback(XactEvent event, void *arg)
+{
+	jvalue	args[1];
+
+	if (!RemoteXactOpened)
 	{
-         /* frame not pushed, no PopLocalFrame needed */
-		elog(ERROR, "Error"); 
-     	}
+		return;
+	}
+
+	switch (event)
+	{
+#if PG_VERSION_NUM >= 90300
+#if PG_VERSION_NUM >= 90500
+		case XACT_EVENT_PARALLEL_PRE_COMMIT:
+#endif
+		case XACT_EVENT_PRE_COMMIT:
+			args[0].z = JNI_TRUE;
+			jdbcCallTransactionMethod("EndTransactions", "(Z)Ljava/lang/String;", args, ERROR);
+			break;
+		case XACT_EVENT_PRE_PREPARE:
+			ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				errmsg("cannot PREPARE a transaction that has used jdbc_fdw foreign tables")
+				));
+			break;
+#if PG_VERSION_NUM >= 90500
+		case XACT_EVENT_PARALLEL_COMMIT:
+#endif
+		case XACT_EVENT_COMMIT:
+			RemoteXactOpened = false;
+			break;
+#else
+		case XACT_EVENT_COMMIT:
+			/* Too late to abort the local transaction on failure. */
+			args[0].z = JNI_TRUE;
+			RemoteXactOpened = false;
+			jdbcCallTransactionMethod("EndTransactions", "(Z)Ljava/lang/String;", args, WARNING);
+			break;
+#endif
+#if PG_VERSION_NUM >= 90500
+		case XACT_EVENT_PARALLEL_ABORT:
+#endif
+		case XACT_EVENT_ABORT:
+			args[0].z = JNI_FALSE;
+			RemoteXactOpened = false;
+			jdbcCallTransactionMethod("EndTransactions", "(Z)Ljava/lang/String;", args, WARNING);
+			break;
+		default:
+			break;
+	}
+}
 
+/*
+ * jdbcSubXactCallback
+ *		Releases the remote savepoints of a subtransaction that commits,
+ *		and rolls the remote transactions back to them when it aborts.
+ */
+static void
+jdbcSubXactCallback(SubXactEvent event, SubTransactionId mySubid,
+		    SubTransactionId parentSubid, void *arg)
+{
+	jvalue	args[2];
 
-	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
-	if (JDBCUtilsClass == NULL) 
+	if (!RemoteXactOpened)
 	{
-		elog(ERROR, "JDBCUtilsClass is NULL");
+		return;
 	}
 
-	id_returnresultset = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSet", "()[Ljava/lang/String;");
-	if (id_returnresultset == NULL)
+	args[0].i = GetCurrentTransactionNestLevel();
+
+	switch (event)
 	{
-		elog(ERROR, "id_returnresultset is NULL");
+#if PG_VERSION_NUM >= 90300
+		case SUBXACT_EVENT_PRE_COMMIT_SUB:
+#else
+		case SUBXACT_EVENT_COMMIT_SUB:
+#endif
+			args[1].z = JNI_TRUE;
+			jdbcCallTransactionMethod("EndSubtransaction", "(IZ)Ljava/lang/String;", args, ERROR);
+			break;
+		case SUBXACT_EVENT_ABORT_SUB:
+			args[1].z = JNI_FALSE;
+			jdbcCallTransactionMethod("EndSubtransaction", "(IZ)Ljava/lang/String;", args, WARNING);
+			break;
+		default:
+			break;
 	}
+}
 
-	id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
-	if (id_returnresultset == NULL)
+/*
+ * jdbcCallTransactionMethod
+ *		Calls a static method of JDBCUtils ending remote transactions or
+ *		subtransactions, and reports the error it returns at elevel.
+ *		During an abort, elevel must be below ERROR.
+ */
+static void
+jdbcCallTransactionMethod(const char *method, const char *signature, jvalue *args, int elevel)
+{
+	jclass		JDBCUtilsClass;
+	jmethodID	id_method;
+	jstring		result;
+	char		*result_cstring;
+	char		*message;
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL)
 	{
-		elog(ERROR, "id_returnresultseterrormessage is NULL");
+		elog(elevel, "JDBCUtilsClass is NULL");
+		return;
 	}
- 
-	values=(char**)palloc(sizeof(char*)*(festate->NumberOfColumns));
-	
-	java_rowarray = (*env)->CallObjectMethod(env, java_call, id_returnresultset);
 
-	if (java_rowarray != NULL)
+	id_method = (*env)->GetStaticMethodID(env, JDBCUtilsClass, method, signature);
+	if (id_method == NULL)
 	{
-    
-		for (i = 0; i < (festate->NumberOfColumns); i++) 
-		{
-        		values[i] = ConvertStringToCString((jobject)(*env)->GetObjectArrayElement(env, java_rowarray, i));
-    		}
+		elog(elevel, "id_method is NULL");
+		return;
+	}
 
-		tuple = BuildTupleFromCStrings(TupleDescGetAttInMetadata(node->ss.ss_currentRelation->rd_att), values);
-#if PG_VERSION_NUM < 120000
-		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
-#else
-		ExecStoreHeapTuple(tuple, slot, false);
-#endif
-		++ (festate->NumberOfRows);
+	result = (*env)->CallStaticObjectMethodA(env, JDBCUtilsClass, id_method, args);
+	if (result != NULL)
+	{
+		result_cstring = ConvertStringToCString((jobject) result);
+		message = pstrdup(result_cstring);
+		(*env)->ReleaseStringUTFChars(env, result, result_cstring);
+		(*env)->DeleteLocalRef(env, result);
+		elog(elevel, "%s", message);
+	}
+}
 
-		for (j = 0; j < festate->NumberOfColumns; j++)
-		{
-			tempString = (jstring)(*env)->GetObjectArrayElement(env, java_rowarray,j);
-			(*env)->ReleaseStringUTFChars(env, tempString, values[j]);
-			(*env)->DeleteLocalRef(env, tempString);
-		}
-	
-		(*env)->DeleteLocalRef(env, java_rowarray);
+/*
+ * jdbcPrepareParams
+ *		Set up the evaluation of the query parameters, which the plan
+ *		gives as expressions over the outer side of a nested loop.
+ */
+static void
+jdbcPrepareParams(ForeignScanState *node, jdbcFdwExecutionState *festate, List *fdw_exprs)
+{
+	ListCell	*lc;
+	int		i = 0;
+
+	festate->numParams = list_length(fdw_exprs);
+	if (festate->numParams == 0)
+	{
+		return;
 	}
 
-	(*env)->PopLocalFrame(env, NULL);
+	festate->param_typids = (Oid *) palloc(sizeof(Oid) * festate->numParams);
+	festate->param_flinfo = (FmgrInfo *) palloc(sizeof(FmgrInfo) * festate->numParams);
 
-	error_message = (*env)->CallObjectMethod(env, java_call, id_returnresultseterrormessage);
-	if (error_message != NULL)
+	foreach(lc, fdw_exprs)
 	{
-		error_message_cstring = ConvertStringToCString((jobject)error_message);
-		elog(ERROR, "%s", error_message_cstring);
+		Oid	typoutput;
+		bool	typisvarlena;
+
+		festate->param_typids[i] = exprType((Node *) lfirst(lc));
+		getTypeOutputInfo(festate->param_typids[i], &typoutput, &typisvarlena);
+		fmgr_info(typoutput, &festate->param_flinfo[i]);
+		i++;
 	}
 
-return (slot);
+#if PG_VERSION_NUM >= 100000
+	festate->param_exprs = ExecInitExprList(fdw_exprs, (PlanState *) node);
+#else
+	festate->param_exprs = (List *) ExecInitExpr((Expr *) fdw_exprs, (PlanState *) node);
+#endif
 }
 
 /*
- * jdbcEndForeignScan
- *		Finish scanning foreign table and dispose objects used for this scan
+ * jdbcExecuteQuery
+ *		Execute the query of a foreign scan with the current values of
+ *		its parameters.  Called at the first fetch after Begin or ReScan.
  */
 static void
-jdbcEndForeignScan(ForeignScanState *node)
+jdbcExecuteQuery(ForeignScanState *node)
 {
-	jmethodID 			id_close;
-	jclass 				JDBCUtilsClass;
-	jstring 			close_result = NULL;
-	char 				*close_result_cstring = NULL;
 	jdbcFdwExecutionState *festate = (jdbcFdwExecutionState *) node->fdw_state;
-	jobject 			java_call = festate->java_call;
+	ExprContext	*econtext = node->ss.ps.ps_ExprContext;
+	const char	**types;
+	char		**values;
+	MemoryContext	oldcontext;
+	ListCell	*lc;
+	int		i = 0;
 
-	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+	/* Parameters are evaluated in the per-tuple memory of the scan */
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
 
-	PG_TRY();
+	types = (const char **) palloc(sizeof(char *) * (festate->numParams + 1));
+	values = (char **) palloc(sizeof(char *) * (festate->numParams + 1));
+
+	foreach(lc, festate->param_exprs)
 	{
-		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
-		if (JDBCUtilsClass == NULL) 
-		{
-			elog(ERROR, "JDBCUtilsClass is NULL");
-		}
+		ExprState	*expr_state = (ExprState *) lfirst(lc);
+		Datum		value;
+		bool		isnull;
 
-		id_close = (*env)->GetMethodID(env, JDBCUtilsClass, "Close", "()Ljava/lang/String;");
-		if (id_close == NULL) 
-		{
-			elog(ERROR, "id_close is NULL");
-		}
+#if PG_VERSION_NUM >= 100000
+		value = ExecEvalExpr(expr_state, econtext, &isnull);
+#else
+		value = ExecEvalExpr(expr_state, econtext, &isnull, NULL);
+#endif
 
-		close_result = (*env)->CallObjectMethod(env, java_call, id_close);
-		if (close_result != NULL)
+		types[i] = jdbcParamType(festate->param_typids[i]);
+		if (types[i] == NULL)
 		{
-			close_result_cstring = ConvertStringToCString((jobject)close_result);
-			elog(ERROR, "%s", close_result_cstring);
+			types[i] = "text";
 		}
+
+		values[i] = isnull ? NULL : jdbcParamValueString(value, festate->param_typids[i],
+								 &festate->param_flinfo[i]);
+		i++;
 	}
-	PG_CATCH();
+
+	MemoryContextSwitchTo(oldcontext);
+
+#if PG_VERSION_NUM >= 120000
+	if (festate->cache != NULL && jdbcResultCacheLookup(festate, types, values))
 	{
-		(*env)->ReleaseStringUTFChars(env, close_result, close_result_cstring);
-		(*env)->DeleteLocalRef(env, close_result);
+		festate->query_started = true;
+		return;
+	}
+#endif
 
-		releaseJdbcFdwExecutionState((jdbcFdwExecutionState **)&(node->fdw_state));
-		
-		PG_RE_THROW();
+	if (festate->java_call == NULL)
+	{
+		jdbcConnectExecutionState(festate);
 	}
-	PG_END_TRY();
 
-	releaseJdbcFdwExecutionState((jdbcFdwExecutionState **)&(node->fdw_state));
+	jdbcRunQuery(festate, types, values);
 }
 
 /*
- * jdbcReScanForeignScan
- *		Rescan table, possibly with new parameters
+ * jdbcRunQuery
+ *		Execute the prepared query of festate, binding its parameters to
+ *		values (NULL for a null value) with the JDBCUtils bindings named
+ *		by types.  A query that was executed before is closed first.
  */
 static void
-jdbcReScanForeignScan(ForeignScanState *node)
+jdbcRunQuery(jdbcFdwExecutionState *festate, const char **types, char **values)
 {
-	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
-}
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_execute;
+	jfieldID 	id_numberofcolumns;
+	jobjectArray	types_array;
+	jobjectArray	values_array;
+	jstring 	execute_result = NULL;
+	char 		*execute_result_cstring = NULL;
 
-#if (PG_VERSION_NUM >= 90200)
-/*
- * jdbcGetForeignPaths
- *		(9.2+) Get the foreign paths
- */
-static void
-jdbcGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_execute = (*env)->GetMethodID(env, JDBCUtilsClass, "Execute", "([Ljava/lang/String;[Ljava/lang/String;)Ljava/lang/String;");
+	if (id_execute == NULL) 
+	{
+		elog(ERROR, "id_execute is NULL");
+	}
+
+	id_numberofcolumns = (*env)->GetFieldID(env, JDBCUtilsClass, "NumberOfColumns" , "I");
+	if (id_numberofcolumns == NULL)
+	{
+		elog(ERROR, "id_numberofcolumns is NULL");
+	}
+
+	types_array = jdbcNewStringArray(festate->numParams, types);
+	values_array = jdbcNewStringArray(festate->numParams, (const char **) values);
+
+	execute_result = (*env)->CallObjectMethod(env, festate->java_call, id_execute, types_array, values_array);
+	if (execute_result != NULL)
+	{
+		execute_result_cstring = ConvertStringToCString((jobject)execute_result);
+		elog(ERROR, "%s", execute_result_cstring);
+	}
+
+	(*env)->DeleteLocalRef(env, types_array);
+	(*env)->DeleteLocalRef(env, values_array);
+
+	festate->query_started = true;
+	festate->batch_ptr = NULL;
+	festate->batch_rows_left = 0;
+	festate->NumberOfColumns = (*env)->GetIntField(env, festate->java_call, id_numberofcolumns);
+
+	/* Dictionaries are kept across executions, as the JVM keeps its own */
+	if (festate->use_buffer && festate->dictionaries == NULL)
+	{
+		festate->dictionaries = (jdbcColumnDictionary *) palloc0(sizeof(jdbcColumnDictionary) * festate->NumberOfColumns);
+		festate->dictionary_cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"jdbc_fdw dictionaries",
+								ALLOCSET_DEFAULT_MINSIZE,
+								ALLOCSET_DEFAULT_INITSIZE,
+								ALLOCSET_DEFAULT_MAXSIZE);
+	}
+}
+
+/*
+ * jdbcNewStringArray
+ *		Make a Java String array of n strings, NULL ones included.
+ */
+static jobjectArray
+jdbcNewStringArray(int n, const char **strings)
+{
+	jclass		JavaString;
+	jobjectArray	array;
+	int		i;
+
+	JavaString = (*env)->FindClass(env, "java/lang/String");
+
+	array = (*env)->NewObjectArray(env, n, JavaString, NULL);
+	if (array == NULL)
+	{
+		elog(ERROR, "string array is NULL");
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		jstring		element;
+
+		if (strings[i] == NULL)
+		{
+			continue;
+		}
+
+		element = (*env)->NewStringUTF(env, strings[i]);
+		(*env)->SetObjectArrayElement(env, array, i, element);
+		(*env)->DeleteLocalRef(env, element);
+	}
+
+	return array;
+}
+
+/*
+ * jdbcParamType
+ *		Name of the binding JDBCUtils uses for a parameter of the given
+ *		type, or NULL if join keys of the type are not sent to the remote
+ *		server.  Floats are left out as their text form may be rounded.
+ */
+static const char *
+jdbcParamType(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return "int2";
+		case INT4OID:
+			return "int4";
+		case INT8OID:
+			return "int8";
+		case NUMERICOID:
+			return "numeric";
+		case BOOLOID:
+			return "bool";
+		case TEXTOID:
+		case VARCHAROID:
+			return "text";
+		case DATEOID:
+			return "date";
+		case TIMESTAMPOID:
+			return "timestamp";
+		case TIMESTAMPTZOID:
+			return "timestamptz";
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * jdbcParamValueString
+ *		Text form of a parameter value for JDBCUtils.  Dates and
+ *		timestamps are written in the ISO format java.sql parses,
+ *		whatever DateStyle is set, and timestamps with time zone as
+ *		microseconds since the Unix epoch; other values use their
+ *		output function.
+ */
+static char *
+jdbcParamValueString(Datum value, Oid type, FmgrInfo *flinfo)
+{
+	StringInfoData	buf;
+
+	if (type == DATEOID && !DATE_NOT_FINITE(DatumGetDateADT(value)))
+	{
+		int	year;
+		int	month;
+		int	day;
+
+		j2date(DatumGetDateADT(value) + POSTGRES_EPOCH_JDATE, &year, &month, &day);
+		if (year > 0)
+		{
+			initStringInfo(&buf);
+			appendStringInfo(&buf, "%04d-%02d-%02d", year, month, day);
+			return buf.data;
+		}
+	}
+	else if (type == TIMESTAMPOID && !TIMESTAMP_NOT_FINITE(DatumGetTimestamp(value)))
+	{
+		struct pg_tm	tm;
+		fsec_t		fsec;
+
+		if (timestamp2tm(DatumGetTimestamp(value), NULL, &tm, &fsec, NULL, NULL) == 0 &&
+		    tm.tm_year > 0)
+		{
+			initStringInfo(&buf);
+			appendStringInfo(&buf, "%04d-%02d-%02d %02d:%02d:%02d.%06d",
+					 tm.tm_year, tm.tm_mon, tm.tm_mday,
+					 tm.tm_hour, tm.tm_min, tm.tm_sec, (int) fsec);
+			return buf.data;
+		}
+	}
+	else if (type == TIMESTAMPTZOID && !TIMESTAMP_NOT_FINITE(DatumGetTimestampTz(value)))
+	{
+		initStringInfo(&buf);
+		appendStringInfo(&buf, INT64_FORMAT,
+				 (int64) DatumGetTimestampTz(value) +
+				 (int64) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY);
+		return buf.data;
+	}
+
+	return OutputFunctionCall(flinfo, value);
+}
+
+/*
+ * jdbcIterateForeignScan
+ *		Read next record from the data file and store it into the
+ *		ScanTupleSlot as a virtual tuple
+ */
+static TupleTableSlot*
+jdbcIterateForeignScan(ForeignScanState *node)
+{
+	jdbcFdwExecutionState *festate;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+
+	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+
+	festate = (jdbcFdwExecutionState *) node->fdw_state;
+
+	/* Replay the rows kept by an earlier pass */
+	if (festate->tuplestore != NULL && !tuplestore_ateof(festate->tuplestore))
+	{
+#if PG_VERSION_NUM >= 120000
+		if (tuplestore_gettupleslot(festate->tuplestore, true, false, festate->replay_slot))
+		{
+			return ExecCopySlot(slot, festate->replay_slot);
+		}
+#else
+		if (tuplestore_gettupleslot(festate->tuplestore, true, false, slot))
+		{
+			return (slot);
+		}
+#endif
+	}
+
+	if (festate->tuplestore != NULL && festate->remote_done)
+	{
+		return ExecClearTuple(slot);
+	}
+
+	if (!festate->query_started)
+	{
+		jdbcExecuteQuery(node);
+	}
+
+#if PG_VERSION_NUM >= 120000
+	if (festate->cache != NULL)
+	{
+		jdbcResultCacheFetchRow(festate, node->ss.ss_currentRelation->rd_att, slot);
+	}
+	else
+#endif
+	{
+		jdbcFetchRow(festate, node->ss.ss_currentRelation->rd_att, slot);
+	}
+
+	/* At the end of the tuplestore, so its read position stays there */
+	if (festate->tuplestore != NULL)
+	{
+		if (TupIsNull(slot))
+			festate->remote_done = true;
+		else
+			tuplestore_puttupleslot(festate->tuplestore, slot);
+	}
+
+	return (slot);
+}
+
+/*
+ * jdbcFetchRow
+ *		Read the next row of the result set of festate into slot, which
+ *		is left empty once all rows have been read.
+ */
+static void
+jdbcFetchRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc, TupleTableSlot *slot)
+{
+	char 			**values;
+	HeapTuple		tuple;
+	jmethodID		id_returnresultseterrormessage;
+	jmethodID		id_returnresultset;
+	jclass 			JDBCUtilsClass;
+	jobjectArray 		java_rowarray; 
+	jstring 			error_message = NULL;
+	char 				*error_message_cstring = NULL;
+	int 		        i = 0;
+	int 			j = 0;
+	jstring 		tempString;
+	jobject 		java_call = festate->java_call;
+
+	/* Cleanup */
+	ExecClearTuple(slot);
+
+	if (festate->use_buffer)
+	{
+		jdbcFetchBufferRow(festate, tupdesc, slot);
+		return;
+	}
+
+	if ((*env)->PushLocalFrame(env, (festate->NumberOfColumns + 10)) < 0) 
+	{
+         /* frame not pushed, no PopLocalFrame needed */
+		elog(ERROR, "Error"); 
+     	}
+
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_returnresultset = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSet", "()[Ljava/lang/String;");
+	if (id_returnresultset == NULL)
+	{
+		elog(ERROR, "id_returnresultset is NULL");
+	}
+
+	id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+	if (id_returnresultset == NULL)
+	{
+		elog(ERROR, "id_returnresultseterrormessage is NULL");
+	}
+ 
+	values=(char**)palloc(sizeof(char*)*(festate->NumberOfColumns));
+	
+	java_rowarray = (*env)->CallObjectMethod(env, java_call, id_returnresultset);
+
+	if (java_rowarray != NULL)
+	{
+    
+		for (i = 0; i < (festate->NumberOfColumns); i++) 
+		{
+        		values[i] = ConvertStringToCString((jobject)(*env)->GetObjectArrayElement(env, java_rowarray, i));
+    		}
+
+		tuple = BuildTupleFromCStrings(festate->attinmeta, values);
+#if PG_VERSION_NUM < 120000
+		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+#else
+		ExecStoreHeapTuple(tuple, slot, false);
+#endif
+		++ (festate->NumberOfRows);
+
+		for (j = 0; j < festate->NumberOfColumns; j++)
+		{
+			tempString = (jstring)(*env)->GetObjectArrayElement(env, java_rowarray,j);
+			(*env)->ReleaseStringUTFChars(env, tempString, values[j]);
+			(*env)->DeleteLocalRef(env, tempString);
+		}
+	
+		(*env)->DeleteLocalRef(env, java_rowarray);
+	}
+
+	(*env)->PopLocalFrame(env, NULL);
+
+	error_message = (*env)->CallObjectMethod(env, java_call, id_returnresultseterrormessage);
+	if (error_message != NULL)
+	{
+		error_message_cstring = ConvertStringToCString((jobject)error_message);
+		elog(ERROR, "%s", error_message_cstring);
+	}
+}
+
+/*
+ * jdbcFetchBatch
+ *		Ask JDBCUtils for the next batch of rows.  The rows are encoded by
+ *		the JVM into a direct ByteBuffer which is read in place: a row
+ *		count and the offset of the dictionary section, followed, for
+ *		every column of every row, by an int32 length (-1 for NULL) and
+ *		that many bytes in the server encoding plus a terminating NUL, or
+ *		by an int32 dictionary code (-1 for NULL) for dictionary encoded
+ *		columns.  The buffer stays valid until the next call.
+ */
+static void
+jdbcFetchBatch(jdbcFdwExecutionState *festate, TupleDesc tupdesc)
+{
+	jclass 			JDBCUtilsClass;
+	jmethodID		id_returnresultsetbatch;
+	jmethodID		id_returnresultseterrormessage;
+	jobject			batch;
+	jstring 		error_message = NULL;
+	char			*error_message_cstring = NULL;
+	char			*address;
+	int32			nrows;
+	int32			dictionary_offset;
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_returnresultsetbatch = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetBatch", "()Ljava/nio/ByteBuffer;");
+	if (id_returnresultsetbatch == NULL)
+	{
+		elog(ERROR, "id_returnresultsetbatch is NULL");
+	}
+
+	id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+	if (id_returnresultseterrormessage == NULL)
+	{
+		elog(ERROR, "id_returnresultseterrormessage is NULL");
+	}
+
+	festate->batch_ptr = NULL;
+	festate->batch_rows_left = 0;
+
+	batch = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultsetbatch);
+	if (batch == NULL)
+	{
+		error_message = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultseterrormessage);
+		if (error_message != NULL)
+		{
+			error_message_cstring = ConvertStringToCString((jobject)error_message);
+			elog(ERROR, "%s", error_message_cstring);
+		}
+		return;
+	}
+
+	address = (char *)(*env)->GetDirectBufferAddress(env, batch);
+	(*env)->DeleteLocalRef(env, batch);
+	if (address == NULL)
+	{
+		elog(ERROR, "direct buffer access is not supported by the JVM");
+	}
+
+	memcpy(&nrows, address, sizeof(int32));
+	memcpy(&dictionary_offset, address + sizeof(int32), sizeof(int32));
+
+	jdbcReadDictionaries(festate, tupdesc, address + dictionary_offset);
+
+	festate->batch_ptr = address + 2 * sizeof(int32);
+	festate->batch_rows_left = nrows;
+}
+
+/*
+ * jdbcReadDictionaries
+ *		Read the dictionary section of a batch, which holds for each
+ *		result column the number of entries added by this batch (-1 if
+ *		the column is sent as plain values) followed by the new entries.
+ *		The entries are converted once and kept for the rest of the scan.
+ *		Returns the position after the section.
+ */
+static char *
+jdbcReadDictionaries(jdbcFdwExecutionState *festate, TupleDesc tupdesc, char *ptr)
+{
+	AttInMetadata	*attinmeta = festate->attinmeta;
+	MemoryContext	oldcontext;
+	int		i;
+	int		j;
+
+	oldcontext = MemoryContextSwitchTo(festate->dictionary_cxt);
+
+	for (i = 0; i < festate->NumberOfColumns; i++)
+	{
+		jdbcColumnDictionary *dict = &festate->dictionaries[i];
+		bool		convert;
+		int32		added;
+
+		memcpy(&added, ptr, sizeof(int32));
+		ptr += sizeof(int32);
+
+		dict->active = (added >= 0);
+		if (added <= 0)
+		{
+			continue;
+		}
+
+		if (dict->count + added > dict->allocated)
+		{
+			dict->allocated = Max(dict->count + added, 2 * dict->allocated);
+			if (dict->values == NULL)
+				dict->values = (Datum *) palloc(sizeof(Datum) * dict->allocated);
+			else
+				dict->values = (Datum *) repalloc(dict->values, sizeof(Datum) * dict->allocated);
+		}
+
+		convert = (i < tupdesc->natts && !TupleDescAttr(tupdesc, i)->attisdropped);
+
+		for (j = 0; j < added; j++)
+		{
+			int32	len;
+			char	*value;
+
+			memcpy(&len, ptr, sizeof(int32));
+			ptr += sizeof(int32);
+			value = ptr;
+			ptr += len + 1;
+
+			if (convert)
+			{
+				dict->values[dict->count] = InputFunctionCall(&attinmeta->attinfuncs[i],
+									      value,
+									      attinmeta->attioparams[i],
+									      attinmeta->atttypmods[i]);
+			}
+			else
+			{
+				dict->values[dict->count] = (Datum) 0;
+			}
+			dict->count++;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return ptr;
+}
+
+/*
+ * jdbcFetchBufferRow
+ *		Read the next record from the current batch, fetching a new batch
+ *		when it is used up, and store it into slot as a virtual tuple.
+ *		The values are handed to the input functions straight from the
+ *		JVM's buffer.
+ */
+static void
+jdbcFetchBufferRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc, TupleTableSlot *slot)
+{
+	AttInMetadata	*attinmeta = festate->attinmeta;
+	Datum		*values = slot->tts_values;
+	bool		*nulls = slot->tts_isnull;
+	int		natts = tupdesc->natts;
+	int		i;
+
+	if (festate->batch_rows_left == 0)
+	{
+		jdbcFetchBatch(festate, tupdesc);
+
+		if (festate->batch_rows_left == 0)
+		{
+			return;
+		}
+	}
+
+	for (i = 0; i < festate->NumberOfColumns; i++)
+	{
+		int32	len;
+		char	*value = NULL;
+
+		memcpy(&len, festate->batch_ptr, sizeof(int32));
+		festate->batch_ptr += sizeof(int32);
+
+		if (festate->dictionaries[i].active)
+		{
+			/* len is the dictionary code */
+			if (i >= natts || TupleDescAttr(tupdesc, i)->attisdropped)
+			{
+				if (i < natts)
+				{
+					values[i] = (Datum) 0;
+					nulls[i] = true;
+				}
+				continue;
+			}
+
+			if (len >= 0)
+			{
+				values[i] = festate->dictionaries[i].values[len];
+				nulls[i] = false;
+				continue;
+			}
+
+			/* NULLs still go through the input function, for domains */
+		}
+
+		if (len >= 0)
+		{
+			value = festate->batch_ptr;
+			festate->batch_ptr += len + 1;
+		}
+
+		if (i >= natts)
+		{
+			continue;
+		}
+
+		if (TupleDescAttr(tupdesc, i)->attisdropped)
+		{
+			values[i] = (Datum) 0;
+			nulls[i] = true;
+			continue;
+		}
+
+		values[i] = InputFunctionCall(&attinmeta->attinfuncs[i],
+					      value,
+					      attinmeta->attioparams[i],
+					      attinmeta->atttypmods[i]);
+		nulls[i] = (value == NULL);
+	}
+
+	for (; i < natts; i++)
+	{
+		values[i] = (Datum) 0;
+		nulls[i] = true;
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	-- (festate->batch_rows_left);
+	++ (festate->NumberOfRows);
+}
+
+/*
+ * jdbcEndForeignScan
+ *		Finish scanning foreign table and dispose objects used for this scan
+ */
+static void
+jdbcEndForeignScan(ForeignScanState *node)
+{
+	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+
+	jdbcCloseExecutionState((jdbcFdwExecutionState **)&(node->fdw_state));
+}
+
+/*
+ * jdbcCloseExecutionState
+ *		Close the query of festate and release the execution state.
+ */
+static void
+jdbcCloseExecutionState(jdbcFdwExecutionState **festate)
+{
+	jmethodID 			id_close;
+	jclass 				JDBCUtilsClass;
+	jstring 			close_result = NULL;
+	char 				*close_result_cstring = NULL;
+	jobject 			java_call = (*festate)->java_call;
+
+	/* A scan served by the result cache never connected. */
+	if (java_call == NULL)
+	{
+		releaseJdbcFdwExecutionState(festate);
+		return;
+	}
+
+	PG_TRY();
+	{
+		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+		if (JDBCUtilsClass == NULL) 
+		{
+			elog(ERROR, "JDBCUtilsClass is NULL");
+		}
+
+		id_close = (*env)->GetMethodID(env, JDBCUtilsClass, "Close", "()Ljava/lang/String;");
+		if (id_close == NULL) 
+		{
+			elog(ERROR, "id_close is NULL");
+		}
+
+		close_result = (*env)->CallObjectMethod(env, java_call, id_close);
+		if (close_result != NULL)
+		{
+			close_result_cstring = ConvertStringToCString((jobject)close_result);
+			elog(ERROR, "%s", close_result_cstring);
+		}
+	}
+	PG_CATCH();
+	{
+		(*env)->ReleaseStringUTFChars(env, close_result, close_result_cstring);
+		(*env)->DeleteLocalRef(env, close_result);
+
+		releaseJdbcFdwExecutionState(festate);
+		
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	releaseJdbcFdwExecutionState(festate);
+}
+
+/*
+ * jdbcReScanForeignScan
+ *		Rescan table, possibly with new parameters
+ */
+static void
+jdbcReScanForeignScan(ForeignScanState *node)
+{
+	jdbcFdwExecutionState *festate;
+
+	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+
+	festate = (jdbcFdwExecutionState *) node->fdw_state;
+
+	/*
+	 * Unless a parameter of the scan changed, the remote rows are the same
+	 * on every pass: the rows read so far are replayed, then the remote
+	 * query goes on.  A scan rescanned without EXEC_FLAG_REWIND starts
+	 * keeping its rows on the pass that follows.
+	 */
+	if (node->ss.ps.chgParam == NULL)
+	{
+		if (festate->tuplestore != NULL)
+		{
+			tuplestore_rescan(festate->tuplestore);
+			return;
+		}
+
+		jdbcStartSpool(festate, node->ss.ss_currentRelation->rd_att);
+	}
+	else if (festate->tuplestore != NULL)
+	{
+		tuplestore_clear(festate->tuplestore);
+		festate->remote_done = false;
+	}
+
+	/* Execute the query again at the next fetch, with the current parameters */
+	festate->query_started = false;
+	festate->batch_ptr = NULL;
+	festate->batch_rows_left = 0;
+}
+
+#if (PG_VERSION_NUM >= 90200)
+/*
+ * jdbcGetForeignPaths
+ *		(9.2+) Get the foreign paths
+ */
+static void
+jdbcGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	double		rows;
+	Cost 		startup_cost;
+	Cost 		total_cost;
+
+	SIGINTInterruptCheckProcess(NULL);
+
+	/* Create a ForeignPath node for a scan of the whole table */
+	jdbcEstimateCosts(root, baserel, NULL, &rows, &startup_cost, &total_cost);
+	add_path(baserel, (Path *) jdbcCreateForeignPath(root, baserel, rows, startup_cost, total_cost,
+							 NIL, NULL));
+
+#if PG_VERSION_NUM >= 90600
+	/*
+	 * Join keys and ORDER BY can only be added to the query generated for
+	 * a table.  Paging orders the query by page_key itself.
+	 */
+	if (fpinfo->opts.table != NULL)
+	{
+		jdbcAddParamPaths(root, baserel);
+		if (fpinfo->opts.page_key == NULL)
+			jdbcAddSortedPaths(root, baserel, foreigntableid);
+	}
+#else
+	(void) fpinfo;
+#endif
+}
+
+/*
+ * jdbcGetForeignPlan
+ *		(9.2+) Get a foreign scan plan node
+ */
+static ForeignScan *
+jdbcGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid, ForeignPath *best_path, List *tlist, List *scan_clauses
+
+#if PG_VERSION_NUM >= 90500
+,
+/*
+* Require PostgreSQL >= 9.5
+*/
+
+Plan *outer_plan
+#endif
+)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	Index 		scan_relid = baserel->relid;
+	List		*fdw_private;
+	List		*fdw_exprs = NIL;
+	List		*param_vars = NIL;
+	List		*param_ops = NIL;
+	List		*filter_clauses = NIL;
+	char		*order_by = NULL;
+	ListCell	*lc;
+
+	SIGINTInterruptCheckProcess(NULL);
+
+	JVMInitialization(foreigntableid);
+
+#if PG_VERSION_NUM >= 90600
+	if (best_path->path.pathkeys != NIL)
+	{
+		order_by = jdbcDeparseOrderBy(baserel, foreigntableid, best_path->path.pathkeys);
+	}
+#endif
+
+#if PG_VERSION_NUM >= 90600
+	/*
+	 * A parameterized path sends its join keys as "column = ?".  The outer
+	 * side of each key goes into fdw_exprs, where the planner replaces its
+	 * references to the outer relations by Params.
+	 */
+	if (best_path->path.param_info != NULL)
+	{
+		foreach(lc, best_path->path.param_info->ppi_clauses)
+		{
+			Var	*var;
+			Expr	*param_expr;
+
+			if (jdbcIsParamJoinClause(baserel, (RestrictInfo *) lfirst(lc), &var, &param_expr))
+			{
+				param_vars = lappend(param_vars, var);
+				param_ops = lappend(param_ops, "=");
+				fdw_exprs = lappend(fdw_exprs, param_expr);
+			}
+		}
+	}
+#endif
+
+	/*
+	 * Equality quals on a constant or a query parameter are sent the same
+	 * way, so the remote server filters the rows and can keep one plan for
+	 * the query whatever the values are, and so are range quals on
+	 * numbers, dates and timestamps.  The other quals go to the Java
+	 * filter.
+	 */
+	foreach(lc, scan_clauses)
+	{
+		RestrictInfo	*rinfo = (RestrictInfo *) lfirst(lc);
+#if PG_VERSION_NUM >= 90600
+		Var		*var;
+		Expr		*param_expr;
+		char		*opname;
+
+		if (jdbcIsPushedQual(baserel, rinfo, &var, &param_expr, &opname))
+		{
+			param_vars = lappend(param_vars, var);
+			param_ops = lappend(param_ops, opname);
+			fdw_exprs = lappend(fdw_exprs, param_expr);
+			continue;
+		}
+#endif
+		if (!rinfo->pseudoconstant)
+			filter_clauses = lappend(filter_clauses, rinfo->clause);
+	}
+
+	scan_clauses = extract_actual_clauses(scan_clauses, false);
+
+	/*
+	 * All quals are still checked locally; the ones JDBCUtils can evaluate
+	 * are also applied in the JVM so that most failing rows never cross
+	 * into C.
+	 */
+	fdw_private = list_make4(jdbcRetrievedAttrs(baserel, scan_clauses),
+				 makeString(jdbcDeparseJavaFilter(baserel, filter_clauses)),
+				 makeInteger(jdbcGetMaxRows(root, baserel, best_path->path.pathkeys)),
+				 makeString(jdbcDeparseSelectSql(foreigntableid, &fpinfo->opts, param_vars, param_ops,
+								  order_by)));
+
+	/* Create the ForeignScan node */
+	return (make_foreignscan(tlist, scan_clauses, scan_relid, fdw_exprs, fdw_private
+#if PG_VERSION_NUM >= 90500
+,
+NIL,
+NIL,
+outer_plan
+#endif
+)); 
+}
+
+/*
+ * jdbcGetForeignRelSize
+ *		(9.2+) Get a foreign scan plan node
+ */
+static void
+jdbcGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+	jdbcFdwRelationInfo *fpinfo;
+
+	SIGINTInterruptCheckProcess(NULL);
+
+	fpinfo = (jdbcFdwRelationInfo *) palloc0(sizeof(jdbcFdwRelationInfo));
+	jdbcGetOptions(foreigntableid, &fpinfo->opts);
+	baserel->fdw_private = (void *) fpinfo;
+
+#if PG_VERSION_NUM >= 90600
+	/* Quals are only sent for tables, where the remote indexes matter */
+	if (fpinfo->opts.table != NULL && fpinfo->opts.use_remote_indexes)
+	{
+		fpinfo->indexes_known = jdbcGetRemoteIndexes(foreigntableid, &fpinfo->remote_indexes);
+	}
+#endif
+
+	/* Without statistics, assume a moderately sized remote table */
+	if (baserel->tuples <= 0)
+	{
+		baserel->tuples = DEFAULT_FDW_ROWS;
+	}
+
+	set_baserel_size_estimates(root, baserel);
+}
+
+/*
+ * jdbcCreateForeignPath
+ *		(9.2+) Create a ForeignPath for the foreign table, hiding the
+ *		differences of create_foreignscan_path between versions.
+ */
+static ForeignPath *
+jdbcCreateForeignPath(PlannerInfo *root, RelOptInfo *baserel, double rows,
+		      Cost startup_cost, Cost total_cost, List *pathkeys,
+		      Relids required_outer)
+{
+	return create_foreignscan_path(root, baserel,
+#if PG_VERSION_NUM >= 90600
+				       NULL,
+#endif
+				       rows, startup_cost, total_cost, pathkeys, required_outer,
+#if PG_VERSION_NUM >= 90500
+				       NULL,
+#endif
+#if PG_VERSION_NUM >= 170000
+				       NIL,
+#endif
+				       NIL);
+}
+
+/*
+ * jdbcEstimateCosts
+ *		(9.2+) Estimate the rows and costs of a scan of the foreign table,
+ *		parameterized by param_info unless it is NULL.  Only the rows
+ *		matching the quals sent to the remote server, including the
+ *		join keys of a parameterized scan, are transferred; the other
+ *		quals are checked locally.  A parameterized scan pays the
+ *		startup cost, and the remote server's search, on every rescan.
+ */
+static void
+jdbcEstimateCosts(PlannerInfo *root, RelOptInfo *baserel, ParamPathInfo *param_info,
+		  double *rows, Cost *startup_cost, Cost *total_cost)
+{
+	List		*quals = baserel->baserestrictinfo;
+	List		*remote_quals = NIL;
+	double		retrieved_rows;
+	Cost		remote_cost = 0;
+	QualCost	qual_cost;
+#if PG_VERSION_NUM >= 90600
+	Bitmapset	*eq_attrs = NULL;
+	Bitmapset	*range_attrs = NULL;
+	ListCell	*lc;
+
+	foreach(lc, baserel->baserestrictinfo)
+	{
+		RestrictInfo	*rinfo = (RestrictInfo *) lfirst(lc);
+		Var		*var;
+		Expr		*param_expr;
+		char		*opname;
+
+		if (jdbcIsPushedQual(baserel, rinfo, &var, &param_expr, &opname))
+		{
+			remote_quals = lappend(remote_quals, rinfo);
+			if (strcmp(opname, "=") == 0)
+				eq_attrs = bms_add_member(eq_attrs, var->varattno);
+			else
+				range_attrs = bms_add_member(range_attrs, var->varattno);
+		}
+	}
+
+	if (param_info != NULL)
+	{
+		foreach(lc, param_info->ppi_clauses)
+		{
+			Var		*var;
+
+			if (jdbcIsParamJoinClause(baserel, (RestrictInfo *) lfirst(lc), &var, NULL))
+			{
+				remote_quals = lappend(remote_quals, lfirst(lc));
+				eq_attrs = bms_add_member(eq_attrs, var->varattno);
+			}
+		}
+	}
+#endif
+
+	if (param_info != NULL)
+	{
+		*rows = param_info->ppi_rows;
+		quals = list_concat(list_copy(quals), param_info->ppi_clauses);
+	}
+	else
+	{
+		*rows = baserel->rows;
+	}
+
+	retrieved_rows = clamp_row_est(baserel->tuples *
+				       clauselist_selectivity(root, remote_quals, baserel->relid,
+							      JOIN_INNER, NULL));
+
+#if PG_VERSION_NUM >= 90600
+	remote_cost = jdbcRemoteScanCost(baserel, eq_attrs, range_attrs, retrieved_rows);
+#endif
+
+	cost_qual_eval(&qual_cost, quals, root);
+
+	*startup_cost = DEFAULT_FDW_STARTUP_COST + remote_cost + qual_cost.startup;
+	*total_cost = *startup_cost +
+		retrieved_rows * (DEFAULT_FDW_TUPLE_COST + cpu_tuple_cost + qual_cost.per_tuple);
+}
+
+/*
+ * jdbcDeparseSelectSql
+ *		(9.2+) Build the query sent to the remote server: the query
+ *		option as given, or a SELECT of the table with a "column op ?"
+ *		condition for each of the parameter columns, op being the
+ *		matching element of param_ops, ordered by order_by unless it is
+ *		NULL.
+ */
+static char *
+jdbcDeparseSelectSql(Oid foreigntableid, jdbcFdwOptions *opts, List *param_vars, List *param_ops,
+		     const char *order_by)
+{
+	StringInfoData	buf;
+	ListCell	*lc;
+	ListCell	*lc_op;
+
+	initStringInfo(&buf);
+
+	if (opts->query != NULL)
+	{
+		appendStringInfoString(&buf, opts->query);
+		return buf.data;
+	}
+
+	appendStringInfo(&buf, "SELECT * FROM %s", opts->table);
+
+	forboth(lc, param_vars, lc_op, param_ops)
+	{
+		appendStringInfo(&buf, "%s%s %s ?",
+				 (lc == list_head(param_vars)) ? " WHERE " : " AND ",
+				 jdbcColumnName(foreigntableid, ((Var *) lfirst(lc))->varattno),
+				 (char *) lfirst(lc_op));
+	}
+
+	if (order_by != NULL)
+	{
+		appendStringInfo(&buf, " ORDER BY %s", order_by);
+	}
+
+	return buf.data;
+}
+
+/*
+ * jdbcColumnName
+ *		(9.2+) Name of a column in the remote table: its column_name
+ *		option as given, or else the local name, quoted with the quote
+ *		string of the remote database where PostgreSQL would quote it.
+ */
+static char *
+jdbcColumnName(Oid foreigntableid, AttrNumber attnum)
+{
+	jdbcDialect	dialect;
+	char		*name;
+	ListCell	*lc;
+
+	foreach(lc, GetForeignColumnOptions(foreigntableid, attnum))
+	{
+		DefElem *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "column_name") == 0)
+		{
+			return defGetString(def);
+		}
+	}
+
+#if PG_VERSION_NUM >= 110000
+	name = get_attname(foreigntableid, attnum, false);
+#else
+	name = get_attname(foreigntableid, attnum);
+#endif
+
+	if (quote_identifier(name) == name)
+	{
+		return name;
+	}
+
+	jdbcGetDialect(foreigntableid, &dialect);
+
+	return jdbcQuoteName(name, dialect.quote);
+}
+
+/*
+ * jdbcQuoteName
+ *		Quote an identifier with quote, doubling the quotes in it.  A
+ *		database that quotes nothing gets it as is.
+ */
+static char *
+jdbcQuoteName(const char *name, const char *quote)
+{
+	StringInfoData	buf;
+	const char	*p;
+	int		quotelen = strlen(quote);
+
+	if (quotelen == 0)
+	{
+		return pstrdup(name);
+	}
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, quote);
+	for (p = name; *p != '\0'; p++)
+	{
+		if (strncmp(p, quote, quotelen) == 0)
+		{
+			appendStringInfoString(&buf, quote);
+		}
+		appendStringInfoChar(&buf, *p);
+	}
+	appendStringInfoString(&buf, quote);
+
+	return buf.data;
+}
+
+/*
+ * jdbcGetDialect
+ *		Fetch into dialect what the remote database of the server of a
+ *		foreign table accepts, asking the driver through a connection
+ *		for the table the first time.  If the driver cannot tell,
+ *		dialect->known is false and nothing is assumed of the remote
+ *		SQL but standard quoting.
+ */
+static void
+jdbcGetDialect(Oid foreigntableid, jdbcDialect *dialect)
+{
+	Oid		serverid = GetForeignTable(foreigntableid)->serverid;
+	jdbcDialectCacheEntry	*entry;
+	bool		found;
+
+	if (DialectCache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(jdbcDialectCacheEntry);
+		ctl.hash = tag_hash;
+		ctl.hcxt = CacheMemoryContext;
+		DialectCache = hash_create("jdbc_fdw dialects", 16, &ctl,
+					   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		CacheRegisterSyscacheCallback(FOREIGNSERVEROID, jdbcInvalidateDialectCache, (Datum) 0);
+	}
+
+	entry = (jdbcDialectCacheEntry *) hash_search(DialectCache, &serverid, HASH_ENTER, &found);
+	if (!found)
+	{
+		entry->valid = false;
+	}
+
+	if (!entry->valid)
+	{
+		jdbcFdwExecutionState *festate;
+		jdbcFdwOptions	opts;
+		Relation	rel;
+		jclass 		JDBCUtilsClass;
+		jmethodID	id_dialect;
+		jmethodID	id_returnresultseterrormessage;
+		jobjectArray	dialect_array;
+
+		JVMInitialization(foreigntableid);
+		jdbcGetOptions(foreigntableid, &opts);
+
+		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+		if (JDBCUtilsClass == NULL) 
+		{
+			elog(ERROR, "JDBCUtilsClass is NULL");
+		}
+
+		id_dialect = (*env)->GetMethodID(env, JDBCUtilsClass, "Dialect", "()[Ljava/lang/String;");
+		if (id_dialect == NULL) 
+		{
+			elog(ERROR, "id_dialect is NULL");
+		}
+
+		id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+		if (id_returnresultseterrormessage == NULL) 
+		{
+			elog(ERROR, "id_returnresultseterrormessage is NULL");
+		}
+
+		rel = table_open(foreigntableid, NoLock);
+		festate = jdbcCreateExecutionState(&opts, RelationGetDescr(rel), "", "", "", 0, 0, true);
+		table_close(rel, NoLock);
+
+		MemSet(&entry->dialect, 0, sizeof(jdbcDialect));
+		strlcpy(entry->dialect.quote, "\"", sizeof(entry->dialect.quote));
+
+		dialect_array = (*env)->CallObjectMethod(env, festate->java_call, id_dialect);
+		if (dialect_array == NULL)
+		{
+			jstring		error_string;
+			char		*error_cstring;
+
+			error_string = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultseterrormessage);
+			error_cstring = ConvertStringToCString((jobject) error_string);
+			elog(DEBUG1, "jdbc_fdw: cannot read the dialect of server %u: %s", serverid,
+			     error_cstring ? error_cstring : "");
+			if (error_cstring != NULL)
+			{
+				(*env)->ReleaseStringUTFChars(env, error_string, error_cstring);
+			}
+			(*env)->DeleteLocalRef(env, error_string);
+		}
+		else
+		{
+			char		*items[5];
+			int		i;
+
+			for (i = 0; i < lengthof(items); i++)
+			{
+				jobject		item = (*env)->GetObjectArrayElement(env, dialect_array, i);
+				char		*item_cstring = ConvertStringToCString(item);
+
+				items[i] = pstrdup(item_cstring);
+				(*env)->ReleaseStringUTFChars(env, (jstring) item, item_cstring);
+				(*env)->DeleteLocalRef(env, item);
+			}
+
+			strlcpy(entry->dialect.product, items[0], NAMEDATALEN);
+			strlcpy(entry->dialect.version, items[1], NAMEDATALEN);
+			entry->dialect.null_order = items[2][0];
+			entry->dialect.nulls_clause = (items[3][0] == 't');
+			strlcpy(entry->dialect.quote, items[4], sizeof(entry->dialect.quote));
+			entry->dialect.known = true;
+
+			elog(DEBUG1, "jdbc_fdw: server %u runs %s %s", serverid,
+			     entry->dialect.product, entry->dialect.version);
+
+			(*env)->DeleteLocalRef(env, dialect_array);
+		}
+
+		jdbcCloseExecutionState(&festate);
+		entry->valid = true;
+	}
+
+	*dialect = entry->dialect;
+}
+
+/*
+ * jdbcInvalidateDialectCache
+ *		Syscache callback: a changed server, e.g. with a new url, may be
+ *		another database, so its dialect is asked again.
+ */
+static void
+#if PG_VERSION_NUM >= 90200
+jdbcInvalidateDialectCache(Datum arg, int cacheid, uint32 hashvalue)
+#else
+jdbcInvalidateDialectCache(Datum arg, int cacheid, ItemPointer tuplePtr)
+#endif
+{
+	HASH_SEQ_STATUS		scan;
+	jdbcDialectCacheEntry	*entry;
+
+	hash_seq_init(&scan, DialectCache);
+	while ((entry = (jdbcDialectCacheEntry *) hash_seq_search(&scan)) != NULL)
+	{
+		entry->valid = false;
+	}
+}
+
+#if PG_VERSION_NUM >= 90600
+/*
+ * State of jdbcEcMemberMatches while collecting the join clauses
+ * implied by equivalence classes, one column at a time.
+ */
+typedef struct jdbcEcMemberArg
+{
+	Expr		*current;	/* column being looked at, or NULL */
+	List		*already_used;	/* columns looked at already */
+} jdbcEcMemberArg;
+
+/*
+ * jdbcAddParamPaths
+ *		(9.6+) Add a path parameterized by the outer relations of each
+ *		join clause that can be sent as "column = ?", so that a nested
+ *		loop fetches only the remote rows matching each outer row.
+ */
+static void
+jdbcAddParamPaths(PlannerInfo *root, RelOptInfo *baserel)
+{
+	List		*clauses = list_copy(baserel->joininfo);
+	List		*ppi_list = NIL;
+	ListCell	*lc;
+
+	/* Equality join clauses implied by equivalence classes */
+	if (baserel->has_eclass_joins)
+	{
+		jdbcEcMemberArg	arg;
+
+		arg.already_used = NIL;
+		for (;;)
+		{
+			List	*ec_clauses;
+
+			arg.current = NULL;
+			ec_clauses = generate_implied_equalities_for_column(root, baserel,
+									    jdbcEcMemberMatches,
+									    (void *) &arg,
+									    baserel->lateral_referencers);
+			if (arg.current == NULL)
+				break;
+
+			clauses = list_concat(clauses, ec_clauses);
+			arg.already_used = lappend(arg.already_used, arg.current);
+		}
+	}
+
+	foreach(lc, clauses)
+	{
+		RestrictInfo	*rinfo = (RestrictInfo *) lfirst(lc);
+		Relids		required_outer;
+
+		if (!join_clause_is_movable_to(rinfo, baserel) ||
+		    !jdbcIsParamJoinClause(baserel, rinfo, NULL, NULL))
+			continue;
+
+		required_outer = bms_union(rinfo->clause_relids, baserel->lateral_relids);
+		required_outer = bms_del_member(required_outer, baserel->relid);
+		if (bms_is_empty(required_outer))
+			continue;
+
+		ppi_list = list_append_unique_ptr(ppi_list,
+						  get_baserel_parampathinfo(root, baserel, required_outer));
+	}
+
+	foreach(lc, ppi_list)
+	{
+		ParamPathInfo	*param_info = (ParamPathInfo *) lfirst(lc);
+		double		rows;
+		Cost		startup_cost;
+		Cost		total_cost;
+
+		jdbcEstimateCosts(root, baserel, param_info, &rows, &startup_cost, &total_cost);
+		add_path(baserel, (Path *) jdbcCreateForeignPath(root, baserel, rows, startup_cost, total_cost,
+								 NIL, param_info->ppi_req_outer));
+	}
+}
+
+/*
+ * jdbcEcMemberMatches
+ *		(9.6+) Callback of generate_implied_equalities_for_column that
+ *		picks the first column not looked at yet, then only matches
+ *		members for that column.
+ */
+static bool
+jdbcEcMemberMatches(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec,
+		    EquivalenceMember *em, void *arg)
+{
+	jdbcEcMemberArg	*state = (jdbcEcMemberArg *) arg;
+
+	if (state->current != NULL)
+		return equal(em->em_expr, state->current);
+
+	if (list_member(state->already_used, em->em_expr))
+		return false;
+
+	state->current = em->em_expr;
+	return true;
+}
+
+/*
+ * jdbcIsParamJoinClause
+ *		(9.6+) Whether a join clause is "column = expression" with a
+ *		built-in equality operator on a type JDBCUtils binds, where the
+ *		expression only uses other relations and can be computed again
+ *		for each rescan.  If so, the column and the expression are
+ *		returned through var and param_expr when those are not NULL.
+ */
+static bool
+jdbcIsParamJoinClause(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr)
+{
+	OpExpr		*op;
+	Var		*column;
+	Expr		*other;
+	char		*opname;
+	bool		commuted;
+
+	if (!jdbcParamClauseParts(baserel, rinfo, &op, &column, &other, &commuted))
+		return false;
+
+	if (column == NULL || jdbcParamType(column->vartype) == NULL ||
+	    jdbcParamType(exprType((Node *) other)) == NULL ||
+	    contain_volatile_functions((Node *) other))
+		return false;
+
+	/* Remote string equality must not be stricter than ours */
+	if (!jdbcJavaFilterCollation(op->inputcollid))
+		return false;
+
+	opname = get_opname(op->opno);
+	if (opname == NULL || strcmp(opname, "=") != 0)
+		return false;
+
+	if (var != NULL)
+		*var = column;
+	if (param_expr != NULL)
+		*param_expr = other;
+
+	return true;
+}
+
+/*
+ * jdbcIsRangeQual
+ *		(9.6+) Whether a qual compares a number, date or timestamp column
+ *		with <, <=, > or >= to a constant or a query parameter of the
+ *		same kind, which the remote server compares as we do.  If so,
+ *		the column, the value and the operator to write with the column
+ *		on its left are returned through var, param_expr and opname.
+ */
+static bool
+jdbcIsRangeQual(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr,
+		char **opname)
+{
+	OpExpr		*op;
+	Var		*column;
+	Expr		*other;
+	char		*name;
+	bool		commuted;
+
+	if (!jdbcParamClauseParts(baserel, rinfo, &op, &column, &other, &commuted))
+		return false;
+
+	if (column == NULL || (!IsA(other, Const) && !IsA(other, Param)) ||
+	    jdbcParamType(column->vartype) == NULL ||
+	    jdbcParamType(exprType((Node *) other)) == NULL)
+		return false;
+
+	name = get_opname(op->opno);
+	if (name == NULL ||
+	    (strcmp(name, "<") != 0 && strcmp(name, "<=") != 0 &&
+	     strcmp(name, ">") != 0 && strcmp(name, ">=") != 0) ||
+	    !jdbcIsRemoteOperator(name, column->vartype, exprType((Node *) other)))
+		return false;
+
+	/* "value < column" is sent as "column > ?" */
+	if (commuted)
+	{
+		if (name[0] == '<')
+			name[0] = '>';
+		else
+			name[0] = '<';
+	}
+
+	*var = column;
+	*param_expr = other;
+	*opname = name;
+
+	return true;
+}
+
+/*
+ * jdbcParamClauseParts
+ *		(9.6+) Split a clause that applies a built-in binary operator to
+ *		a column of baserel and to an expression that does not use
+ *		baserel.  commuted is set if the column is the right operand.
+ */
+static bool
+jdbcParamClauseParts(RelOptInfo *baserel, RestrictInfo *rinfo, OpExpr **op, Var **column,
+		     Expr **other, bool *commuted)
+{
+	if (!IsA(rinfo->clause, OpExpr))
+		return false;
+
+	*op = (OpExpr *) rinfo->clause;
+	if (list_length((*op)->args) != 2 || (*op)->opno >= JDBC_BUILTIN_OID_LIMIT)
+		return false;
+
+	if (bms_is_member(baserel->relid, rinfo->left_relids) &&
+	    !bms_is_member(baserel->relid, rinfo->right_relids))
+	{
+		*column = jdbcJavaFilterVar((Node *) linitial((*op)->args), baserel->relid);
+		*other = (Expr *) lsecond((*op)->args);
+		*commuted = false;
+	}
+	else if (bms_is_member(baserel->relid, rinfo->right_relids) &&
+		 !bms_is_member(baserel->relid, rinfo->left_relids))
+	{
+		*column = jdbcJavaFilterVar((Node *) lsecond((*op)->args), baserel->relid);
+		*other = (Expr *) linitial((*op)->args);
+		*commuted = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * jdbcIsPushedQual
+ *		(9.6+) Whether a qual of a foreign table defined with the table
+ *		option is sent to the remote server: an equality, or a range
+ *		qual as jdbcIsRangeQual allows, of a column and a constant or a
+ *		query parameter.  If so, the column, the value and the operator
+ *		are returned through var, param_expr and opname.
+ */
+static bool
+jdbcIsPushedQual(RelOptInfo *baserel, RestrictInfo *rinfo, Var **var, Expr **param_expr,
+		 char **opname)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+
+	if (fpinfo->opts.table == NULL || rinfo->pseudoconstant ||
+	    !bms_equal(rinfo->clause_relids, baserel->relids))
+		return false;
+
+	if (jdbcIsParamJoinClause(baserel, rinfo, var, param_expr) &&
+	    (IsA(*param_expr, Const) || IsA(*param_expr, Param)))
+	{
+		*opname = "=";
+		return true;
+	}
+
+	return jdbcIsRangeQual(baserel, rinfo, var, param_expr, opname);
+}
+
+/*
+ * jdbcGetRemoteIndexes
+ *		(9.6+) Return through indexes a List per index of the remote
+ *		table of the attribute numbers of its leading columns that are
+ *		columns of the foreign table.  The driver is asked once per
+ *		backend, and again after the options change.  Returns false if
+ *		it could not describe the indexes, which are then not used.
+ */
+static bool
+jdbcGetRemoteIndexes(Oid foreigntableid, List **indexes)
+{
+	jdbcOptionsCacheEntry	*entry;
+	jdbcFdwOptions	opts;
+	Relation	rel;
+	ListCell	*lc;
+
+	*indexes = NIL;
+
+	jdbcGetOptions(foreigntableid, &opts);
+	entry = jdbcGetOptionsCacheEntry(foreigntableid);
+
+	rel = table_open(foreigntableid, NoLock);
+
+	if (!entry->indexes_loaded)
+	{
+		jdbcFdwExecutionState *festate;
+		jclass 		JDBCUtilsClass;
+		jmethodID	id_indexcolumns;
+		jmethodID	id_returnresultseterrormessage;
+		jstring		table_string;
+		jobjectArray	index_array;
+		MemoryContext	oldcontext;
+		int		i;
+
+		JVMInitialization(foreigntableid);
+
+		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+		if (JDBCUtilsClass == NULL) 
+		{
+			elog(ERROR, "JDBCUtilsClass is NULL");
+		}
+
+		id_indexcolumns = (*env)->GetMethodID(env, JDBCUtilsClass, "IndexColumns", "(Ljava/lang/String;)[[Ljava/lang/String;");
+		if (id_indexcolumns == NULL) 
+		{
+			elog(ERROR, "id_indexcolumns is NULL");
+		}
+
+		id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+		if (id_returnresultseterrormessage == NULL) 
+		{
+			elog(ERROR, "id_returnresultseterrormessage is NULL");
+		}
+
+		festate = jdbcCreateExecutionState(&opts, RelationGetDescr(rel), "", "", "", 0, 0, true);
+
+		table_string = (*env)->NewStringUTF(env, opts.table);
+		index_array = (*env)->CallObjectMethod(env, festate->java_call, id_indexcolumns, table_string);
+
+		entry->indexes_known = (index_array != NULL);
+		entry->indexes = NIL;
+
+		if (index_array == NULL)
+		{
+			jstring		error_string;
+			char		*error_cstring;
+
+			/* Not all drivers describe indexes; cost without them */
+			error_string = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultseterrormessage);
+			error_cstring = ConvertStringToCString((jobject) error_string);
+			elog(DEBUG1, "jdbc_fdw: cannot read the indexes of %s: %s", opts.table,
+			     error_cstring ? error_cstring : "");
+			if (error_cstring != NULL)
+			{
+				(*env)->ReleaseStringUTFChars(env, error_string, error_cstring);
+			}
+			(*env)->DeleteLocalRef(env, error_string);
+		}
+		else
+		{
+			oldcontext = MemoryContextSwitchTo(entry->cxt);
+			for (i = 0; i < (*env)->GetArrayLength(env, index_array); i++)
+			{
+				jobjectArray	column_array = (*env)->GetObjectArrayElement(env, index_array, i);
+				List		*columns = NIL;
+				int		j;
+
+				for (j = 0; j < (*env)->GetArrayLength(env, column_array); j++)
+				{
+					jobject		column = (*env)->GetObjectArrayElement(env, column_array, j);
+					char		*column_cstring = ConvertStringToCString(column);
+
+					columns = lappend(columns, pstrdup(column_cstring));
+					(*env)->ReleaseStringUTFChars(env, (jstring) column, column_cstring);
+					(*env)->DeleteLocalRef(env, column);
+				}
+				entry->indexes = lappend(entry->indexes, columns);
+				(*env)->DeleteLocalRef(env, column_array);
+			}
+			MemoryContextSwitchTo(oldcontext);
+
+			(*env)->DeleteLocalRef(env, index_array);
+		}
+
+		(*env)->DeleteLocalRef(env, table_string);
+		jdbcCloseExecutionState(&festate);
+
+		entry->indexes_loaded = true;
+	}
+
+	/*
+	 * Map the names now, as column_name options may have changed.  An
+	 * index is only useful up to its first column the foreign table does
+	 * not have.
+	 */
+	foreach(lc, entry->indexes)
+	{
+		List		*attnos = NIL;
+		ListCell	*lc_column;
+
+		foreach(lc_column, (List *) lfirst(lc))
+		{
+			AttrNumber	attno = jdbcRemoteColumnAttno(rel, (char *) lfirst(lc_column));
+
+			if (attno == InvalidAttrNumber)
+				break;
+			attnos = lappend_int(attnos, attno);
+		}
+
+		if (attnos != NIL)
+			*indexes = lappend(*indexes, attnos);
+	}
+
+	table_close(rel, NoLock);
+
+	return entry->indexes_known;
+}
+
+/*
+ * jdbcRemoteScanCost
+ *		(9.6+) Cost of the remote server finding the rows of a scan that
+ *		sends "column = ?" for the columns of eq_attrs and range quals
+ *		for those of range_attrs.  With a remote index leading with one
+ *		of them, the rows are looked up through it; otherwise the whole
+ *		remote table is read.  Nothing is charged when the remote
+ *		indexes are not known.
+ */
+static Cost
+jdbcRemoteScanCost(RelOptInfo *baserel, Bitmapset *eq_attrs, Bitmapset *range_attrs,
+		   double retrieved_rows)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	ListCell	*lc;
+
+	if (!fpinfo->indexes_known)
+		return 0;
+
+	foreach(lc, fpinfo->remote_indexes)
+	{
+		int		leading = linitial_int((List *) lfirst(lc));
+
+		if (bms_is_member(leading, eq_attrs) || bms_is_member(leading, range_attrs))
+			return cpu_operator_cost * ceil(log(Max(baserel->tuples, 2.0)) / log(2.0)) +
+				retrieved_rows * (cpu_index_tuple_cost + cpu_tuple_cost);
+	}
+
+	return baserel->tuples * (cpu_tuple_cost + cpu_operator_cost);
+}
+
+/*
+ * jdbcAddSortedPaths
+ *		(9.6+) Add a path whose query has the remote server sort the
+ *		rows for each useful sort order, so that ORDER BY, merge joins
+ *		and sorted aggregates read them as they stream in rather than
+ *		through a local Sort.  The remote sort is charged like a local
+ *		one that fits in memory, unless a remote index leads with the
+ *		first sort column and the query can use it.
+ */
+static void
+jdbcAddSortedPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	List		*useful = jdbcUsefulPathkeys(root, baserel);
+	Relation	rel;
+	ListCell	*lc;
+
+	if (useful == NIL)
+		return;
+
+	rel = table_open(foreigntableid, NoLock);
+	jdbcGetDialect(foreigntableid, &fpinfo->dialect);
+
+	foreach(lc, useful)
+	{
+		List		*pathkeys = (List *) lfirst(lc);
+		Var		*first = jdbcOrderByVar(baserel, (PathKey *) linitial(pathkeys));
+		bool		index_ordered = false;
+		double		rows;
+		Cost		startup_cost;
+		Cost		total_cost;
+		ListCell	*lc_index;
+
+		jdbcEstimateCosts(root, baserel, NULL, &rows, &startup_cost, &total_cost);
+
+		/* An index cannot give the order of a CASE on the column */
+		if (fpinfo->indexes_known &&
+		    jdbcNullsOrdering(&fpinfo->dialect, rel, first, (PathKey *) linitial(pathkeys)) != 'x')
+		{
+			foreach(lc_index, fpinfo->remote_indexes)
+			{
+				if (linitial_int((List *) lfirst(lc_index)) == first->varattno)
+					index_ordered = true;
+			}
+		}
+
+		if (!index_ordered)
+		{
+			Cost		sort_cost;
+			double		sorted_rows = Max(rows, 2.0);
+
+			sort_cost = 2.0 * cpu_operator_cost * sorted_rows * log(sorted_rows) / log(2.0);
+			startup_cost += sort_cost;
+			total_cost += sort_cost;
+		}
+
+		add_path(baserel, (Path *) jdbcCreateForeignPath(root, baserel, rows, startup_cost, total_cost,
+								 pathkeys, NULL));
+	}
+
+	table_close(rel, NoLock);
+}
+
+/*
+ * jdbcUsefulPathkeys
+ *		(9.6+) Sort orders worth asking the remote server for: that of
+ *		the query, if all its columns can be sorted remotely, and each
+ *		column of a merge join clause.
+ */
+static List *
+jdbcUsefulPathkeys(PlannerInfo *root, RelOptInfo *baserel)
+{
+	List		*useful = NIL;
+	ListCell	*lc;
+
+	if (root->query_pathkeys != NIL)
+	{
+		bool		pushable = true;
+
+		foreach(lc, root->query_pathkeys)
+		{
+			if (jdbcOrderByVar(baserel, (PathKey *) lfirst(lc)) == NULL)
+				pushable = false;
+		}
+
+		if (pushable)
+			useful = lappend(useful, root->query_pathkeys);
+	}
+
+	if (!baserel->has_eclass_joins)
+		return useful;
+
+	foreach(lc, root->eq_classes)
+	{
+		EquivalenceClass *ec = (EquivalenceClass *) lfirst(lc);
+		PathKey		*pathkey;
+
+		if (ec->ec_has_volatile || list_length(ec->ec_opfamilies) == 0 ||
+		    !bms_is_subset(baserel->relids, ec->ec_relids) ||
+		    !eclass_useful_for_merging(root, ec, baserel))
+			continue;
+
+		pathkey = make_canonical_pathkey(root, ec, linitial_oid(ec->ec_opfamilies),
+						 JDBC_PATHKEY_ASC, false);
+		if (jdbcOrderByVar(baserel, pathkey) == NULL)
+			continue;
+
+		/* The query order may already start with it */
+		if (root->query_pathkeys != NIL && list_length(root->query_pathkeys) == 1 &&
+		    linitial(root->query_pathkeys) == pathkey)
+			continue;
+
+		useful = lappend(useful, list_make1(pathkey));
+	}
+
+	return useful;
+}
+
+/*
+ * jdbcOrderByVar
+ *		(9.6+) The column of baserel a pathkey sorts on, if the remote
+ *		server sorts its values as we do: a number, date or timestamp
+ *		column sorted by its built-in btree operators.  Strings are left
+ *		out as the remote collation may differ, and floats as they may
+ *		hold NaN.  Returns NULL for other pathkeys.
+ */
+static Var *
+jdbcOrderByVar(RelOptInfo *baserel, PathKey *pathkey)
+{
+	EquivalenceClass *ec = pathkey->pk_eclass;
+	ListCell	*lc;
+
+	if (ec->ec_has_volatile)
+		return NULL;
+
+	foreach(lc, ec->ec_members)
+	{
+		EquivalenceMember *em = (EquivalenceMember *) lfirst(lc);
+		Var		*var;
+		Oid		sortop;
+		char		kind;
+
+		if (em->em_is_child || !bms_equal(em->em_relids, baserel->relids))
+			continue;
+
+		var = jdbcJavaFilterVar((Node *) em->em_expr, baserel->relid);
+		if (var == NULL || jdbcParamType(var->vartype) == NULL)
+			continue;
+
+		kind = jdbcRemoteTypeKind(var->vartype);
+		if (kind != 'n' && kind != 'd' && kind != 't' && kind != 'z')
+			continue;
+
+		sortop = get_opfamily_member(pathkey->pk_opfamily, var->vartype, var->vartype,
+					     JDBC_PATHKEY_IS_DESC(pathkey) ?
+					     BTGreaterStrategyNumber : BTLessStrategyNumber);
+		if (!OidIsValid(sortop) || sortop >= JDBC_BUILTIN_OID_LIMIT)
+			continue;
+
+		return var;
+	}
+
+	return NULL;
+}
+
+/*
+ * jdbcDeparseOrderBy
+ *		(9.6+) Build the ORDER BY list of the remote query for pathkeys,
+ *		placing the NULLs of each column as jdbcNullsOrdering says.
+ */
+static char *
+jdbcDeparseOrderBy(RelOptInfo *baserel, Oid foreigntableid, List *pathkeys)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	StringInfoData	buf;
+	Relation	rel;
+	ListCell	*lc;
+
+	initStringInfo(&buf);
+	rel = table_open(foreigntableid, NoLock);
+
+	foreach(lc, pathkeys)
+	{
+		PathKey		*pathkey = (PathKey *) lfirst(lc);
+		Var		*var = jdbcOrderByVar(baserel, pathkey);
+		char		*column;
+		char		nulls;
+
+		if (var == NULL)
+			elog(ERROR, "could not find pathkey column to sort remotely");
+
+		column = jdbcColumnName(foreigntableid, var->varattno);
+		nulls = jdbcNullsOrdering(&fpinfo->dialect, rel, var, pathkey);
+
+		if (buf.len > 0)
+			appendStringInfoString(&buf, ", ");
+
+		if (nulls == 'x')
+			appendStringInfo(&buf, "CASE WHEN %s IS NULL THEN %d ELSE %d END, ",
+					 column, pathkey->pk_nulls_first ? 0 : 1,
+					 pathkey->pk_nulls_first ? 1 : 0);
+
+		appendStringInfo(&buf, "%s%s", column, JDBC_PATHKEY_IS_DESC(pathkey) ? " DESC" : "");
+
+		if (nulls == 'c')
+			appendStringInfoString(&buf, pathkey->pk_nulls_first ? " NULLS FIRST" : " NULLS LAST");
+	}
+
+	table_close(rel, NoLock);
+
+	return buf.data;
+}
+
+/*
+ * jdbcNullsOrdering
+ *		(9.6+) How the remote ORDER BY puts the NULLs of a column where
+ *		the pathkey wants them: 'n' if nothing is needed, as the column
+ *		is NOT NULL or the remote server already sorts NULLs there, 'c'
+ *		for a NULLS FIRST or NULLS LAST clause, or 'x' for a CASE on
+ *		the column placed before it, which any database accepts.
+ */
+static char
+jdbcNullsOrdering(jdbcDialect *dialect, Relation rel, Var *var, PathKey *pathkey)
+{
+	bool		desc = JDBC_PATHKEY_IS_DESC(pathkey);
+	bool		nulls_first;
+
+	if (TupleDescAttr(RelationGetDescr(rel), var->varattno - 1)->attnotnull)
+		return 'n';
+
+	switch (dialect->null_order)
+	{
+		case 'h':
+			nulls_first = desc;
+			break;
+		case 'l':
+			nulls_first = !desc;
+			break;
+		case 's':
+			nulls_first = true;
+			break;
+		case 'e':
+			nulls_first = false;
+			break;
+		default:
+			return dialect->nulls_clause ? 'c' : 'x';
+	}
+
+	if (nulls_first == pathkey->pk_nulls_first)
+		return 'n';
+
+	return dialect->nulls_clause ? 'c' : 'x';
+}
+#endif
+
+/*
+ * jdbcRetrievedAttrs
+ *		(9.2+) Build the integer list of attribute numbers that the scan
+ *		has to return: those used by the target list or by the quals
+ *		evaluated locally.  A whole-row reference needs every column.
+ */
+static List *
+jdbcRetrievedAttrs(RelOptInfo *baserel, List *scan_clauses)
+{
+	Bitmapset	*attrs_used = NULL;
+	List		*retrieved_attrs = NIL;
+	int		natts = baserel->max_attr;
+	int		attnum;
+
+#if PG_VERSION_NUM >= 90600
+	pull_varattnos((Node *) baserel->reltarget->exprs, baserel->relid, &attrs_used);
+#else
+	pull_varattnos((Node *) baserel->reltargetlist, baserel->relid, &attrs_used);
+#endif
+	pull_varattnos((Node *) scan_clauses, baserel->relid, &attrs_used);
+
+	for (attnum = 1; attnum <= natts; attnum++)
+	{
+		if (bms_is_member(0 - FirstLowInvalidHeapAttributeNumber, attrs_used) ||
+		    bms_is_member(attnum - FirstLowInvalidHeapAttributeNumber, attrs_used))
+		{
+			retrieved_attrs = lappend_int(retrieved_attrs, attnum);
+		}
+	}
+
+	return retrieved_attrs;
+}
+
+/*
+ * jdbcGetMaxRows
+ *		(9.2+) If the query is a plain scan of this foreign table with a
+ *		constant LIMIT, return how many rows it can read at most: LIMIT
+ *		plus OFFSET.  Anything that may discard or reorder rows before
+ *		the LIMIT applies (quals, joins, grouping, sorting, set-returning
+ *		functions) makes the bound unknown, and 0 is returned, unless
+ *		the scan's pathkeys already give the sort order.
+ */
+static int
+jdbcGetMaxRows(PlannerInfo *root, RelOptInfo *baserel, List *pathkeys)
+{
+	Query		*parse = root->parse;
+	int64		bound;
+
+	if (parse->limitCount == NULL || !IsA(parse->limitCount, Const) ||
+	    ((Const *) parse->limitCount)->constisnull)
+		return 0;
+
+	if (parse->limitOffset != NULL &&
+	    (!IsA(parse->limitOffset, Const) || ((Const *) parse->limitOffset)->constisnull))
+		return 0;
+
+	if (baserel->baserestrictinfo != NIL ||
+	    bms_membership(root->all_baserels) != BMS_SINGLETON ||
+	    parse->groupClause != NIL || parse->hasAggs || parse->havingQual != NULL ||
+	    parse->hasWindowFuncs || parse->distinctClause != NIL ||
+	    (parse->sortClause != NIL && !pathkeys_contained_in(root->sort_pathkeys, pathkeys)) ||
+	    parse->setOperations != NULL ||
+	    parse->rowMarks != NIL
+#if PG_VERSION_NUM >= 100000
+	    || parse->hasTargetSRFs
+#endif
+#if PG_VERSION_NUM >= 130000
+	    || parse->limitOption == LIMIT_OPTION_WITH_TIES
+#endif
+	    )
+		return 0;
+
+	bound = DatumGetInt64(((Const *) parse->limitCount)->constvalue);
+	if (parse->limitOffset != NULL)
+		bound += DatumGetInt64(((Const *) parse->limitOffset)->constvalue);
+
+	if (bound <= 0 || bound > INT_MAX)
+		return 0;
+
+	return (int) bound;
+}
+
+/*
+ * jdbcDeparseJavaFilter
+ *		(9.2+) Build the filter string for the quals that JDBCUtils can
+ *		evaluate on the raw column values.  Each qual is written as
+ *		'|'-separated tokens: the operator, the column number, the kind
+ *		of comparison ('n' numeric or 's' string) and the constants, and
+ *		ends with ';'.  The Java evaluator only has to be a prefilter:
+ *		it may pass rows the qual rejects, but must never reject a row
+ *		the qual passes, so only operators whose semantics match exactly
+ *		are shipped.
+ */
+static char *
+jdbcDeparseJavaFilter(RelOptInfo *baserel, List *scan_clauses)
+{
+	StringInfoData	buf;
+	ListCell	*lc;
+
+	initStringInfo(&buf);
+
+	foreach(lc, scan_clauses)
+	{
+		jdbcDeparseJavaFilterClause((Expr *) lfirst(lc), baserel->relid, &buf);
+	}
+
+	return buf.data;
+}
+
+/*
+ * jdbcDeparseJavaFilterClause
+ *		(9.2+) Append a qual to the Java filter string if it is a column
+ *		compared with constants by one of the supported built-in
+ *		operators.  Returns whether the qual was appended.
+ */
+static bool
+jdbcDeparseJavaFilterClause(Expr *clause, Index relid, StringInfo buf)
+{
+	StringInfoData	pred;
+	Var		*var;
+	Const		*cnst;
+	Oid		opno;
+	Oid		collid;
+	char		*opname;
+	char		kind;
+	char		attnum[MAX_INT32_STRLEN];
+	char		kindstr[2];
+	Oid		typoutput;
+	bool		typisvarlena;
+
+	if (IsA(clause, OpExpr))
+	{
+		OpExpr	*op = (OpExpr *) clause;
+		Node	*left;
+		Node	*right;
+
+		if (list_length(op->args) != 2)
+			return false;
+
+		left = (Node *) linitial(op->args);
+		right = (Node *) lsecond(op->args);
+		opno = op->opno;
+		collid = op->inputcollid;
+
+		var = jdbcJavaFilterVar(left, relid);
+		if (var == NULL)
+		{
+			/* Try const op column, using the commutator */
+			var = jdbcJavaFilterVar(right, relid);
+			right = left;
+			opno = get_commutator(opno);
+		}
+
+		if (var == NULL || !OidIsValid(opno) || !IsA(right, Const))
+			return false;
+		cnst = (Const *) right;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+
+		if (!saop->useOr || list_length(saop->args) != 2)
+			return false;
+
+		var = jdbcJavaFilterVar((Node *) linitial(saop->args), relid);
+		if (var == NULL || !IsA(lsecond(saop->args), Const))
+			return false;
+
+		cnst = (Const *) lsecond(saop->args);
+		opno = saop->opno;
+		collid = saop->inputcollid;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (opno >= JDBC_BUILTIN_OID_LIMIT || cnst->constisnull)
+		return false;
+
+	kind = jdbcJavaFilterKind(var->vartype, var->vartypmod);
+	if (kind == '\0')
+		return false;
+
+	opname = get_opname(opno);
+	if (opname == NULL)
+		return false;
+
+	initStringInfo(&pred);
+
+	if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ArrayType	*array;
+		Oid		elemtype = get_element_type(cnst->consttype);
+		int16		typlen;
+		bool		typbyval;
+		char		typalign;
+		Datum		*elems;
+		bool		*elemnulls;
+		int		nelems;
+		int		i;
+
+		if (strcmp(opname, "=") != 0 || !OidIsValid(elemtype) ||
+		    jdbcJavaFilterKind(elemtype, -1) != kind)
+			return false;
+		if (kind == 's' && !jdbcJavaFilterCollation(collid))
+			return false;
+
+		jdbcAppendJavaFilterToken(&pred, "in");
+
+		array = DatumGetArrayTypeP(cnst->constvalue);
+		get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+		deconstruct_array(array, elemtype, typlen, typbyval, typalign,
+				  &elems, &elemnulls, &nelems);
+		getTypeOutputInfo(elemtype, &typoutput, &typisvarlena);
+
+		snprintf(attnum, sizeof(attnum), "%d", var->varattno);
+		kindstr[0] = kind;
+		kindstr[1] = '\0';
+		jdbcAppendJavaFilterToken(&pred, attnum);
+		jdbcAppendJavaFilterToken(&pred, kindstr);
+
+		/* NULL elements can never make the qual true */
+		for (i = 0; i < nelems; i++)
+		{
+			char	*value;
+
+			if (elemnulls[i])
+				continue;
+
+			value = OidOutputFunctionCall(typoutput, elems[i]);
+			if (!jdbcIsJavaSafeString(value))
+				return false;
+			jdbcAppendJavaFilterToken(&pred, value);
+		}
+	}
+	else
+	{
+		char	*value;
+
+		if (jdbcJavaFilterKind(cnst->consttype, -1) != kind)
+			return false;
+
+		getTypeOutputInfo(cnst->consttype, &typoutput, &typisvarlena);
+		value = OidOutputFunctionCall(typoutput, cnst->constvalue);
+		if (!jdbcIsJavaSafeString(value))
+			return false;
+
+		if (kind == 'n')
+		{
+			if (strcmp(opname, "=") != 0 && strcmp(opname, "<>") != 0 &&
+			    strcmp(opname, "<") != 0 && strcmp(opname, "<=") != 0 &&
+			    strcmp(opname, ">") != 0 && strcmp(opname, ">=") != 0)
+				return false;
+			jdbcAppendJavaFilterToken(&pred, opname);
+		}
+		else
+		{
+			/* Ordering of strings depends on the collation; skip it */
+			if (!jdbcJavaFilterCollation(collid))
+				return false;
+
+			if (strcmp(opname, "=") == 0 || strcmp(opname, "<>") == 0)
+				jdbcAppendJavaFilterToken(&pred, opname);
+			else if (strcmp(opname, "~~") == 0)
+				jdbcAppendJavaFilterToken(&pred, "like");
+			else if (strcmp(opname, "!~~") == 0)
+				jdbcAppendJavaFilterToken(&pred, "notlike");
+			else if ((strcmp(opname, "~") == 0 || strcmp(opname, "!~") == 0) &&
+				 jdbcIsPortableRegex(value))
+				jdbcAppendJavaFilterToken(&pred, opname);
+			else
+				return false;
+		}
+
+		snprintf(attnum, sizeof(attnum), "%d", var->varattno);
+		kindstr[0] = kind;
+		kindstr[1] = '\0';
+		jdbcAppendJavaFilterToken(&pred, attnum);
+		jdbcAppendJavaFilterToken(&pred, kindstr);
+		jdbcAppendJavaFilterToken(&pred, value);
+	}
+
+	/* Replace the separator after the last token by the terminator */
+	pred.data[pred.len - 1] = ';';
+	appendStringInfoString(buf, pred.data);
+
+	return true;
+}
+
+/*
+ * jdbcJavaFilterVar
+ *		(9.2+) Return the column of the scanned relation that node refers
+ *		to, looking through binary-compatible casts, or NULL.
+ */
+static Var *
+jdbcJavaFilterVar(Node *node, Index relid)
+{
+	Var	*var;
+
+	while (node != NULL && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (node == NULL || !IsA(node, Var))
+		return NULL;
+
+	var = (Var *) node;
+	if (var->varno != relid || var->varlevelsup != 0 || var->varattno <= 0)
+		return NULL;
+
+	return var;
+}
+
+/*
+ * jdbcJavaFilterKind
+ *		(9.2+) How values of a type are compared by the Java filter: 'n'
+ *		for exact numbers, 's' for strings, or '\0' if they are not.
+ *		Columns whose input function rounds or trims the remote value
+ *		(numeric and varchar with a typmod) are excluded, as are floats
+ *		whose decimal text does not identify the binary value.
+ */
+static char
+jdbcJavaFilterKind(Oid type, int32 typmod)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return 'n';
+		case NUMERICOID:
+			return (typmod == -1) ? 'n' : '\0';
+		case TEXTOID:
+			return 's';
+		case VARCHAROID:
+			return (typmod == -1) ? 's' : '\0';
+		default:
+			return '\0';
+	}
+}
+
+/*
+ * jdbcJavaFilterCollation
+ *		(9.2+) Whether string equality under the collation is plain
+ *		character equality.
+ */
+static bool
+jdbcJavaFilterCollation(Oid collid)
+{
+	return (collid == InvalidOid || collid == DEFAULT_COLLATION_OID ||
+		collid == C_COLLATION_OID || collid == POSIX_COLLATION_OID);
+}
+
+/*
+ * jdbcIsJavaSafeString
+ *		(9.2+) Whether str reaches the JVM unchanged through NewStringUTF:
+ *		plain ASCII, or UTF-8 without characters outside the Basic
+ *		Multilingual Plane.
+ */
+static bool
+jdbcIsJavaSafeString(const char *str)
+{
+	const unsigned char *p;
+	bool		utf8 = (GetDatabaseEncoding() == PG_UTF8);
+
+	for (p = (const unsigned char *) str; *p; p++)
+	{
+		if (*p >= 0x80 && (!utf8 || *p >= 0xF0))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * jdbcIsPortableRegex
+ *		(9.2+) Whether a POSIX regular expression only uses constructs
+ *		that java.util.regex interprets the same way: literals, '.',
+ *		anchors, alternation, groups, quantifiers and simple bracket
+ *		expressions.  Character class escapes, nested brackets and
+ *		embedded options are rejected.
+ */
+static bool
+jdbcIsPortableRegex(const char *pattern)
+{
+	const char	*p;
+	bool		in_bracket = false;
+
+	if (strncmp(pattern, "***", 3) == 0)
+		return false;
+
+	for (p = pattern; *p; p++)
+	{
+		switch (*p)
+		{
+			case '\\':
+				/* Only escaped punctuation means the same literal */
+				if (!ispunct((unsigned char) p[1]))
+					return false;
+				p++;
+				break;
+			case '[':
+				if (in_bracket)
+					return false;
+				in_bracket = true;
+				if (p[1] == '^')
+					p++;
+				if (p[1] == ']')
+					return false;
+				break;
+			case ']':
+				in_bracket = false;
+				break;
+			case '(':
+				if (p[1] == '?')
+					return false;
+				break;
+			case '&':
+				if (in_bracket)
+					return false;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return !in_bracket;
+}
+
+/*
+ * jdbcAppendJavaFilterToken
+ *		(9.2+) Append a token and the '|' separator to a Java filter
+ *		string, escaping the characters that delimit tokens.
+ */
+static void
+jdbcAppendJavaFilterToken(StringInfo buf, const char *token)
+{
+	const char	*p;
+
+	for (p = token; *p; p++)
+	{
+		if (*p == '\\' || *p == '|' || *p == ';')
+			appendStringInfoChar(buf, '\\');
+		appendStringInfoChar(buf, *p);
+	}
+	appendStringInfoChar(buf, '|');
+}
+#endif
+
+/*
+ * jdbcRetrievedAttrsString
+ *		Format a list of attribute numbers as the comma separated list of
+ *		result columns passed to JDBCUtils.
+ */
+static char *
+jdbcRetrievedAttrsString(List *retrieved_attrs)
+{
+	StringInfoData	buf;
+	ListCell	*lc;
+
+	initStringInfo(&buf);
+	foreach(lc, retrieved_attrs)
+	{
+		appendStringInfo(&buf, "%s%d", (buf.len > 0) ? "," : "", lfirst_int(lc));
+	}
+
+	return buf.data;
+}
+
+#if (PG_VERSION_NUM >= 90300)
+/*
+ * jdbcIsForeignRelUpdatable
+ *		(9.3+) Foreign tables defined with the table option accept
+ *		INSERT, UPDATE and DELETE.
+ */
+static int
+jdbcIsForeignRelUpdatable(Relation rel)
+{
+	jdbcFdwOptions	opts;
+
+	jdbcGetOptions(RelationGetRelid(rel), &opts);
+
+	if (opts.table == NULL)
+		return 0;
+
+	return (1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE);
+}
+
+/*
+ * jdbcAddForeignUpdateTargets
+ *		(9.3+) Have the scan of an UPDATE or DELETE return the key
+ *		columns as junk columns, whose values identify the remote row.
+ */
+static void
+#if (PG_VERSION_NUM >= 140000)
+jdbcAddForeignUpdateTargets(PlannerInfo *root, Index rtindex,
+			    RangeTblEntry *target_rte, Relation target_relation)
+#else
+jdbcAddForeignUpdateTargets(Query *parsetree, RangeTblEntry *target_rte,
+			    Relation target_relation)
+#endif
+{
+	TupleDesc	tupdesc = RelationGetDescr(target_relation);
+	jdbcFdwOptions	opts;
+	ListCell	*lc;
+
+	jdbcGetOptions(RelationGetRelid(target_relation), &opts);
+
+	if (opts.table == NULL)
+		return;
+
+	/*
+	 * A table without key can still be modified directly, which needs no
+	 * junk columns, so the error is left to jdbcPlanForeignModify.
+	 */
+	foreach(lc, jdbcGetKeyAttrs(target_relation, &opts, true))
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, lfirst_int(lc) - 1);
+		char		name[NAMEDATALEN];
+		Var		*var;
+
+		jdbcKeyJunkName(name, attr->attnum);
+
+#if (PG_VERSION_NUM >= 140000)
+		var = makeVar(rtindex, attr->attnum, attr->atttypid, attr->atttypmod,
+			      attr->attcollation, 0);
+		add_row_identity_var(root, var, rtindex, pstrdup(name));
+#else
+		var = makeVar(parsetree->resultRelation, attr->attnum, attr->atttypid,
+			      attr->atttypmod, attr->attcollation, 0);
+		parsetree->targetList = lappend(parsetree->targetList,
+						makeTargetEntry((Expr *) var,
+								list_length(parsetree->targetList) + 1,
+								pstrdup(name), true));
+#endif
+	}
+}
+
+/*
+ * jdbcKeyJunkName
+ *		(9.3+) Name of the junk column carrying the old value of a key
+ *		attribute; name must have room for NAMEDATALEN bytes.
+ */
+static void
+jdbcKeyJunkName(char *name, AttrNumber attnum)
+{
+	snprintf(name, NAMEDATALEN, "jdbc_key_%d", attnum);
+}
+
+/*
+ * jdbcUnquoteName
+ *		(9.3+) The name an identifier quoted with quote stands for, or
+ *		name itself if it is not quoted.
+ */
+static char *
+jdbcUnquoteName(const char *name, const char *quote)
+{
+	StringInfoData	buf;
+	const char	*p;
+	int		quotelen = strlen(quote);
+
+	if (quotelen == 0 || strncmp(name, quote, quotelen) != 0)
+		return pstrdup(name);
+
+	initStringInfo(&buf);
+	for (p = name + quotelen; *p != '\0'; p++)
+	{
+		if (strncmp(p, quote, quotelen) == 0)
+		{
+			if (strncmp(p + quotelen, quote, quotelen) != 0)
+				break;
+			p += quotelen;
+		}
+		appendStringInfoChar(&buf, *p);
+	}
+
+	return buf.data;
+}
+
+/*
+ * jdbcGetKeyAttrs
+ *		(9.3+) Attribute numbers of the columns identifying a remote
+ *		row: those with the key option set, or else those of the
+ *		remote table's primary key.  Without a key, returns NIL if
+ *		missing_ok, else raises an error.
+ */
+static List *
+jdbcGetKeyAttrs(Relation rel, jdbcFdwOptions *opts, bool missing_ok)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	List		*key_attrs = NIL;
+	int		i;
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		ListCell	*lc;
+
+		if (attr->attisdropped)
+			continue;
+
+		foreach(lc, GetForeignColumnOptions(RelationGetRelid(rel), attr->attnum))
+		{
+			DefElem *def = (DefElem *) lfirst(lc);
+
+			if (strcmp(def->defname, "key") == 0 && defGetBoolean(def))
+				key_attrs = lappend_int(key_attrs, attr->attnum);
+		}
+	}
+
+	if (key_attrs == NIL)
+		key_attrs = jdbcGetRemoteKeyAttrs(rel, opts, missing_ok);
+
+	if (key_attrs == NIL && !missing_ok)
+		ereport(ERROR,
+			(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+			errmsg("foreign table \"%s\" has no key columns", RelationGetRelationName(rel)),
+			errhint("Set the key option on the columns identifying a row of the remote table.")
+			));
+
+	return key_attrs;
+}
+
+/*
+ * jdbcGetRemoteKeyAttrs
+ *		(9.3+) Attribute numbers of the columns of rel matching the
+ *		primary key of the remote table, as reported by the JDBC
+ *		driver, or NIL if it reports none, or if missing_ok and some
+ *		key column is not a column of rel.  The driver is asked once per
+ *		backend, and again after the options change.
+ */
+static List *
+jdbcGetRemoteKeyAttrs(Relation rel, jdbcFdwOptions *opts, bool missing_ok)
+{
+	jdbcOptionsCacheEntry *entry = jdbcGetOptionsCacheEntry(RelationGetRelid(rel));
+	List		*key_columns = NIL;
+	List		*key_attrs = NIL;
+	ListCell	*lc;
+
+	if (!entry->pkey_loaded)
+	{
+		jdbcFdwExecutionState *festate;
+		StringInfoData	query;
+		jclass 		JDBCUtilsClass;
+		jmethodID	id_primarykeycolumns;
+		jmethodID	id_returnresultseterrormessage;
+		jstring		table_string;
+		jobjectArray	key_array;
+		MemoryContext	oldcontext;
+		int		i;
+
+		JVMInitialization(RelationGetRelid(rel));
+
+		JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+		if (JDBCUtilsClass == NULL) 
+		{
+			elog(ERROR, "JDBCUtilsClass is NULL");
+		}
+
+		id_primarykeycolumns = (*env)->GetMethodID(env, JDBCUtilsClass, "PrimaryKeyColumns", "(Ljava/lang/String;)[Ljava/lang/String;");
+		if (id_primarykeycolumns == NULL) 
+		{
+			elog(ERROR, "id_primarykeycolumns is NULL");
+		}
+
+		id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+		if (id_returnresultseterrormessage == NULL) 
+		{
+			elog(ERROR, "id_returnresultseterrormessage is NULL");
+		}
+
+		initStringInfo(&query);
+		appendStringInfo(&query, "SELECT * FROM %s", opts->table);
+		festate = jdbcCreateExecutionState(opts, RelationGetDescr(rel), query.data, "", "", 0, 0, false);
+
+		table_string = (*env)->NewStringUTF(env, opts->table);
+		key_array = (*env)->CallObjectMethod(env, festate->java_call, id_primarykeycolumns, table_string);
+		if (key_array == NULL)
+		{
+			jstring		error_string;
+
+			error_string = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultseterrormessage);
+			elog(ERROR, "%s", ConvertStringToCString((jobject) error_string));
+		}
+
+		entry->pkey = NIL;
+		oldcontext = MemoryContextSwitchTo(entry->cxt);
+		for (i = 0; i < (*env)->GetArrayLength(env, key_array); i++)
+		{
+			jobject		column = (*env)->GetObjectArrayElement(env, key_array, i);
+			char		*column_cstring = ConvertStringToCString(column);
+
+			entry->pkey = lappend(entry->pkey, pstrdup(column_cstring));
+			(*env)->ReleaseStringUTFChars(env, (jstring) column, column_cstring);
+			(*env)->DeleteLocalRef(env, column);
+		}
+		MemoryContextSwitchTo(oldcontext);
+
+		(*env)->DeleteLocalRef(env, table_string);
+		(*env)->DeleteLocalRef(env, key_array);
+		jdbcCloseExecutionState(&festate);
+
+		entry->pkey_loaded = true;
+	}
+
+	/* Copied, as mapping the names may rebuild the cache entry */
+	foreach(lc, entry->pkey)
+	{
+		key_columns = lappend(key_columns, pstrdup((char *) lfirst(lc)));
+	}
+
+	foreach(lc, key_columns)
+	{
+		char		*column = (char *) lfirst(lc);
+		AttrNumber	attno = jdbcRemoteColumnAttno(rel, column);
+
+		if (attno == InvalidAttrNumber && missing_ok)
+		{
+			key_attrs = NIL;
+			break;
+		}
+
+		if (attno == InvalidAttrNumber)
+			ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+				errmsg("primary key column \"%s\" of the remote table is not a column of foreign table \"%s\"",
+				       column, RelationGetRelationName(rel)),
+				errhint("Set the key option on the columns identifying a row of the remote table.")
+				));
+
+		key_attrs = lappend_int(key_attrs, attno);
+	}
+
+	return key_attrs;
+}
+
+/*
+ * jdbcRemoteColumnAttno
+ *		(9.3+) Attribute number of the column of rel that is the remote
+ *		column named column, as the driver reports it, or
+ *		InvalidAttrNumber if there is none.
+ */
+static AttrNumber
+jdbcRemoteColumnAttno(Relation rel, const char *column)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	jdbcDialect	dialect;
+	int		i;
+
+	jdbcGetDialect(RelationGetRelid(rel), &dialect);
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		char		*remote_name;
+
+		if (attr->attisdropped)
+			continue;
+
+		remote_name = jdbcUnquoteName(jdbcColumnName(RelationGetRelid(rel), attr->attnum),
+					      dialect.quote);
+
+		if (pg_strcasecmp(remote_name, column) == 0)
+			return attr->attnum;
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * jdbcPlanForeignModify
+ *		(9.3+) Build the statement modifying the remote table.
+ */
+static List *
+jdbcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+		      int subplan_index)
+{
+	Oid		foreigntableid = planner_rt_fetch(resultRelation, root)->relid;
+	jdbcFdwOptions	opts;
+	Relation	rel;
+	List		*target_attrs = NIL;
+	List		*key_attrs = NIL;
+	char		*sql;
+
+	jdbcGetOptions(foreigntableid, &opts);
+
+	if (opts.table == NULL)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("cannot modify foreign table \"%s\"", get_rel_name(foreigntableid)),
+			errdetail("Only foreign tables defined with the table option can be modified.")
+			));
+
+	if (plan->returningLists != NIL)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("RETURNING is not supported by jdbc_fdw")
+			));
+
+#if (PG_VERSION_NUM >= 90500)
+	if (plan->onConflictAction != ONCONFLICT_NONE)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("ON CONFLICT is not supported by jdbc_fdw")
+			));
+#endif
+
+	rel = table_open(foreigntableid, NoLock);
+
+	switch (plan->operation)
+	{
+		case CMD_INSERT:
+			sql = jdbcDeparseInsertSql(rel, &opts, &target_attrs);
+			break;
+		case CMD_UPDATE:
+			target_attrs = jdbcUpdatedAttrs(root, resultRelation, rel);
+			key_attrs = jdbcGetKeyAttrs(rel, &opts, false);
+			sql = jdbcDeparseUpdateSql(rel, &opts, target_attrs, key_attrs);
+			break;
+		case CMD_DELETE:
+			key_attrs = jdbcGetKeyAttrs(rel, &opts, false);
+			sql = jdbcDeparseDeleteSql(rel, &opts, key_attrs);
+			break;
+		default:
+			elog(ERROR, "unexpected operation: %d", (int) plan->operation);
+			sql = NULL;	/* keep compiler quiet */
+			break;
+	}
+
+	table_close(rel, NoLock);
+
+	return list_make3(makeString(sql), target_attrs, key_attrs);
+}
+
+/*
+ * jdbcUpdatedAttrs
+ *		(9.3+) Attribute numbers of the columns an UPDATE assigns, the
+ *		only ones whose new values are sent.
+ */
+static List *
+jdbcUpdatedAttrs(PlannerInfo *root, Index resultRelation, Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	Bitmapset	*updated_cols;
+	List		*target_attrs = NIL;
+	int		col = -1;
+
+#if PG_VERSION_NUM >= 160000
+	updated_cols = get_rel_all_updated_cols(root, find_base_rel(root, resultRelation));
+#elif PG_VERSION_NUM >= 90500
+	updated_cols = planner_rt_fetch(resultRelation, root)->updatedCols;
+#else
+	updated_cols = planner_rt_fetch(resultRelation, root)->modifiedCols;
+#endif
+
+#if PG_VERSION_NUM >= 90500
+	while ((col = bms_next_member(updated_cols, col)) >= 0)
+#else
+	updated_cols = bms_copy(updated_cols);
+	while ((col = bms_first_member(updated_cols)) >= 0)
+#endif
+	{
+		AttrNumber	attno = col + FirstLowInvalidHeapAttributeNumber;
+
+		if (attno <= InvalidAttrNumber)	/* shouldn't happen */
+			elog(ERROR, "system-column update is not supported");
+#if PG_VERSION_NUM >= 120000
+		if (TupleDescAttr(tupdesc, attno - 1)->attgenerated)
+			continue;
+#endif
+		target_attrs = lappend_int(target_attrs, attno);
+	}
+
+	return target_attrs;
+}
+
+/*
+ * jdbcDeparseInsertSql
+ *		(9.3+) Build an INSERT of all columns of rel with one "?" per
+ *		column, and the list of the attribute numbers bound to them.
+ */
+static char *
+jdbcDeparseInsertSql(Relation rel, jdbcFdwOptions *opts, List **target_attrs)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	StringInfoData	buf;
+	int		i;
+
+	*target_attrs = NIL;
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (attr->attisdropped)
+			continue;
+#if PG_VERSION_NUM >= 120000
+		if (attr->attgenerated)
+			continue;
+#endif
+		*target_attrs = lappend_int(*target_attrs, attr->attnum);
+	}
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "INSERT INTO %s", opts->table);
+
+	if (*target_attrs == NIL)
+	{
+		appendStringInfoString(&buf, " DEFAULT VALUES");
+		return buf.data;
+	}
+
+	appendStringInfoString(&buf, " (");
+	for (i = 0; i < list_length(*target_attrs); i++)
+	{
+		appendStringInfo(&buf, "%s%s", (i == 0) ? "" : ", ",
+				 jdbcColumnName(RelationGetRelid(rel), list_nth_int(*target_attrs, i)));
+	}
+	appendStringInfoString(&buf, ") VALUES (");
+	for (i = 0; i < list_length(*target_attrs); i++)
+	{
+		appendStringInfoString(&buf, (i == 0) ? "?" : ", ?");
+	}
+	appendStringInfoChar(&buf, ')');
+
+	return buf.data;
+}
+
+/*
+ * jdbcDeparseUpdateSql
+ *		(9.3+) Build an UPDATE setting the columns of target_attrs of
+ *		the row with the given key, all values bound to "?".
+ */
+static char *
+jdbcDeparseUpdateSql(Relation rel, jdbcFdwOptions *opts, List *target_attrs, List *key_attrs)
+{
+	StringInfoData	buf;
+	ListCell	*lc;
+	bool		first = true;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "UPDATE %s SET ", opts->table);
+
+	foreach(lc, target_attrs)
+	{
+		appendStringInfo(&buf, "%s%s = ?", first ? "" : ", ",
+				 jdbcColumnName(RelationGetRelid(rel), lfirst_int(lc)));
+		first = false;
+	}
+
+	jdbcDeparseKeyCondition(&buf, rel, key_attrs);
+
+	return buf.data;
+}
+
+/*
+ * jdbcDeparseDeleteSql
+ *		(9.3+) Build a DELETE of the row with the given key.
+ */
+static char *
+jdbcDeparseDeleteSql(Relation rel, jdbcFdwOptions *opts, List *key_attrs)
+{
+	StringInfoData	buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "DELETE FROM %s", opts->table);
+
+	jdbcDeparseKeyCondition(&buf, rel, key_attrs);
+
+	return buf.data;
+}
+
+/*
+ * jdbcDeparseKeyCondition
+ *		(9.3+) Append a WHERE clause matching each key column with a
+ *		"?".
+ */
+static void
+jdbcDeparseKeyCondition(StringInfo buf, Relation rel, List *key_attrs)
+{
+	ListCell	*lc;
+	bool		first = true;
+
+	foreach(lc, key_attrs)
+	{
+		appendStringInfo(buf, "%s%s = ?", first ? " WHERE " : " AND ",
+				 jdbcColumnName(RelationGetRelid(rel), lfirst_int(lc)));
+		first = false;
+	}
+}
+
+/*
+ * jdbcBeginForeignModify
+ *		(9.3+) Connect and prepare the statement of a modification.
+ */
+static void
+jdbcBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinfo,
+		       List *fdw_private, int subplan_index, int eflags)
+{
+	jdbcFdwOptions	opts;
+	Plan		*subplan;
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	jdbcGetOptions(RelationGetRelid(rinfo->ri_RelationDesc), &opts);
+
+#if (PG_VERSION_NUM >= 140000)
+	subplan = outerPlanState(mtstate)->plan;
+#else
+	subplan = mtstate->mt_plans[subplan_index]->plan;
+#endif
+
+	rinfo->ri_FdwState = jdbcCreateModifyState(rinfo->ri_RelationDesc, mtstate->operation,
+						   strVal(list_nth(fdw_private, FdwModifyPrivateUpdateSql)),
+						   (List *) list_nth(fdw_private, FdwModifyPrivateTargetAttnums),
+						   (List *) list_nth(fdw_private, FdwModifyPrivateKeyAttnums),
+						   subplan,
+						   jdbcModifyBatchSize(rinfo, mtstate->operation, opts.batch_size));
+}
+
+/*
+ * jdbcCreateModifyState
+ *		(9.3+) Connect to the server of rel and prepare query, which
+ *		binds the new values of the attributes target_attrs of each
+ *		row, then the old values of its key attributes key_attrs, read
+ *		from their junk columns in the output of subplan.
+ */
+static jdbcFdwModifyState *
+jdbcCreateModifyState(Relation rel, CmdType operation, char *query, List *target_attrs,
+		      List *key_attrs, Plan *subplan, int batch_size)
+{
+	jdbcFdwModifyState *fmstate;
+	jdbcFdwOptions	opts;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	ListCell	*lc;
+	int		i = 0;
+
+	JVMInitialization(RelationGetRelid(rel));
+	jdbcGetOptions(RelationGetRelid(rel), &opts);
+#if PG_VERSION_NUM >= 120000
+	jdbcResultCacheNoteWrite(RelationGetRelid(rel));
+#endif
+
+	fmstate = (jdbcFdwModifyState *) palloc0(sizeof(jdbcFdwModifyState));
+	fmstate->rel = rel;
+	fmstate->operation = operation;
+	fmstate->target_attrs = target_attrs;
+	fmstate->num_target = list_length(target_attrs);
+	fmstate->numParams = fmstate->num_target + list_length(key_attrs);
+	fmstate->key_junk_attnos = (AttrNumber *) palloc(sizeof(AttrNumber) * (list_length(key_attrs) + 1));
+	fmstate->batch_size = batch_size;
+	fmstate->num_pending = 0;
+	fmstate->param_types = (const char **) palloc(sizeof(char *) * (fmstate->numParams + 1));
+	fmstate->param_typids = (Oid *) palloc(sizeof(Oid) * (fmstate->numParams + 1));
+	fmstate->param_flinfo = (FmgrInfo *) palloc(sizeof(FmgrInfo) * (fmstate->numParams + 1));
+
+	foreach(lc, list_concat(list_copy(target_attrs), key_attrs))
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, lfirst_int(lc) - 1);
+		Oid		typoutput;
+		bool		typisvarlena;
+
+		if (i >= fmstate->num_target)
+		{
+			char		name[NAMEDATALEN];
+
+			jdbcKeyJunkName(name, attr->attnum);
+			fmstate->key_junk_attnos[i - fmstate->num_target] =
+				ExecFindJunkAttributeInTlist(subplan->targetlist, name);
+			if (!AttributeNumberIsValid(fmstate->key_junk_attnos[i - fmstate->num_target]))
+				elog(ERROR, "could not find junk %s column", name);
+		}
+
+		fmstate->param_typids[i] = attr->atttypid;
+		fmstate->param_types[i] = jdbcModifyParamType(attr->atttypid);
+		getTypeOutputInfo(attr->atttypid, &typoutput, &typisvarlena);
+		fmgr_info(typoutput, &fmstate->param_flinfo[i]);
+		i++;
+	}
+
+	fmstate->temp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+						  "jdbc_fdw modify",
+						  ALLOCSET_SMALL_MINSIZE,
+						  ALLOCSET_SMALL_INITSIZE,
+						  ALLOCSET_SMALL_MAXSIZE);
+
+	fmstate->festate = jdbcCreateExecutionState(&opts, tupdesc, pstrdup(query), "", "", 0,
+						    fmstate->numParams, true);
+
+	return fmstate;
+}
+
+/*
+ * jdbcModifyBatchSize
+ *		(9.3+) Rows per JDBC batch: one when row triggers or RETURNING
+ *		need each row to reach the remote server at once.
+ */
+static int
+jdbcModifyBatchSize(ResultRelInfo *rinfo, CmdType operation, int batch_size)
+{
+	TriggerDesc	*trigdesc = rinfo->ri_TrigDesc;
+
+	if (rinfo->ri_projectReturning != NULL)
+		return 1;
+
+	if (trigdesc == NULL)
+		return batch_size;
+
+	switch (operation)
+	{
+		case CMD_INSERT:
+			if (trigdesc->trig_insert_before_row || trigdesc->trig_insert_after_row)
+				return 1;
+			break;
+		case CMD_UPDATE:
+			if (trigdesc->trig_update_before_row || trigdesc->trig_update_after_row)
+				return 1;
+			break;
+		case CMD_DELETE:
+			if (trigdesc->trig_delete_before_row || trigdesc->trig_delete_after_row)
+				return 1;
+			break;
+		default:
+			break;
+	}
+
+	return batch_size;
+}
+
+/*
+ * jdbcModifyParamType
+ *		(9.3+) Name of the binding JDBCUtils uses for a column of the
+ *		given type.  Modified values are bound with their JDBC type where
+ *		JDBCUtils knows one, floats included, and as strings otherwise.
+ */
+static const char *
+jdbcModifyParamType(Oid type)
+{
+	const char	*param_type = jdbcParamType(type);
+
+	if (param_type != NULL)
+		return param_type;
+
+	switch (type)
+	{
+		case FLOAT4OID:
+			return "float4";
+		case FLOAT8OID:
+			return "float8";
+		default:
+			return "text";
+	}
+}
+
+/*
+ * jdbcExecForeignInsert
+ *		(9.3+) Add a row to the current batch, which is sent once it is
+ *		full.
+ */
+static TupleTableSlot *
+jdbcExecForeignInsert(EState *estate, ResultRelInfo *rinfo,
+		      TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) rinfo->ri_FdwState;
+
+	SIGINTInterruptCheckProcess(&fmstate->festate);
+
+	jdbcModifyAddRow(fmstate, slot, planSlot);
+
+	if (fmstate->num_pending >= fmstate->batch_size)
+		jdbcModifyFlush(fmstate);
+
+	return slot;
+}
+
+/*
+ * jdbcExecForeignUpdate
+ *		(9.3+) Add the new values of a row and its key to the current
+ *		batch.
+ */
+static TupleTableSlot *
+jdbcExecForeignUpdate(EState *estate, ResultRelInfo *rinfo,
+		      TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	return jdbcExecForeignInsert(estate, rinfo, slot, planSlot);
+}
+
+/*
+ * jdbcExecForeignDelete
+ *		(9.3+) Add the key of a row to the current batch.
+ */
+static TupleTableSlot *
+jdbcExecForeignDelete(EState *estate, ResultRelInfo *rinfo,
+		      TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	return jdbcExecForeignInsert(estate, rinfo, slot, planSlot);
+}
+
+#if (PG_VERSION_NUM >= 140000)
+/*
+ * jdbcGetForeignModifyBatchSize
+ *		(14+) Number of rows the executor may pass to
+ *		jdbcExecForeignBatchInsert at once.
+ */
+static int
+jdbcGetForeignModifyBatchSize(ResultRelInfo *rinfo)
+{
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) rinfo->ri_FdwState;
+	jdbcFdwOptions	opts;
+
+	if (fmstate != NULL)
+		return fmstate->batch_size;
+
+	jdbcGetOptions(RelationGetRelid(rinfo->ri_RelationDesc), &opts);
+
+	return jdbcModifyBatchSize(rinfo, CMD_INSERT, opts.batch_size);
+}
+
+/*
+ * jdbcExecForeignBatchInsert
+ *		(14+) Send the rows collected by the executor as one batch.
+ */
+static TupleTableSlot **
+jdbcExecForeignBatchInsert(EState *estate, ResultRelInfo *rinfo,
+			   TupleTableSlot **slots, TupleTableSlot **planSlots,
+			   int *numSlots)
+{
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) rinfo->ri_FdwState;
+	int		i;
+
+	SIGINTInterruptCheckProcess(&fmstate->festate);
+
+	for (i = 0; i < *numSlots; i++)
+	{
+		jdbcModifyAddRow(fmstate, slots[i], planSlots[i]);
+	}
+
+	jdbcModifyFlush(fmstate);
+
+	return slots;
+}
+#endif
+
+/*
+ * jdbcModifyAddRow
+ *		(9.3+) Bind the target attributes of the row in slot and the
+ *		key values from the junk columns of planSlot to the statement
+ *		and add it to the JDBC batch.
+ */
+static void
+jdbcModifyAddRow(jdbcFdwModifyState *fmstate, TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_addbatch;
+	jobjectArray	types_array;
+	jobjectArray	values_array;
+	jstring 	addbatch_result = NULL;
+	char 		*addbatch_result_cstring = NULL;
+	char		**values;
+	MemoryContext	oldcontext;
+	int		i = 0;
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_addbatch = (*env)->GetMethodID(env, JDBCUtilsClass, "AddBatch", "([Ljava/lang/String;[Ljava/lang/String;)Ljava/lang/String;");
+	if (id_addbatch == NULL) 
+	{
+		elog(ERROR, "id_addbatch is NULL");
+	}
+
+	oldcontext = MemoryContextSwitchTo(fmstate->temp_cxt);
+
+	values = (char **) palloc(sizeof(char *) * (fmstate->numParams + 1));
+	for (i = 0; i < fmstate->numParams; i++)
+	{
+		Datum	value;
+		bool	isnull;
+
+		if (i < fmstate->num_target)
+		{
+			value = slot_getattr(slot, list_nth_int(fmstate->target_attrs, i), &isnull);
+		}
+		else
+		{
+			value = ExecGetJunkAttribute(planSlot, fmstate->key_junk_attnos[i - fmstate->num_target],
+						     &isnull);
+
+			/* "key = NULL" would match no remote row */
+			if (isnull)
+				ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("cannot %s a row of foreign table \"%s\" whose key is NULL",
+					       fmstate->operation == CMD_UPDATE ? "update" : "delete",
+					       RelationGetRelationName(fmstate->rel))
+					));
+		}
+
+		values[i] = isnull ? NULL : jdbcParamValueString(value, fmstate->param_typids[i],
+								 &fmstate->param_flinfo[i]);
+	}
+
+	types_array = jdbcNewStringArray(fmstate->numParams, fmstate->param_types);
+	values_array = jdbcNewStringArray(fmstate->numParams, (const char **) values);
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(fmstate->temp_cxt);
+
+	addbatch_result = (*env)->CallObjectMethod(env, fmstate->festate->java_call, id_addbatch, types_array, values_array);
+	if (addbatch_result != NULL)
+	{
+		addbatch_result_cstring = ConvertStringToCString((jobject)addbatch_result);
+		elog(ERROR, "%s", addbatch_result_cstring);
+	}
+
+	(*env)->DeleteLocalRef(env, types_array);
+	(*env)->DeleteLocalRef(env, values_array);
+
+	fmstate->num_pending++;
+}
+
+/*
+ * jdbcModifyFlush
+ *		(9.3+) Send the rows of the current JDBC batch, if any.  Each row
+ *		of an UPDATE or DELETE is identified by its key, so it must have
+ *		changed exactly one remote row; counts the driver does not know
+ *		are not checked.
+ */
+static void
+jdbcModifyFlush(jdbcFdwModifyState *fmstate)
+{
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_executebatch;
+	jfieldID	id_batchcounts;
+	jstring 	executebatch_result = NULL;
+	char 		*executebatch_result_cstring = NULL;
+	jintArray	counts_array;
+
+	if (fmstate->num_pending == 0)
+		return;
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_executebatch = (*env)->GetMethodID(env, JDBCUtilsClass, "ExecuteBatch", "()Ljava/lang/String;");
+	if (id_executebatch == NULL) 
+	{
+		elog(ERROR, "id_executebatch is NULL");
+	}
+
+	id_batchcounts = (*env)->GetFieldID(env, JDBCUtilsClass, "batch_counts", "[I");
+	if (id_batchcounts == NULL)
+	{
+		elog(ERROR, "id_batchcounts is NULL");
+	}
+
+	fmstate->num_pending = 0;
+
+	executebatch_result = (*env)->CallObjectMethod(env, fmstate->festate->java_call, id_executebatch);
+	if (executebatch_result != NULL)
+	{
+		executebatch_result_cstring = ConvertStringToCString((jobject)executebatch_result);
+		elog(ERROR, "%s", executebatch_result_cstring);
+	}
+
+	if (fmstate->operation == CMD_INSERT)
+		return;
+
+	counts_array = (jintArray) (*env)->GetObjectField(env, fmstate->festate->java_call, id_batchcounts);
+	if (counts_array != NULL)
+	{
+		jsize		ncounts = (*env)->GetArrayLength(env, counts_array);
+		jint		*counts = (*env)->GetIntArrayElements(env, counts_array, NULL);
+		int		bad_count = 1;
+		int		i;
+
+		if (counts == NULL)
+		{
+			elog(ERROR, "counts is NULL");
+		}
+
+		/* Statement.SUCCESS_NO_INFO and the like are negative */
+		for (i = 0; i < ncounts; i++)
+		{
+			if (counts[i] >= 0 && counts[i] != 1)
+			{
+				bad_count = counts[i];
+				break;
+			}
+		}
+
+		(*env)->ReleaseIntArrayElements(env, counts_array, counts, JNI_ABORT);
+		(*env)->DeleteLocalRef(env, counts_array);
+
+		if (bad_count != 1)
+			ereport(ERROR,
+				(errcode(ERRCODE_FDW_ERROR),
+				errmsg("remote %s of a row of foreign table \"%s\" changed %d rows instead of one",
+				       fmstate->operation == CMD_UPDATE ? "UPDATE" : "DELETE",
+				       RelationGetRelationName(fmstate->rel), bad_count),
+				errhint("The key columns of the foreign table must identify a single remote row.")
+				));
+	}
+}
+
+/*
+ * jdbcEndForeignModify
+ *		(9.3+) Send the last batch and close the statement.
+ */
+static void
+jdbcEndForeignModify(EState *estate, ResultRelInfo *rinfo)
+{
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) rinfo->ri_FdwState;
+
+	if (fmstate == NULL)
+		return;
+
+	jdbcFinishModify(fmstate);
+	rinfo->ri_FdwState = NULL;
+}
+
+/*
+ * jdbcFinishModify
+ *		(9.3+) Send the rows still pending and release the modification
+ *		state.
+ */
+static void
+jdbcFinishModify(jdbcFdwModifyState *fmstate)
+{
+	SIGINTInterruptCheckProcess(&fmstate->festate);
+
+	jdbcModifyFlush(fmstate);
+	if (fmstate->bulk_load)
+		jdbcModifyCallBulkLoad(fmstate, "EndBulkLoad", "()Ljava/lang/String;", NULL, NULL);
+	jdbcCloseExecutionState(&fmstate->festate);
+	MemoryContextDelete(fmstate->temp_cxt);
+}
+
+/*
+ * jdbcModifyCallBulkLoad
+ *		(9.3+) Call the JDBCUtils bulk load method of the given name and
+ *		signature, with table and columns as arguments if not NULL.
+ */
+static void
+jdbcModifyCallBulkLoad(jdbcFdwModifyState *fmstate, const char *method, const char *signature,
+		       jobject table, jobject columns)
+{
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_bulkload;
+	jstring 	bulkload_result = NULL;
+	char 		*bulkload_result_cstring = NULL;
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_bulkload = (*env)->GetMethodID(env, JDBCUtilsClass, method, signature);
+	if (id_bulkload == NULL) 
+	{
+		elog(ERROR, "id_bulkload is NULL");
+	}
+
+	if (table != NULL)
+		bulkload_result = (*env)->CallObjectMethod(env, fmstate->festate->java_call, id_bulkload, table, columns);
+	else
+		bulkload_result = (*env)->CallObjectMethod(env, fmstate->festate->java_call, id_bulkload);
+	if (bulkload_result != NULL)
+	{
+		bulkload_result_cstring = ConvertStringToCString((jobject)bulkload_result);
+		elog(ERROR, "%s", bulkload_result_cstring);
+	}
+}
+#endif
+
+#if (PG_VERSION_NUM >= 90600)
+/*
+ * jdbcPlanDirectModify
+ *		(9.6+) Turn an UPDATE or DELETE whose foreign scan, quals and new
+ *		values can all be expressed remotely into one remote statement
+ *		run by the ForeignScan, instead of fetching each row and sending
+ *		it back.
+ */
+static bool
+jdbcPlanDirectModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+		     int subplan_index)
+{
+	RangeTblEntry	*rte = planner_rt_fetch(resultRelation, root);
+	jdbcRemoteExprContext context;
+	jdbcFdwOptions	opts;
+	ForeignScan	*fscan;
+	Plan		*subplan;
+	StringInfoData	sql;
+	List		*processed_tlist = NIL;
+	List		*target_attrs = NIL;
+	ListCell	*lc;
+	ListCell	*lc2;
+	bool		first = true;
+
+	if (plan->operation != CMD_UPDATE && plan->operation != CMD_DELETE)
+		return false;
+
+	if (plan->returningLists != NIL)
+		return false;
+
+	/* Only a scan of the target alone, with no local join above it */
+#if (PG_VERSION_NUM >= 140000)
+	subplan = outerPlan(plan);
+#else
+	subplan = (Plan *) list_nth(plan->plans, subplan_index);
+#endif
+	if (!IsA(subplan, ForeignScan))
+		return false;
+
+	fscan = (ForeignScan *) subplan;
+	if (fscan->scan.scanrelid != resultRelation)
+		return false;
+
+	jdbcGetOptions(rte->relid, &opts);
+	if (opts.table == NULL)
+		return false;
+
+	context.relid = resultRelation;
+	context.foreigntableid = rte->relid;
+	context.buf = &sql;
+	context.params = NIL;
+
+	initStringInfo(&sql);
+
+	if (plan->operation == CMD_UPDATE)
+	{
+#if (PG_VERSION_NUM >= 140000)
+		get_translated_update_targetlist(root, resultRelation,
+						 &processed_tlist, &target_attrs);
+#else
+		Relation	rel = table_open(rte->relid, NoLock);
+
+		target_attrs = jdbcUpdatedAttrs(root, resultRelation, rel);
+		table_close(rel, NoLock);
+
+		foreach(lc, target_attrs)
+		{
+			TargetEntry *tle = get_tle_by_resno(subplan->targetlist, lfirst_int(lc));
+
+			if (tle == NULL)
+				elog(ERROR, "attribute number %d not found in subplan targetlist",
+				     lfirst_int(lc));
+			processed_tlist = lappend(processed_tlist, tle);
+		}
+#endif
+
+		appendStringInfo(&sql, "UPDATE %s SET ", opts.table);
+		forboth(lc, processed_tlist, lc2, target_attrs)
+		{
+			TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+			appendStringInfo(&sql, "%s%s = ", first ? "" : ", ",
+					 jdbcColumnName(rte->relid, lfirst_int(lc2)));
+			if (!jdbcDeparseRemoteExpr(tle->expr, &context, true))
+				return false;
+			first = false;
+		}
+	}
+	else
+	{
+		appendStringInfo(&sql, "DELETE FROM %s", opts.table);
+	}
+
+	/* Every qual of the scan must be checked by the remote server */
+	first = true;
+	foreach(lc, fscan->scan.plan.qual)
+	{
+		appendStringInfoString(&sql, first ? " WHERE " : " AND ");
+		if (!jdbcDeparseRemoteQual((Expr *) lfirst(lc), &context))
+			return false;
+		first = false;
+	}
+
+	fscan->operation = plan->operation;
+#if (PG_VERSION_NUM >= 140000)
+	fscan->resultRelation = resultRelation;
+#endif
+	fscan->scan.plan.qual = NIL;
+	fscan->fdw_exprs = context.params;
+	fscan->fdw_private = list_make2(makeString(sql.data),
+					makeInteger(plan->canSetTag ? 1 : 0));
+
+	return true;
+}
+
+/*
+ * jdbcDeparseRemoteQual
+ *		(9.6+) Append a qual to context->buf as a remote condition.  A
+ *		boolean column used as a condition is compared with true, as
+ *		not every database accepts a bare column there.
+ */
+static bool
+jdbcDeparseRemoteQual(Expr *expr, jdbcRemoteExprContext *context)
+{
+	if (IsA(expr, Var) && ((Var *) expr)->vartype == BOOLOID &&
+	    ((Var *) expr)->varno == context->relid)
+	{
+		appendStringInfoChar(context->buf, '(');
+		if (!jdbcDeparseRemoteExpr(expr, context, false))
+			return false;
+		appendStringInfoString(context->buf, " = ?)");
+		context->params = lappend(context->params, makeBoolConst(true, false));
+		return true;
+	}
+
+	if (IsA(expr, BoolExpr))
+	{
+		BoolExpr	*bool_expr = (BoolExpr *) expr;
+		ListCell	*lc;
+		bool		first = true;
+
+		if (bool_expr->boolop == NOT_EXPR)
+		{
+			appendStringInfoString(context->buf, "(NOT ");
+			if (!jdbcDeparseRemoteQual((Expr *) linitial(bool_expr->args), context))
+				return false;
+			appendStringInfoChar(context->buf, ')');
+			return true;
+		}
+
+		appendStringInfoChar(context->buf, '(');
+		foreach(lc, bool_expr->args)
+		{
+			if (!first)
+				appendStringInfoString(context->buf,
+						       (bool_expr->boolop == AND_EXPR) ? " AND " : " OR ");
+			if (!jdbcDeparseRemoteQual((Expr *) lfirst(lc), context))
+				return false;
+			first = false;
+		}
+		appendStringInfoChar(context->buf, ')');
+		return true;
+	}
+
+	return jdbcDeparseRemoteExpr(expr, context, false);
+}
+
+/*
+ * jdbcDeparseRemoteExpr
+ *		(9.6+) Append expr to context->buf as SQL the remote server
+ *		evaluates the same way we would, or return false.  Parts that
+ *		do not read the target row are computed locally and bound to
+ *		"?", so functions such as now() need no remote equivalent; they
+ *		must be of a type JDBCUtils binds, unless any_type is set for a
+ *		whole new column value.  Columns are combined only with
+ *		built-in comparison and integer or numeric arithmetic
+ *		operators, AND, OR, NOT and IS [NOT] NULL.  Strings are never
+ *		compared remotely, as remote collations may differ from ours.
+ */
+static bool
+jdbcDeparseRemoteExpr(Expr *expr, jdbcRemoteExprContext *context, bool any_type)
+{
+	StringInfo	buf = context->buf;
+
+	if (expr == NULL)
+		return false;
+
+	if (!contain_var_clause((Node *) expr))
+	{
+		if (contain_volatile_functions((Node *) expr) ||
+		    contain_subplans((Node *) expr))
+			return false;
+
+		if (!any_type && jdbcRemoteTypeKind(exprType((Node *) expr)) == '\0')
+			return false;
+
+		appendStringInfoChar(buf, '?');
+		context->params = lappend(context->params, expr);
+		return true;
+	}
+
+	switch (nodeTag(expr))
+	{
+		case T_Var:
+			{
+				Var	*var = (Var *) expr;
+
+				if (var->varno != context->relid || var->varlevelsup != 0 ||
+				    var->varattno <= 0)
+					return false;
+
+				appendStringInfoString(buf, jdbcColumnName(context->foreigntableid,
+									   var->varattno));
+				return true;
+			}
+		case T_RelabelType:
+			return jdbcDeparseRemoteExpr(((RelabelType *) expr)->arg, context, any_type);
+		case T_OpExpr:
+			{
+				OpExpr	*op = (OpExpr *) expr;
+				char	*opname;
+
+				if (list_length(op->args) != 2 || op->opno >= JDBC_BUILTIN_OID_LIMIT)
+					return false;
+
+				opname = get_opname(op->opno);
+				if (opname == NULL ||
+				    !jdbcIsRemoteOperator(opname, exprType((Node *) linitial(op->args)),
+							  exprType((Node *) lsecond(op->args))))
+					return false;
+
+				appendStringInfoChar(buf, '(');
+				if (!jdbcDeparseRemoteExpr((Expr *) linitial(op->args), context, false))
+					return false;
+				appendStringInfo(buf, " %s ", opname);
+				if (!jdbcDeparseRemoteExpr((Expr *) lsecond(op->args), context, false))
+					return false;
+				appendStringInfoChar(buf, ')');
+				return true;
+			}
+		case T_NullTest:
+			{
+				NullTest *nulltest = (NullTest *) expr;
+
+				if (nulltest->argisrow)
+					return false;
+
+				appendStringInfoChar(buf, '(');
+				if (!jdbcDeparseRemoteExpr(nulltest->arg, context, true))
+					return false;
+				appendStringInfoString(buf, (nulltest->nulltesttype == IS_NULL) ?
+						       " IS NULL)" : " IS NOT NULL)");
+				return true;
+			}
+		case T_BoolExpr:
+			return jdbcDeparseRemoteQual(expr, context);
+		default:
+			return false;
+	}
+}
+
+/*
+ * jdbcRemoteTypeKind
+ *		(9.6+) Class of the values of a type that the remote server
+ *		compares like we do: 'n' for integers and numerics, 'd' for
+ *		dates, 't' for timestamps, 'z' for timestamps with time zone,
+ *		'b' for booleans, or '\0' for a type not compared remotely.
+ *		Floats are left out, as remote servers treat NaN and -0 in their
+ *		own ways.
+ */
+static char
+jdbcRemoteTypeKind(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case NUMERICOID:
+			return 'n';
+		case DATEOID:
+			return 'd';
+		case TIMESTAMPOID:
+			return 't';
+		case TIMESTAMPTZOID:
+			return 'z';
+		case BOOLOID:
+			return 'b';
+		default:
+			return '\0';
+	}
+}
+
+/*
+ * jdbcIsRemoteOperator
+ *		(9.6+) Whether the built-in operator opname on the given types
+ *		can be written as is in remote SQL: a comparison of two values
+ *		of the same kind, or +, - or * on two numbers.
+ */
+static bool
+jdbcIsRemoteOperator(const char *opname, Oid left_type, Oid right_type)
+{
+	char	kind = jdbcRemoteTypeKind(left_type);
+
+	if (kind == '\0' || kind != jdbcRemoteTypeKind(right_type))
+		return false;
+
+	if (strcmp(opname, "=") == 0 || strcmp(opname, "<>") == 0)
+		return true;
+
+	if (kind == 'b')
+		return false;
+
+	if (strcmp(opname, "<") == 0 || strcmp(opname, "<=") == 0 ||
+	    strcmp(opname, ">") == 0 || strcmp(opname, ">=") == 0)
+		return true;
+
+	if (kind == 'n' &&
+	    (strcmp(opname, "+") == 0 || strcmp(opname, "-") == 0 || strcmp(opname, "*") == 0))
+		return true;
+
+	return false;
+}
+
+/*
+ * jdbcBeginDirectModify
+ *		(9.6+) Connect and prepare the statement of a direct
+ *		modification.
+ */
+static void
+jdbcBeginDirectModify(ForeignScanState *node, int eflags)
+{
+	ForeignScan	*fsplan = (ForeignScan *) node->ss.ps.plan;
+	Relation	rel = node->ss.ss_currentRelation;
+	jdbcFdwExecutionState *festate;
+	jdbcFdwOptions	opts;
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	JVMInitialization(RelationGetRelid(rel));
+	jdbcGetOptions(RelationGetRelid(rel), &opts);
+#if PG_VERSION_NUM >= 120000
+	jdbcResultCacheNoteWrite(RelationGetRelid(rel));
+#endif
+
+	festate = jdbcCreateExecutionState(&opts, RelationGetDescr(rel),
+					   pstrdup(strVal(list_nth(fsplan->fdw_private,
+								   FdwDirectModifyPrivateUpdateSql))),
+					   "", "", 0, list_length(fsplan->fdw_exprs), true);
+	node->fdw_state = (void *) festate;
+
+	jdbcPrepareParams(node, festate, fsplan->fdw_exprs);
+}
+
+/*
+ * jdbcIterateDirectModify
+ *		(9.6+) Run the statement with the values of its parameters and
+ *		report the number of rows it affected.  No row is returned.
+ */
+static TupleTableSlot *
+jdbcIterateDirectModify(ForeignScanState *node)
+{
+	jdbcFdwExecutionState *festate = (jdbcFdwExecutionState *) node->fdw_state;
+	ForeignScan	*fsplan = (ForeignScan *) node->ss.ps.plan;
+	ExprContext	*econtext = node->ss.ps.ps_ExprContext;
+	EState		*estate = node->ss.ps.state;
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_executeupdate;
+	jfieldID	id_updatecount;
+	jobjectArray	types_array;
+	jobjectArray	values_array;
+	jstring 	executeupdate_result = NULL;
+	char 		*executeupdate_result_cstring = NULL;
+	const char	**types;
+	char		**values;
+	MemoryContext	oldcontext;
+	ListCell	*lc;
+	int		update_count;
+	int		i = 0;
+
+	if (festate->query_started)
+		return ExecClearTuple(node->ss.ss_ScanTupleSlot);
+
+	SIGINTInterruptCheckProcess((jdbcFdwExecutionState **)&(node->fdw_state));
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_executeupdate = (*env)->GetMethodID(env, JDBCUtilsClass, "ExecuteUpdate", "([Ljava/lang/String;[Ljava/lang/String;)Ljava/lang/String;");
+	if (id_executeupdate == NULL) 
+	{
+		elog(ERROR, "id_executeupdate is NULL");
+	}
+
+	id_updatecount = (*env)->GetFieldID(env, JDBCUtilsClass, "update_count", "I");
+	if (id_updatecount == NULL)
+	{
+		elog(ERROR, "id_updatecount is NULL");
+	}
+
+	/* Parameters are evaluated in the per-tuple memory of the scan */
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	types = (const char **) palloc(sizeof(char *) * (festate->numParams + 1));
+	values = (char **) palloc(sizeof(char *) * (festate->numParams + 1));
+
+	foreach(lc, festate->param_exprs)
+	{
+		ExprState	*expr_state = (ExprState *) lfirst(lc);
+		Datum		value;
+		bool		isnull;
+
+#if PG_VERSION_NUM >= 100000
+		value = ExecEvalExpr(expr_state, econtext, &isnull);
+#else
+		value = ExecEvalExpr(expr_state, econtext, &isnull, NULL);
+#endif
+
+		types[i] = jdbcModifyParamType(festate->param_typids[i]);
+		values[i] = isnull ? NULL : jdbcParamValueString(value, festate->param_typids[i],
+								 &festate->param_flinfo[i]);
+		i++;
+	}
+
+	types_array = jdbcNewStringArray(festate->numParams, types);
+	values_array = jdbcNewStringArray(festate->numParams, (const char **) values);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	executeupdate_result = (*env)->CallObjectMethod(env, festate->java_call, id_executeupdate, types_array, values_array);
+	if (executeupdate_result != NULL)
+	{
+		executeupdate_result_cstring = ConvertStringToCString((jobject)executeupdate_result);
+		elog(ERROR, "%s", executeupdate_result_cstring);
+	}
+
+	(*env)->DeleteLocalRef(env, types_array);
+	(*env)->DeleteLocalRef(env, values_array);
+
+	festate->query_started = true;
+	update_count = (*env)->GetIntField(env, festate->java_call, id_updatecount);
+
+	if (intVal(list_nth(fsplan->fdw_private, FdwDirectModifyPrivateSetProcessed)) != 0)
+		estate->es_processed += update_count;
+
+	if (node->ss.ps.instrument != NULL)
+		node->ss.ps.instrument->tuplecount += update_count;
+
+	return ExecClearTuple(node->ss.ss_ScanTupleSlot);
+}
+
+/*
+ * jdbcEndDirectModify
+ *		(9.6+) Close the statement of a direct modification.
+ */
+static void
+jdbcEndDirectModify(ForeignScanState *node)
+{
+	if (node->fdw_state == NULL)
+		return;
+
+	jdbcCloseExecutionState((jdbcFdwExecutionState **)&(node->fdw_state));
+}
+
+/*
+ * jdbcExplainDirectModify
+ *		(9.6+) Show the statement of a direct modification.
+ */
+static void
+jdbcExplainDirectModify(ForeignScanState *node, ExplainState *es)
+{
+	if (es->verbose)
+	{
+		ExplainPropertyText("Remote SQL",
+				    strVal(list_nth(((ForeignScan *) node->ss.ps.plan)->fdw_private,
+						    FdwDirectModifyPrivateUpdateSql)),
+				    es);
+	}
+}
+#endif
+
+#if (PG_VERSION_NUM >= 110000)
+/*
+ * jdbcBeginForeignInsert
+ *		(11+) Prepare an INSERT for COPY FROM or for rows routed to a
+ *		partition that is a jdbc_fdw table.
+ */
+static void
+jdbcBeginForeignInsert(ModifyTableState *mtstate, ResultRelInfo *rinfo)
+{
+	Relation	rel = rinfo->ri_RelationDesc;
+	jdbcFdwModifyState *fmstate;
+	jdbcFdwOptions	opts;
+	List		*target_attrs;
+	char		*sql;
+
+	jdbcGetOptions(RelationGetRelid(rel), &opts);
+
+	if (opts.table == NULL)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("cannot modify foreign table \"%s\"", RelationGetRelationName(rel)),
+			errdetail("Only foreign tables defined with the table option can be modified.")
+			));
+
+	if (rinfo->ri_projectReturning != NULL)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("RETURNING is not supported by jdbc_fdw")
+			));
+
+	if (mtstate != NULL && mtstate->ps.plan != NULL &&
+	    ((ModifyTable *) mtstate->ps.plan)->onConflictAction != ONCONFLICT_NONE)
+		ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			errmsg("ON CONFLICT is not supported by jdbc_fdw")
+			));
+
+	sql = jdbcDeparseInsertSql(rel, &opts, &target_attrs);
+
+	fmstate = jdbcCreateModifyState(rel, CMD_INSERT, sql, target_attrs, NIL, NULL,
+					jdbcModifyBatchSize(rinfo, CMD_INSERT, opts.batch_size));
+	rinfo->ri_FdwState = fmstate;
+
+	/*
+	 * COPY and routed rows are streamed through the bulk interface of the
+	 * drivers JDBCUtils knows, unless each row has to reach the remote
+	 * server at once.  JDBCUtils keeps using JDBC batches for the others.
+	 */
+	if (opts.bulk_load && fmstate->batch_size > 1 && target_attrs != NIL)
+	{
+		const char	**columns;
+		jstring		table_string;
+		jobjectArray	columns_array;
+		ListCell	*lc;
+		int		i = 0;
+
+		columns = (const char **) palloc(sizeof(char *) * (list_length(target_attrs) + 1));
+		foreach(lc, target_attrs)
+		{
+			columns[i++] = jdbcColumnName(RelationGetRelid(rel), lfirst_int(lc));
+		}
+
+		table_string = (*env)->NewStringUTF(env, opts.table);
+		columns_array = jdbcNewStringArray(i, columns);
+
+		jdbcModifyCallBulkLoad(fmstate, "BeginBulkLoad",
+				       "(Ljava/lang/String;[Ljava/lang/String;)Ljava/lang/String;",
+				       table_string, columns_array);
+		fmstate->bulk_load = true;
+
+		(*env)->DeleteLocalRef(env, table_string);
+		(*env)->DeleteLocalRef(env, columns_array);
+	}
+}
+
+/*
+ * jdbcEndForeignInsert
+ *		(11+) Send the last batch and close the statement.
+ */
+static void
+jdbcEndForeignInsert(EState *estate, ResultRelInfo *rinfo)
+{
+	jdbcEndForeignModify(estate, rinfo);
+}
+#endif
+
+#if (PG_VERSION_NUM >= 140000)
+/*
+ * jdbcExecForeignTruncate
+ *		(14+) Truncate the remote tables of foreign tables that are all
+ *		on the same server, in one remote call.  JDBCUtils writes the
+ *		statement for the remote database.
+ */
+static void
+jdbcExecForeignTruncate(List *rels, DropBehavior behavior, bool restart_seqs)
+{
+	jdbcFdwExecutionState *festate;
+	jdbcFdwOptions	opts;
+	Relation	first_rel = (Relation) linitial(rels);
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_truncate;
+	jobjectArray	tables_array;
+	jstring 	truncate_result = NULL;
+	char 		*truncate_result_cstring = NULL;
+	const char	**tables;
+	ListCell	*lc;
+	int		i = 0;
+
+	tables = (const char **) palloc(sizeof(char *) * (list_length(rels) + 1));
+	foreach(lc, rels)
+	{
+		Relation	rel = (Relation) lfirst(lc);
+
+		jdbcGetOptions(RelationGetRelid(rel), &opts);
+
+		if (opts.table == NULL)
+			ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				errmsg("cannot truncate foreign table \"%s\"", RelationGetRelationName(rel)),
+				errdetail("Only foreign tables defined with the table option can be truncated.")
+				));
+
+		tables[i++] = opts.table;
+		jdbcResultCacheNoteWrite(RelationGetRelid(rel));
+	}
+
+	JVMInitialization(RelationGetRelid(first_rel));
+	jdbcGetOptions(RelationGetRelid(first_rel), &opts);
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_truncate = (*env)->GetMethodID(env, JDBCUtilsClass, "Truncate", "([Ljava/lang/String;ZZ)Ljava/lang/String;");
+	if (id_truncate == NULL) 
+	{
+		elog(ERROR, "id_truncate is NULL");
+	}
+
+	festate = jdbcCreateExecutionState(&opts, RelationGetDescr(first_rel), "", "", "", 0, 0, true);
+
+	tables_array = jdbcNewStringArray(i, tables);
+
+	truncate_result = (*env)->CallObjectMethod(env, festate->java_call, id_truncate, tables_array,
+						   (jboolean) restart_seqs,
+						   (jboolean) (behavior == DROP_CASCADE));
+	if (truncate_result != NULL)
+	{
+		truncate_result_cstring = ConvertStringToCString((jobject)truncate_result);
+		elog(ERROR, "%s", truncate_result_cstring);
+	}
+
+	(*env)->DeleteLocalRef(env, tables_array);
+
+	jdbcCloseExecutionState(&festate);
+}
+#endif
+
+#if (PG_VERSION_NUM >= 90500)
+/*
+ * jdbcImportForeignSchema
+ *		(9.5+) Build a CREATE FOREIGN TABLE command for each table of
+ *		the remote schema, from the columns JDBCUtils reads for the whole
+ *		schema at once.  The local tables and columns are named as the
+ *		remote ones, which the table and column_name options give as
+ *		remote SQL spells them.
+ */
+static List *
+jdbcImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
+{
+	ForeignServer	*f_server = GetForeignServer(serverOid);
+	jdbcFdwExecutionState *festate;
+	jdbcFdwOptions	opts;
+	TupleDesc	tupdesc;
+	jclass 		JDBCUtilsClass;
+	jmethodID	id_importschema;
+	jmethodID	id_returnresultseterrormessage;
+	jstring		schema_string;
+	jobjectArray	columns;
+	List		*commands = NIL;
+	StringInfoData	buf;
+	char		*table = NULL;
+	char		*remote_table = NULL;
+	char		*skipped_table = NULL;
+	ListCell	*lc;
+	int		ncolumns;
+	int		i;
+
+	foreach(lc, stmt->options)
+	{
+		DefElem *def = (DefElem *) lfirst(lc);
+
+		ereport(ERROR,
+			(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+			errmsg("invalid option \"%s\"", def->defname)
+			));
+	}
+
+	jdbcParseOptions(InvalidOid, serverOid, &opts);
+	JVMCreate(&opts);
+
+	JDBCUtilsClass = (*env)->FindClass(env, "JDBCUtils");
+	if (JDBCUtilsClass == NULL) 
+	{
+		elog(ERROR, "JDBCUtilsClass is NULL");
+	}
+
+	id_importschema = (*env)->GetMethodID(env, JDBCUtilsClass, "ImportSchema", "(Ljava/lang/String;)[Ljava/lang/String;");
+	if (id_importschema == NULL) 
+	{
+		elog(ERROR, "id_importschema is NULL");
+	}
+
+	id_returnresultseterrormessage = (*env)->GetMethodID(env, JDBCUtilsClass, "ReturnResultSetErrorMessage", "()Ljava/lang/String;");
+	if (id_returnresultseterrormessage == NULL) 
+	{
+		elog(ERROR, "id_returnresultseterrormessage is NULL");
+	}
+
+#if PG_VERSION_NUM >= 120000
+	tupdesc = CreateTemplateTupleDesc(0);
+#else
+	tupdesc = CreateTemplateTupleDesc(0, false);
+#endif
+	festate = jdbcCreateExecutionState(&opts, tupdesc, "", "", "", 0, 0, true);
+
+	schema_string = (*env)->NewStringUTF(env, stmt->remote_schema);
+	columns = (*env)->CallObjectMethod(env, festate->java_call, id_importschema, schema_string);
+	if (columns == NULL)
+	{
+		jstring		error_string;
+
+		error_string = (*env)->CallObjectMethod(env, festate->java_call, id_returnresultseterrormessage);
+		elog(ERROR, "%s", ConvertStringToCString((jobject) error_string));
+	}
+
+	/*
+	 * Six strings per column, those of a table next to each other: the
+	 * table name, the remote table, the column name, the remote column,
+	 * the type and whether it is NOT NULL.  Tables are told apart by the
+	 * remote table, which is qualified with the schema.
+	 */
+	initStringInfo(&buf);
+	ncolumns = (*env)->GetArrayLength(env, columns) / 6;
+	for (i = 0; i <= ncolumns; i++)
+	{
+		char		*column[6];
+		int		j;
+
+		/*
+		 * The strings are copied and their references dropped at once, as
+		 * a large schema has many columns.
+		 */
+		if (i < ncolumns)
+		{
+			for (j = 0; j < 6; j++)
+			{
+				jstring		element = (jstring) (*env)->GetObjectArrayElement(env, columns, i * 6 + j);
+				const char	*chars = (*env)->GetStringUTFChars(env, element, NULL);
+
+				if (chars == NULL)
+				{
+					elog(ERROR, "GetStringUTFChars returned NULL");
+				}
+				column[j] = pstrdup(chars);
+				(*env)->ReleaseStringUTFChars(env, element, chars);
+				(*env)->DeleteLocalRef(env, element);
+			}
+		}
+
+		/* End the command of the previous table */
+		if (table != NULL && (i == ncolumns || strcmp(column[1], remote_table) != 0))
+		{
+			appendStringInfo(&buf, "\n) SERVER %s OPTIONS (table %s);",
+					 quote_identifier(f_server->servername),
+					 quote_literal_cstr(remote_table));
+			commands = lappend(commands, pstrdup(buf.data));
+			table = NULL;
+		}
+
+		if (i == ncolumns)
+			break;
+
+		if (table == NULL)
+		{
+			bool		listed = false;
+
+			if (skipped_table != NULL && strcmp(column[1], skipped_table) == 0)
+				continue;
+
+			foreach(lc, stmt->table_list)
+			{
+				if (strcmp(((RangeVar *) lfirst(lc))->relname, column[0]) == 0)
+					listed = true;
+			}
+
+			/* LIMIT TO and EXCEPT name the remote tables */
+			if ((stmt->list_type == FDW_IMPORT_SCHEMA_LIMIT_TO && !listed) ||
+			    (stmt->list_type == FDW_IMPORT_SCHEMA_EXCEPT && listed))
+			{
+				skipped_table = column[1];
+				continue;
+			}
+
+			table = column[0];
+			remote_table = column[1];
+			resetStringInfo(&buf);
+			appendStringInfo(&buf, "CREATE FOREIGN TABLE %s (\n",
+					 quote_identifier(table));
+		}
+		else
+		{
+			appendStringInfoString(&buf, ",\n");
+		}
+
+		appendStringInfo(&buf, "  %s %s OPTIONS (column_name %s)%s",
+				 quote_identifier(column[2]), column[4],
+				 quote_literal_cstr(column[3]),
+				 (column[5][0] == 't') ? " NOT NULL" : "");
+	}
+
+	(*env)->DeleteLocalRef(env, schema_string);
+	(*env)->DeleteLocalRef(env, columns);
+
+	jdbcCloseExecutionState(&festate);
+
+	return commands;
+}
+#endif
+
+#if PG_VERSION_NUM >= 120000
+/*
+ * Batched key lookups
+ *
+ * A join of any relation with a jdbc_fdw table on "column = expression
+ * over the other relation" can run as a custom scan.  It reads outer
+ * rows until it has lookup_batch_size distinct keys, fetches the
+ * matching remote rows with one "column IN (?, ...)" query, and joins
+ * them to the buffered outer rows through a hash table on the key.
+ */
+
+/*
+ * Outer rows buffered per distinct key at most, so that a batch of
+ * repeated keys stays bounded.
+ */
+#define LOOKUP_JOIN_OUTER_ROWS_PER_KEY	16
+
+/*
+ * Indexes of the items of the lookup join's CustomScan.custom_private.
+ */
+enum LookupJoinPrivateIndex
+{
+	/* String with the remote query */
+	LookupJoinPrivateSql,
+	/* Integer number of keys sent with each query */
+	LookupJoinPrivateBatchSize,
+	/* Integer OID of the foreign table */
+	LookupJoinPrivateRelid,
+	/* Integer attribute number of the key column */
+	LookupJoinPrivateKeyAttno,
+	/* Integer OIDs of the equality operator and its input collation */
+	LookupJoinPrivateOpno,
+	LookupJoinPrivateCollation,
+	/* Integer JoinType, JOIN_INNER or JOIN_SEMI */
+	LookupJoinPrivateJoinType,
+	/* Integer list of the foreign table columns in the scan tuple */
+	LookupJoinPrivateInnerAttnos
+};
+
+/*
+ * Execution state of a lookup join.  The scan tuple holds the columns of
+ * the outer plan followed by the columns of the foreign table.
+ */
+typedef struct jdbcLookupJoinState
+{
+	CustomScanState	css;
+	PlanState	*outer_ps;	/* outer side of the join */
+	jdbcFdwExecutionState *festate;	/* remote lookups */
+	Relation	inner_rel;	/* the foreign table */
+	TupleTableSlot	*inner_slot;	/* row read from the remote server */
+	TupleTableSlot	*outer_slot;	/* buffered outer row being joined */
+	ExprState	*outer_key;	/* key of an outer row, over the scan tuple */
+	JoinType	jointype;
+	int		batch_size;	/* distinct keys per remote query */
+	AttrNumber	key_attno;	/* key column of the foreign table */
+	Oid		key_type;
+	int16		key_typlen;
+	bool		key_typbyval;
+	Oid		collation;
+	FmgrInfo	hash_finfo;	/* hash function of the key type */
+	FmgrInfo	eq_finfo;	/* equality function of the key type */
+	FmgrInfo	key_out_finfo;	/* output function of the key type */
+	int		*inner_attnos;	/* foreign table column of each inner scan column */
+	int		ninner_cols;
+	int		nouter_cols;
+	Datum		*inner_values;	/* workspace for deforming inner rows */
+	bool		*inner_nulls;
+	MemoryContext	batch_cxt;	/* holds the current batch */
+	MinimalTuple	*outer_tuples;	/* outer rows of the batch */
+	uint32		*outer_hashes;	/* hash of the key of each outer row */
+	int		nouter;
+	HeapTuple	*inner_tuples;	/* remote rows of the batch */
+	uint32		*inner_hashes;	/* hash of the key of each remote row */
+	int		*inner_next;	/* next remote row in the bucket, or -1 */
+	int		ninner;
+	int		*buckets;	/* first remote row of each bucket, or -1 */
+	uint32		bucket_mask;
+	int		outer_pos;	/* current outer row, -1 before the first */
+	int		inner_pos;	/* next candidate remote row, or -1 */
+	bool		outer_done;	/* outer side is exhausted */
+} jdbcLookupJoinState;
+
+static void jdbcJoinPathlistHook(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+				 RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra);
+static Plan *jdbcPlanLookupJoin(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path,
+				List *tlist, List *clauses, List *custom_plans);
+static Node *jdbcCreateLookupJoinState(CustomScan *cscan);
+static void jdbcBeginLookupJoin(CustomScanState *node, EState *estate, int eflags);
+static TupleTableSlot *jdbcExecLookupJoin(CustomScanState *node);
+static void jdbcEndLookupJoin(CustomScanState *node);
+static void jdbcReScanLookupJoin(CustomScanState *node);
+static void jdbcExplainLookupJoin(CustomScanState *node, List *ancestors, ExplainState *es);
+static bool jdbcLookupJoinNext(jdbcLookupJoinState *state);
+static void jdbcLookupJoinFillBatch(jdbcLookupJoinState *state);
+static void jdbcLookupJoinStoreRow(jdbcLookupJoinState *state, int inner);
+static bool jdbcIsLookupJoinKey(RelOptInfo *innerrel, RestrictInfo *rinfo, Var **var, Expr **outer_key);
+
+static set_join_pathlist_hook_type prev_set_join_pathlist_hook = NULL;
+
+static const CustomPathMethods jdbcLookupJoinPathMethods = {
+	.CustomName = "JdbcLookupJoin",
+	.PlanCustomPath = jdbcPlanLookupJoin,
+};
+
+static const CustomScanMethods jdbcLookupJoinPlanMethods = {
+	.CustomName = "JdbcLookupJoin",
+	.CreateCustomScanState = jdbcCreateLookupJoinState,
+};
+
+static const CustomExecMethods jdbcLookupJoinExecMethods = {
+	.CustomName = "JdbcLookupJoin",
+	.BeginCustomScan = jdbcBeginLookupJoin,
+	.ExecCustomScan = jdbcExecLookupJoin,
+	.EndCustomScan = jdbcEndLookupJoin,
+	.ReScanCustomScan = jdbcReScanLookupJoin,
+	.ExplainCustomScan = jdbcExplainLookupJoin,
+};
+
+/*
+ * _PG_init
+ *		(12+) Library load-time initialization: offer lookup joins to the
+ *		planner, and set up the result cache.
+ */
+void
+_PG_init(void)
+{
+	prev_set_join_pathlist_hook = set_join_pathlist_hook;
+	set_join_pathlist_hook = jdbcJoinPathlistHook;
+
+	RegisterCustomScanMethods(&jdbcLookupJoinPlanMethods);
+
+	jdbcDefineResultCache();
+}
+
+/*
+ * jdbcJoinPathlistHook
+ *		(12+) Add a lookup join path for an inner or semi join whose inner
+ *		side is a jdbc_fdw table with lookup_batch_size set, joined on a
+ *		key the remote server can look up.
+ */
+static void
+jdbcJoinPathlistHook(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+		     RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	jdbcFdwRelationInfo *fpinfo;
+	Path		*outer_path = outerrel->cheapest_total_path;
+	RestrictInfo	*key_rinfo = NULL;
+	CustomPath	*cpath;
+	QualCost	qual_cost;
+	Bitmapset	*qual_attrs = NULL;
+	double		nbatches;
+	ListCell	*lc;
+
+	if (prev_set_join_pathlist_hook)
+		prev_set_join_pathlist_hook(root, joinrel, outerrel, innerrel, jointype, extra);
+
+	if ((jointype != JOIN_INNER && jointype != JOIN_SEMI) ||
+	    innerrel->reloptkind != RELOPT_BASEREL ||
+	    innerrel->fdwroutine == NULL ||
+	    innerrel->fdwroutine->GetForeignRelSize != jdbcGetForeignRelSize ||
+	    innerrel->fdw_private == NULL ||
+	    !bms_is_empty(innerrel->lateral_relids) ||
+	    !bms_is_empty(joinrel->lateral_relids) ||
+	    outer_path == NULL || outer_path->param_info != NULL)
+		return;
+
+	fpinfo = (jdbcFdwRelationInfo *) innerrel->fdw_private;
+	if (fpinfo->opts.table == NULL || fpinfo->opts.lookup_batch_size <= 0)
+		return;
+
+	/* Only ordinary columns of the table can be returned by the join */
+	foreach(lc, innerrel->reltarget->exprs)
+	{
+		Var	*var = (Var *) lfirst(lc);
+
+		if (!IsA(var, Var) || var->varno != innerrel->relid || var->varattno <= 0)
+			return;
+	}
+
+	/*
+	 * The remote query only looks up the keys, so the quals of the table
+	 * itself are checked by the join, which has only its ordinary columns.
+	 */
+	foreach(lc, innerrel->baserestrictinfo)
+	{
+		if (((RestrictInfo *) lfirst(lc))->pseudoconstant)
+			return;
+	}
+	pull_varattnos((Node *) innerrel->baserestrictinfo, innerrel->relid, &qual_attrs);
+	while (!bms_is_empty(qual_attrs))
+	{
+		if (bms_first_member(qual_attrs) + FirstLowInvalidHeapAttributeNumber <= 0)
+			return;
+	}
+
+	foreach(lc, extra->restrictlist)
+	{
+		RestrictInfo	*rinfo = (RestrictInfo *) lfirst(lc);
+
+		/* Gating quals are left to the regular join paths */
+		if (rinfo->pseudoconstant)
+			return;
+
+		if (key_rinfo == NULL && jdbcIsLookupJoinKey(innerrel, rinfo, NULL, NULL))
+			key_rinfo = rinfo;
+	}
+
+	if (key_rinfo == NULL)
+		return;
+
+	/*
+	 * Every batch of keys costs one remote query; each matching remote
+	 * row is transferred once and checked against the join quals and
+	 * the quals of the table.
+	 */
+	nbatches = ceil(outer_path->rows / fpinfo->opts.lookup_batch_size);
+	cost_qual_eval(&qual_cost, list_concat(list_copy(extra->restrictlist),
+					       innerrel->baserestrictinfo), root);
+
+	cpath = makeNode(CustomPath);
+	cpath->path.pathtype = T_CustomScan;
+	cpath->path.parent = joinrel;
+	cpath->path.pathtarget = joinrel->reltarget;
+	cpath->path.param_info = NULL;
+	cpath->path.parallel_aware = false;
+	cpath->path.parallel_safe = false;
+	cpath->path.parallel_workers = 0;
+	cpath->path.rows = joinrel->rows;
+	cpath->path.startup_cost = outer_path->startup_cost + DEFAULT_FDW_STARTUP_COST;
+	cpath->path.total_cost = outer_path->total_cost +
+		nbatches * DEFAULT_FDW_STARTUP_COST +
+		outer_path->rows * cpu_operator_cost +
+		joinrel->rows * (DEFAULT_FDW_TUPLE_COST + cpu_tuple_cost + qual_cost.per_tuple);
+	cpath->path.pathkeys = NIL;
+	cpath->flags = 0;
+	cpath->custom_paths = list_make1(outer_path);
+	cpath->custom_private = list_make4(key_rinfo, makeInteger(jointype), extra->restrictlist,
+					   makeInteger(innerrel->relid));
+	cpath->methods = &jdbcLookupJoinPathMethods;
+
+	add_path(joinrel, (Path *) cpath);
+}
+
+/*
+ * jdbcIsLookupJoinKey
+ *		(12+) Whether a join clause can key a lookup join: a clause that
+ *		could be a join key of a parameterized scan, comparing values of
+ *		one type with its hashable equality operator.
+ */
+static bool
+jdbcIsLookupJoinKey(RelOptInfo *innerrel, RestrictInfo *rinfo, Var **var, Expr **outer_key)
+{
+	Var	*key_var;
+	Expr	*key_expr;
+
+	if (!jdbcIsParamJoinClause(innerrel, rinfo, &key_var, &key_expr))
+		return false;
+
+	if (key_var->vartype != exprType((Node *) key_expr) ||
+	    !op_hashjoinable(((OpExpr *) rinfo->clause)->opno, key_var->vartype))
+		return false;
+
+	if (var != NULL)
+		*var = key_var;
+	if (outer_key != NULL)
+		*outer_key = key_expr;
+
+	return true;
+}
+
+
+/*
+ * jdbcPlanLookupJoin
+ *		(12+) Create the CustomScan of a lookup join path.  Its scan tuple
+ *		holds the columns of the outer plan followed by the columns of the
+ *		foreign table, and all join clauses, the key included, are checked
+ *		as quals of the scan along with the quals of the foreign table.
+ */
+static Plan *
+jdbcPlanLookupJoin(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path,
+		   List *tlist, List *clauses, List *custom_plans)
+{
+	CustomScan	*cscan = makeNode(CustomScan);
+	Plan		*outer_plan = (Plan *) linitial(custom_plans);
+	RestrictInfo	*key_rinfo = (RestrictInfo *) linitial(best_path->custom_private);
+	int		jointype = intVal(lsecond(best_path->custom_private));
+	List		*restrictlist = (List *) lthird(best_path->custom_private);
+	RelOptInfo	*innerrel = find_base_rel(root, intVal(lfourth(best_path->custom_private)));
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) innerrel->fdw_private;
+	Oid		foreigntableid = planner_rt_fetch(innerrel->relid, root)->relid;
+	Var		*key_var;
+	Expr		*outer_key;
+	Relation	rel_desc;
+	TupleDesc	tupdesc;
+	List		*scan_tlist = NIL;
+	List		*inner_attnos = NIL;
+	StringInfoData	sql;
+	AttrNumber	resno = 1;
+	int		i;
+	ListCell	*lc;
+
+	if (!jdbcIsLookupJoinKey(innerrel, key_rinfo, &key_var, &outer_key))
+		elog(ERROR, "lookup join key is not valid");
+
+	initStringInfo(&sql);
+	appendStringInfo(&sql, "SELECT * FROM %s WHERE %s IN (", fpinfo->opts.table,
+			 jdbcColumnName(foreigntableid, key_var->varattno));
+	for (i = 0; i < fpinfo->opts.lookup_batch_size; i++)
+	{
+		appendStringInfoString(&sql, (i == 0) ? "?" : ", ?");
+	}
+	appendStringInfoChar(&sql, ')');
+
+	foreach(lc, outer_plan->targetlist)
+	{
+		TargetEntry	*tle = (TargetEntry *) lfirst(lc);
+
+		scan_tlist = lappend(scan_tlist, makeTargetEntry((Expr *) copyObject(tle->expr),
+								 resno++, NULL, false));
+	}
+
+	rel_desc = table_open(foreigntableid, NoLock);
+	tupdesc = RelationGetDescr(rel_desc);
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (attr->attisdropped)
+			continue;
+
+		scan_tlist = lappend(scan_tlist,
+				     makeTargetEntry((Expr *) makeVar(innerrel->relid, attr->attnum,
+								      attr->atttypid, attr->atttypmod,
+								      attr->attcollation, 0),
+						     resno++, NULL, false));
+		inner_attnos = lappend_int(inner_attnos, attr->attnum);
+	}
+	table_close(rel_desc, NoLock);
+
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = list_concat(extract_actual_clauses(restrictlist, false),
+					    extract_actual_clauses(innerrel->baserestrictinfo, false));
+	cscan->scan.scanrelid = 0;
+	cscan->flags = best_path->flags;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_exprs = list_make1(copyObject(outer_key));
+	cscan->custom_scan_tlist = scan_tlist;
+	cscan->custom_relids = bms_copy(rel->relids);
+	cscan->custom_private = list_make4(makeString(sql.data),
+					   makeInteger(fpinfo->opts.lookup_batch_size),
+					   makeInteger(foreigntableid),
+					   makeInteger(key_var->varattno));
+	cscan->custom_private = list_concat(cscan->custom_private,
+					    list_make4(makeInteger(((OpExpr *) key_rinfo->clause)->opno),
+						       makeInteger(((OpExpr *) key_rinfo->clause)->inputcollid),
+						       makeInteger(jointype),
+						       inner_attnos));
+	cscan->methods = &jdbcLookupJoinPlanMethods;
+
+	return (Plan *) cscan;
+}
+
+/*
+ * jdbcCreateLookupJoinState
+ *		(12+) Allocate the execution state of a lookup join.
+ */
+static Node *
+jdbcCreateLookupJoinState(CustomScan *cscan)
+{
+	jdbcLookupJoinState *state;
+
+	state = (jdbcLookupJoinState *) newNode(sizeof(jdbcLookupJoinState), T_CustomScanState);
+	state->css.methods = &jdbcLookupJoinExecMethods;
+
+	return (Node *) state;
+}
+
+/*
+ * jdbcBeginLookupJoin
+ *		(12+) Start the outer plan and prepare the remote lookup query.
+ */
+static void
+jdbcBeginLookupJoin(CustomScanState *node, EState *estate, int eflags)
+{
+	jdbcLookupJoinState *state = (jdbcLookupJoinState *) node;
+	CustomScan	*cscan = (CustomScan *) node->ss.ps.plan;
+	List		*custom_private = cscan->custom_private;
+	Oid		foreigntableid = intVal(list_nth(custom_private, LookupJoinPrivateRelid));
+	Oid		opno = intVal(list_nth(custom_private, LookupJoinPrivateOpno));
+	List		*inner_attnos = (List *) list_nth(custom_private, LookupJoinPrivateInnerAttnos);
+	TupleDesc	outer_desc;
+	TupleDesc	inner_desc;
+	RegProcedure	hash_proc;
+	RegProcedure	rhs_hash_proc;
+	Oid		typoutput;
+	bool		typisvarlena;
+	jdbcFdwOptions	opts;
+	ListCell	*lc;
+	int		i = 0;
+
+	state->outer_ps = ExecInitNode((Plan *) linitial(cscan->custom_plans), estate, eflags);
+	node->custom_ps = list_make1(state->outer_ps);
+	state->outer_key = ExecInitExpr((Expr *) linitial(cscan->custom_exprs), &node->ss.ps);
+
+	state->jointype = (JoinType) intVal(list_nth(custom_private, LookupJoinPrivateJoinType));
+	state->batch_size = intVal(list_nth(custom_private, LookupJoinPrivateBatchSize));
+	state->key_attno = intVal(list_nth(custom_private, LookupJoinPrivateKeyAttno));
+	state->collation = intVal(list_nth(custom_private, LookupJoinPrivateCollation));
+
+	state->inner_rel = table_open(foreigntableid, AccessShareLock);
+	inner_desc = RelationGetDescr(state->inner_rel);
+	state->key_type = TupleDescAttr(inner_desc, state->key_attno - 1)->atttypid;
+	get_typlenbyval(state->key_type, &state->key_typlen, &state->key_typbyval);
+
+	if (!get_op_hash_functions(opno, &hash_proc, &rhs_hash_proc))
+		elog(ERROR, "could not find hash function for hash operator %u", opno);
+	fmgr_info(hash_proc, &state->hash_finfo);
+	fmgr_info(get_opcode(opno), &state->eq_finfo);
+	getTypeOutputInfo(state->key_type, &typoutput, &typisvarlena);
+	fmgr_info(typoutput, &state->key_out_finfo);
+
+	outer_desc = ExecGetResultType(state->outer_ps);
+	state->nouter_cols = outer_desc->natts;
+	state->outer_slot = ExecInitExtraTupleSlot(estate, outer_desc, &TTSOpsMinimalTuple);
+	state->inner_slot = ExecInitExtraTupleSlot(estate, inner_desc, &TTSOpsHeapTuple);
+
+	state->ninner_cols = list_length(inner_attnos);
+	state->inner_attnos = (int *) palloc(sizeof(int) * (state->ninner_cols + 1));
+	foreach(lc, inner_attnos)
+	{
+		state->inner_attnos[i++] = lfirst_int(lc);
+	}
+	state->inner_values = (Datum *) palloc(sizeof(Datum) * inner_desc->natts);
+	state->inner_nulls = (bool *) palloc(sizeof(bool) * inner_desc->natts);
+
+	state->batch_cxt = AllocSetContextCreate(estate->es_query_cxt,
+						 "jdbc_fdw lookup join",
+						 ALLOCSET_DEFAULT_SIZES);
+	state->nouter = 0;
+	state->ninner = 0;
+	state->outer_pos = -1;
+	state->inner_pos = -1;
+	state->outer_done = false;
+	state->festate = NULL;
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	JVMInitialization(foreigntableid);
+	jdbcGetOptions(foreigntableid, &opts);
+	state->festate = jdbcCreateExecutionState(&opts, inner_desc,
+						  pstrdup(strVal(list_nth(custom_private, LookupJoinPrivateSql))),
+						  "*", "", 0, state->batch_size, false);
+}
+
+/*
+ * jdbcExecLookupJoin
+ *		(12+) Return the next joined row.
+ */
+static TupleTableSlot *
+jdbcExecLookupJoin(CustomScanState *node)
+{
+	jdbcLookupJoinState *state = (jdbcLookupJoinState *) node;
+	ExprContext	*econtext = node->ss.ps.ps_ExprContext;
+	ExprState	*qual = node->ss.ps.qual;
+	ProjectionInfo	*projinfo = node->ss.ps.ps_ProjInfo;
+	TupleTableSlot	*slot = node->ss.ss_ScanTupleSlot;
+
+	for (;;)
+	{
+		SIGINTInterruptCheckProcess(&state->festate);
+
+		ResetExprContext(econtext);
+
+		if (!jdbcLookupJoinNext(state))
+			return NULL;
+
+		econtext->ecxt_scantuple = slot;
+		if (qual == NULL || ExecQual(qual, econtext))
+		{
+			/* A semi join returns each outer row once */
+			if (state->jointype == JOIN_SEMI)
+				state->inner_pos = -1;
+
+			if (projinfo != NULL)
+				return ExecProject(projinfo);
+
+			return slot;
+		}
+
+		InstrCountFiltered1(node, 1);
+	}
+}
+
+/*
+ * jdbcLookupJoinNext
+ *		(12+) Store in the scan slot the next pair of an outer row and a
+ *		remote row with the same key hash, reading the next batch when
+ *		the current one is done.  Returns false at the end of the join.
+ */
+static bool
+jdbcLookupJoinNext(jdbcLookupJoinState *state)
+{
+	for (;;)
+	{
+		if (state->inner_pos >= 0)
+		{
+			int	inner = state->inner_pos;
+
+			state->inner_pos = state->inner_next[inner];
+			if (state->inner_hashes[inner] == state->outer_hashes[state->outer_pos])
+			{
+				jdbcLookupJoinStoreRow(state, inner);
+				return true;
+			}
+			continue;
+		}
+
+		state->outer_pos++;
+		if (state->outer_pos >= state->nouter)
+		{
+			if (state->outer_done)
+				return false;
+
+			jdbcLookupJoinFillBatch(state);
+			if (state->nouter == 0)
+				return false;
+
+			state->outer_pos = 0;
+		}
+
+		state->inner_pos = state->buckets[state->outer_hashes[state->outer_pos] & state->bucket_mask];
+	}
+}
+
+/*
+ * jdbcLookupJoinFillBatch
+ *		(12+) Read outer rows until they carry batch_size distinct keys,
+ *		fetch the remote rows with those keys and hash them on the key.
+ *		Outer rows with a NULL key are dropped as they match nothing.
+ */
+static void
+jdbcLookupJoinFillBatch(jdbcLookupJoinState *state)
+{
+	ExprContext	*econtext = state->css.ss.ps.ps_ExprContext;
+	TupleTableSlot	*scan_slot = state->css.ss.ss_ScanTupleSlot;
+	TupleDesc	inner_desc = RelationGetDescr(state->inner_rel);
+	int		max_outer = state->batch_size * LOOKUP_JOIN_OUTER_ROWS_PER_KEY;
+	int		allocated = Max(state->batch_size, 16);
+	Datum		*keys;
+	uint32		*key_hashes;
+	int		nkeys = 0;
+	const char	**types;
+	char		**values;
+	int		nbuckets;
+	MemoryContext	oldcontext;
+	int		i;
+
+	MemoryContextReset(state->batch_cxt);
+	state->nouter = 0;
+	state->ninner = 0;
+
+	state->outer_tuples = (MinimalTuple *) MemoryContextAlloc(state->batch_cxt, sizeof(MinimalTuple) * max_outer);
+	state->outer_hashes = (uint32 *) MemoryContextAlloc(state->batch_cxt, sizeof(uint32) * max_outer);
+	keys = (Datum *) MemoryContextAlloc(state->batch_cxt, sizeof(Datum) * state->batch_size);
+	key_hashes = (uint32 *) MemoryContextAlloc(state->batch_cxt, sizeof(uint32) * state->batch_size);
+
+	while (nkeys < state->batch_size && state->nouter < max_outer)
+	{
+		TupleTableSlot	*outer = ExecProcNode(state->outer_ps);
+		Datum		key;
+		bool		isnull;
+		uint32		hash = 0;
+
+		if (TupIsNull(outer))
+		{
+			state->outer_done = true;
+			break;
+		}
+
+		/* The key is computed over the scan tuple, with no remote row */
+		slot_getallattrs(outer);
+		ExecClearTuple(scan_slot);
+		memcpy(scan_slot->tts_values, outer->tts_values, sizeof(Datum) * state->nouter_cols);
+		memcpy(scan_slot->tts_isnull, outer->tts_isnull, sizeof(bool) * state->nouter_cols);
+		for (i = 0; i < state->ninner_cols; i++)
+		{
+			scan_slot->tts_isnull[state->nouter_cols + i] = true;
+		}
+		ExecStoreVirtualTuple(scan_slot);
+
+		ResetExprContext(econtext);
+		econtext->ecxt_scantuple = scan_slot;
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		key = ExecEvalExpr(state->outer_key, econtext, &isnull);
+		if (!isnull)
+			hash = DatumGetUInt32(FunctionCall1Coll(&state->hash_finfo, state->collation, key));
+		MemoryContextSwitchTo(oldcontext);
+
+		if (isnull)
+			continue;
+
+		for (i = 0; i < nkeys; i++)
+		{
+			if (key_hashes[i] == hash &&
+			    DatumGetBool(FunctionCall2Coll(&state->eq_finfo, state->collation, keys[i], key)))
+				break;
+		}
+
+		oldcontext = MemoryContextSwitchTo(state->batch_cxt);
+		if (i == nkeys)
+		{
+			keys[nkeys] = datumCopy(key, state->key_typbyval, state->key_typlen);
+			key_hashes[nkeys++] = hash;
+		}
+		state->outer_tuples[state->nouter] = ExecCopySlotMinimalTuple(outer);
+		state->outer_hashes[state->nouter++] = hash;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	if (nkeys == 0)
+		return;
+
+	/* The query always has batch_size placeholders; spare ones repeat a key */
+	oldcontext = MemoryContextSwitchTo(state->batch_cxt);
+	types = (const char **) palloc(sizeof(char *) * state->batch_size);
+	values = (char **) palloc(sizeof(char *) * state->batch_size);
+	for (i = 0; i < state->batch_size; i++)
+	{
+		types[i] = jdbcParamType(state->key_type);
+		values[i] = jdbcParamValueString(keys[(i < nkeys) ? i : 0], state->key_type,
+						 &state->key_out_finfo);
+	}
+	MemoryContextSwitchTo(oldcontext);
+
+	jdbcRunQuery(state->festate, types, values);
+
+	state->inner_tuples = (HeapTuple *) MemoryContextAlloc(state->batch_cxt, sizeof(HeapTuple) * allocated);
+	state->inner_hashes = (uint32 *) MemoryContextAlloc(state->batch_cxt, sizeof(uint32) * allocated);
+	state->inner_next = (int *) MemoryContextAlloc(state->batch_cxt, sizeof(int) * allocated);
+
+	for (;;)
+	{
+		Datum	key;
+		bool	isnull;
+
+		/* Rows are converted in per-tuple memory and copied if kept */
+		ResetExprContext(econtext);
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		jdbcFetchRow(state->festate, inner_desc, state->inner_slot);
+		MemoryContextSwitchTo(oldcontext);
+
+		if (TupIsNull(state->inner_slot))
+			break;
+
+		key = slot_getattr(state->inner_slot, state->key_attno, &isnull);
+		if (isnull)
+			continue;
+
+		if (state->ninner == allocated)
+		{
+			allocated *= 2;
+			state->inner_tuples = (HeapTuple *) repalloc(state->inner_tuples, sizeof(HeapTuple) * allocated);
+			state->inner_hashes = (uint32 *) repalloc(state->inner_hashes, sizeof(uint32) * allocated);
+			state->inner_next = (int *) repalloc(state->inner_next, sizeof(int) * allocated);
+		}
+
+		state->inner_hashes[state->ninner] = DatumGetUInt32(FunctionCall1Coll(&state->hash_finfo,
+										      state->collation, key));
+		oldcontext = MemoryContextSwitchTo(state->batch_cxt);
+		state->inner_tuples[state->ninner++] = ExecCopySlotHeapTuple(state->inner_slot);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	ExecClearTuple(state->inner_slot);
+
+	for (nbuckets = 1; nbuckets < state->ninner; nbuckets <<= 1)
+		;
+	state->buckets = (int *) MemoryContextAlloc(state->batch_cxt, sizeof(int) * nbuckets);
+	state->bucket_mask = nbuckets - 1;
+	for (i = 0; i < nbuckets; i++)
+	{
+		state->buckets[i] = -1;
+	}
+	for (i = 0; i < state->ninner; i++)
+	{
+		int	bucket = state->inner_hashes[i] & state->bucket_mask;
+
+		state->inner_next[i] = state->buckets[bucket];
+		state->buckets[bucket] = i;
+	}
+}
+
+/*
+ * jdbcLookupJoinStoreRow
+ *		(12+) Store the current outer row joined with a remote row of the
+ *		batch in the scan slot.
+ */
+static void
+jdbcLookupJoinStoreRow(jdbcLookupJoinState *state, int inner)
+{
+	TupleTableSlot	*scan_slot = state->css.ss.ss_ScanTupleSlot;
+	TupleTableSlot	*outer_slot = state->outer_slot;
+	int		i;
+
+	ExecClearTuple(scan_slot);
+
+	ExecStoreMinimalTuple(state->outer_tuples[state->outer_pos], outer_slot, false);
+	slot_getallattrs(outer_slot);
+	memcpy(scan_slot->tts_values, outer_slot->tts_values, sizeof(Datum) * state->nouter_cols);
+	memcpy(scan_slot->tts_isnull, outer_slot->tts_isnull, sizeof(bool) * state->nouter_cols);
+
+	heap_deform_tuple(state->inner_tuples[inner], RelationGetDescr(state->inner_rel),
+			  state->inner_values, state->inner_nulls);
+	for (i = 0; i < state->ninner_cols; i++)
+	{
+		scan_slot->tts_values[state->nouter_cols + i] = state->inner_values[state->inner_attnos[i] - 1];
+		scan_slot->tts_isnull[state->nouter_cols + i] = state->inner_nulls[state->inner_attnos[i] - 1];
+	}
+
+	ExecStoreVirtualTuple(scan_slot);
+}
+
+/*
+ * jdbcReScanLookupJoin
+ *		(12+) Restart the join from the first outer row.
+ */
+static void
+jdbcReScanLookupJoin(CustomScanState *node)
+{
+	jdbcLookupJoinState *state = (jdbcLookupJoinState *) node;
+
+	MemoryContextReset(state->batch_cxt);
+	state->nouter = 0;
+	state->ninner = 0;
+	state->outer_pos = -1;
+	state->inner_pos = -1;
+	state->outer_done = false;
+
+	if (state->outer_ps->chgParam == NULL)
+		ExecReScan(state->outer_ps);
+}
+
+/*
+ * jdbcEndLookupJoin
+ *		(12+) Shut down the outer plan and close the remote query.
+ */
+static void
+jdbcEndLookupJoin(CustomScanState *node)
+{
+	jdbcLookupJoinState *state = (jdbcLookupJoinState *) node;
+
+	ExecEndNode(state->outer_ps);
+
+	if (state->festate != NULL)
+		jdbcCloseExecutionState(&state->festate);
+
+	table_close(state->inner_rel, NoLock);
+}
+
+/*
+ * jdbcExplainLookupJoin
+ *		(12+) Produce extra output for EXPLAIN
+ */
+static void
+jdbcExplainLookupJoin(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	List	*custom_private = ((CustomScan *) node->ss.ps.plan)->custom_private;
+
+	ExplainPropertyInteger("Lookup Batch Size", NULL,
+			       intVal(list_nth(custom_private, LookupJoinPrivateBatchSize)), es);
+
+	if (es->verbose)
+	{
+		ExplainPropertyText("Remote SQL",
+				    strVal(list_nth(custom_private, LookupJoinPrivateSql)), es);
+	}
+}
+#endif
+
+#if PG_VERSION_NUM >= 120000
+/*
+ * Result cache
+ *
+ * When jdbc_fdw is loaded through shared_preload_libraries, the rows a
+ * scan of a foreign table with cache_ttl set reads to the end are kept
+ * in shared memory for cache_ttl seconds.  Entries are keyed by the
+ * server, the user mapping, the foreign table and the remote query with
+ * everything that shapes its result, and any backend serves the same
+ * scan from there without calling into the JVM.  The rows live in a DSA
+ * area created in place in the main shared memory segment and limited
+ * to its size; the least recently used entries make room for new ones.
+ */
+
+/*
+ * Entries are indexed for this average size at least.
+ */
+#define RESULT_CACHE_AVG_ENTRY_SIZE	(16 * 1024)
+
+typedef struct jdbcResultCacheKey
+{
+	Oid		serverid;
+	Oid		umid;
+	Oid		relid;
+	uint64		hash;		/* of the remote query and its parameters */
+} jdbcResultCacheKey;
+
+/*
+ * A cached result.  Its data holds the text the key hash was computed
+ * from, so that a hash collision reads as a miss, then the rows as
+ * MinimalTuples each preceded by its length, all MAXALIGNed.
+ */
+typedef struct jdbcResultCacheEntry
+{
+	jdbcResultCacheKey key;		/* hash key, must be first */
+	dsa_pointer	data;
+	Size		keylen;		/* length of the key text */
+	Size		size;		/* of data */
+	TimestampTz	expires;
+	dlist_node	lru_node;	/* in lru, most recently used first */
+} jdbcResultCacheEntry;
+
+/*
+ * Shared state of the result cache, followed by its DSA area.
+ */
+typedef struct jdbcResultCacheShared
+{
+	LWLock		*lock;		/* protects the index, lru and the area */
+	int		tranche_id;	/* of the area's own locks */
+	int		num_entries;
+	dlist_head	lru;
+} jdbcResultCacheShared;
+
+#define RESULT_CACHE_AREA_OFFSET	MAXALIGN(sizeof(jdbcResultCacheShared))
+
+/*
+ * Result cache use of a scan: the key of its current execution and the
+ * rows it reads from the remote server or replays from the cache.
+ */
+typedef struct jdbcResultCacheScan
+{
+	jdbcResultCacheKey key;
+	int		ttl;		/* seconds a stored result stays valid */
+	MemoryContext	cxt;		/* holds keytext and rows */
+	char		*layout;	/* type and typmod of each column */
+	StringInfoData	keytext;
+	StringInfoData	rows;
+	bool		collecting;	/* rows read from the server go to rows */
+	bool		replaying;	/* rows come from rows */
+	Size		replay_pos;
+} jdbcResultCacheScan;
+
+static int ResultCacheSizeKB = 65536;
+static int ResultCacheEntryLimitKB = 8192;
+
+static jdbcResultCacheShared *ResultCache = NULL;
+static HTAB *ResultCacheIndex = NULL;
+static dsa_area *ResultCacheArea = NULL;
+
+/* Foreign tables and servers the local transaction writes to */
+static List *ResultCacheWrittenRels = NIL;
+static List *ResultCacheWrittenServers = NIL;
+static bool ResultCacheXactCallbackRegistered = false;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static Size jdbcResultCacheAreaSize(void);
+static long jdbcResultCacheMaxEntries(void);
+static Size jdbcResultCacheShmemSize(void);
+static void jdbcResultCacheShmemRequest(void);
+static void jdbcResultCacheShmemStartup(void);
+static void jdbcResultCacheAttach(void);
+static void jdbcResultCacheStore(jdbcResultCacheScan *cache);
+static void jdbcResultCacheRemove(jdbcResultCacheEntry *entry);
+static int64 jdbcResultCacheInvalidate(Oid relid);
+static void jdbcResultCacheXactCallback(XactEvent event, void *arg);
+static void jdbcAppendCacheKeyString(StringInfo buf, const char *str);
+
+/*
+ * jdbcDefineResultCache
+ *		(12+) Define the settings of the result cache, and reserve its
+ *		shared memory when loaded through shared_preload_libraries.
+ */
+static void
+jdbcDefineResultCache(void)
 {
-	Cost 		startup_cost = 0;
-	Cost 		total_cost = 0;
+	DefineCustomIntVariable("jdbc_fdw.result_cache_size",
+				"Sets the size of the shared result cache of jdbc_fdw.",
+				"Used only when jdbc_fdw is in shared_preload_libraries. 0 disables the cache.",
+				&ResultCacheSizeKB,
+				65536, 0, MAX_KILOBYTES,
+				PGC_POSTMASTER, GUC_UNIT_KB,
+				NULL, NULL, NULL);
+
+	DefineCustomIntVariable("jdbc_fdw.result_cache_entry_limit",
+				"Sets the size of the largest result kept in the result cache.",
+				NULL,
+				&ResultCacheEntryLimitKB,
+				8192, 0, 512 * 1024,
+				PGC_SUSET, GUC_UNIT_KB,
+				NULL, NULL, NULL);
+
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("jdbc_fdw");
+#else
+	EmitWarningsOnPlaceholders("jdbc_fdw");
+#endif
 
-	SIGINTInterruptCheckProcess(NULL);
+	if (!process_shared_preload_libraries_in_progress || ResultCacheSizeKB == 0)
+	{
+		return;
+	}
 
-	/* Create a ForeignPath node and add it as only possible path */
-	add_path(baserel, (Path*)create_foreignscan_path(root, baserel, 
-#if PG_VERSION_NUM >= 90600
-NULL
-,
-#endif							 
-							 baserel->rows, startup_cost, total_cost, NIL, NULL, NULL
-#if PG_VERSION_NUM >= 90500
-,
-NIL
+#if PG_VERSION_NUM >= 150000
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = jdbcResultCacheShmemRequest;
+#else
+	jdbcResultCacheShmemRequest();
 #endif
-)); 
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = jdbcResultCacheShmemStartup;
 }
 
 /*
- * jdbcGetForeignPlan
- *		(9.2+) Get a foreign scan plan node
+ * jdbcResultCacheAreaSize
+ *		(12+) Size of the DSA area holding the cached rows.
  */
-static ForeignScan *
-jdbcGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid, ForeignPath *best_path, List *tlist, List *scan_clauses
+static Size
+jdbcResultCacheAreaSize(void)
+{
+	return Max((Size) ResultCacheSizeKB * 1024, dsa_minimum_size());
+}
 
-#if PG_VERSION_NUM >= 90500
-,
 /*
-* Require PostgreSQL >= 9.5
-*/
+ * jdbcResultCacheMaxEntries
+ *		(12+) Number of entries the index of the result cache holds.
+ */
+static long
+jdbcResultCacheMaxEntries(void)
+{
+	return Max(jdbcResultCacheAreaSize() / RESULT_CACHE_AVG_ENTRY_SIZE, 64);
+}
 
-Plan *outer_plan
+/*
+ * jdbcResultCacheShmemSize
+ *		(12+) Shared memory needed by the result cache.
+ */
+static Size
+jdbcResultCacheShmemSize(void)
+{
+	return add_size(add_size(RESULT_CACHE_AREA_OFFSET, jdbcResultCacheAreaSize()),
+			hash_estimate_size(jdbcResultCacheMaxEntries(), sizeof(jdbcResultCacheEntry)));
+}
+
+/*
+ * jdbcResultCacheShmemRequest
+ *		(12+) Reserve the shared memory and the lock of the result cache.
+ */
+static void
+jdbcResultCacheShmemRequest(void)
+{
+#if PG_VERSION_NUM >= 150000
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
 #endif
-)
+
+	RequestAddinShmemSpace(jdbcResultCacheShmemSize());
+	RequestNamedLWLockTranche("jdbc_fdw", 1);
+}
+
+/*
+ * jdbcResultCacheShmemStartup
+ *		(12+) Create the result cache in shared memory, or attach to it.
+ */
+static void
+jdbcResultCacheShmemStartup(void)
 {
-	Index 		scan_relid = baserel->relid;
+	HASHCTL		ctl;
+	dsa_area	*area;
+	bool		found;
 
-	SIGINTInterruptCheckProcess(NULL);
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
 
-	JVMInitialization(foreigntableid);
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
 
-	scan_clauses = extract_actual_clauses(scan_clauses, false);
+	ResultCache = ShmemInitStruct("jdbc_fdw result cache",
+				      add_size(RESULT_CACHE_AREA_OFFSET, jdbcResultCacheAreaSize()),
+				      &found);
+	if (!found)
+	{
+		ResultCache->lock = &(GetNamedLWLockTranche("jdbc_fdw"))->lock;
+		ResultCache->tranche_id = LWLockNewTrancheId();
+		ResultCache->num_entries = 0;
+		dlist_init(&ResultCache->lru);
+
+		/* Pinned, so that it outlives the backends attached to it */
+		area = dsa_create_in_place((char *) ResultCache + RESULT_CACHE_AREA_OFFSET,
+					   jdbcResultCacheAreaSize(), ResultCache->tranche_id, NULL);
+		dsa_pin(area);
+		dsa_set_size_limit(area, jdbcResultCacheAreaSize());
+		dsa_detach(area);
+	}
 
-	/* Create the ForeignScan node */
-	return (make_foreignscan(tlist, scan_clauses, scan_relid, NIL, NIL
-#if PG_VERSION_NUM >= 90500
-,
-NIL,
-NIL,
-outer_plan
-#endif
-)); 
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(jdbcResultCacheKey);
+	ctl.entrysize = sizeof(jdbcResultCacheEntry);
+	ResultCacheIndex = ShmemInitHash("jdbc_fdw result cache index",
+					 jdbcResultCacheMaxEntries(), jdbcResultCacheMaxEntries(),
+					 &ctl, HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
 }
 
 /*
- * jdbcGetForeignRelSize
- *		(9.2+) Get a foreign scan plan node
+ * jdbcResultCacheAttach
+ *		(12+) Map the DSA area of the result cache in this backend for
+ *		the rest of its life.  The reference the backend holds on the
+ *		area is released when it exits.
  */
 static void
-jdbcGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+jdbcResultCacheAttach(void)
 {
-	SIGINTInterruptCheckProcess(NULL);
+	MemoryContext	oldcontext;
+	void		*place = (char *) ResultCache + RESULT_CACHE_AREA_OFFSET;
+
+	if (ResultCacheArea != NULL)
+	{
+		return;
+	}
+
+	LWLockRegisterTranche(ResultCache->tranche_id, "jdbc_fdw_result_cache");
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	ResultCacheArea = dsa_attach_in_place(place, NULL);
+	MemoryContextSwitchTo(oldcontext);
+
+	dsa_pin_mapping(ResultCacheArea);
+	on_shmem_exit(dsa_on_shmem_exit_release_in_place, PointerGetDatum(place));
+}
+
+/*
+ * jdbcResultCacheBegin
+ *		(12+) Let the result cache serve the scan of festate, if there is
+ *		a cache.  The scan then connects only on a cache miss.  The rows
+ *		are stored as tuples of tupdesc, whose column types become part
+ *		of the key, so that a result stored before the table was altered
+ *		is not replayed.
+ */
+static bool
+jdbcResultCacheBegin(jdbcFdwExecutionState *festate, Oid relid, TupleDesc tupdesc, int ttl)
+{
+	ForeignTable		*table;
+	UserMapping		*mapping;
+	jdbcResultCacheScan	*cache;
+	StringInfoData		layout;
+	int			i;
+
+	if (ResultCache == NULL)
+	{
+		return false;
+	}
+
+	jdbcResultCacheAttach();
+
+	table = GetForeignTable(relid);
+	mapping = GetUserMapping(GetUserId(), table->serverid);
+
+	/* Zeroed, as the padding of the key is hashed too */
+	cache = (jdbcResultCacheScan *) palloc0(sizeof(jdbcResultCacheScan));
+	cache->key.serverid = table->serverid;
+	cache->key.umid = mapping->umid;
+	cache->key.relid = relid;
+	cache->ttl = ttl;
+
+	initStringInfo(&layout);
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		appendStringInfo(&layout, "%u %d ", attr->atttypid, attr->atttypmod);
+	}
+	cache->layout = layout.data;
+
+	cache->cxt = AllocSetContextCreate(CurrentMemoryContext,
+					   "jdbc_fdw result cache",
+					   ALLOCSET_DEFAULT_SIZES);
+
+	festate->cache = cache;
+
+	return true;
+}
+
+/*
+ * jdbcResultCacheLookup
+ *		(12+) Look up the result of the query of festate with the given
+ *		parameters.  On a hit the rows are copied out of the cache, to be
+ *		replayed by jdbcResultCacheFetchRow; on a miss the rows read from
+ *		the server are collected to be stored once all are read.
+ */
+static bool
+jdbcResultCacheLookup(jdbcFdwExecutionState *festate, const char **types, char **values)
+{
+	jdbcResultCacheScan	*cache = festate->cache;
+	jdbcResultCacheEntry	*entry;
+	MemoryContext		oldcontext;
+	char			*data;
+	Size			rows_size;
+	int			i;
+
+	MemoryContextReset(cache->cxt);
+
+	/*
+	 * Once the local transaction wrote to the server, its remote
+	 * transaction may see rows that others do not.
+	 */
+	if (list_member_oid(ResultCacheWrittenServers, cache->key.serverid))
+	{
+		cache->replaying = false;
+		cache->collecting = false;
+		return false;
+	}
+
+	oldcontext = MemoryContextSwitchTo(cache->cxt);
+
+	/* Everything that shapes the rows the scan returns */
+	initStringInfo(&cache->keytext);
+	jdbcAppendCacheKeyString(&cache->keytext, cache->layout);
+	jdbcAppendCacheKeyString(&cache->keytext, festate->query);
+	jdbcAppendCacheKeyString(&cache->keytext, festate->retrievedattrsstr);
+	jdbcAppendCacheKeyString(&cache->keytext, festate->javafilterstr);
+	appendStringInfo(&cache->keytext, "%d", festate->maxrows);
+	appendStringInfoChar(&cache->keytext, '\0');
+	for (i = 0; i < festate->numParams; i++)
+	{
+		jdbcAppendCacheKeyString(&cache->keytext, types[i]);
+		if (values[i] == NULL)
+		{
+			appendStringInfoChar(&cache->keytext, 'n');
+		}
+		else
+		{
+			appendStringInfoChar(&cache->keytext, 'v');
+			jdbcAppendCacheKeyString(&cache->keytext, values[i]);
+		}
+	}
+
+	initStringInfo(&cache->rows);
+	MemoryContextSwitchTo(oldcontext);
+
+	cache->key.hash = hash_bytes_extended((const unsigned char *) cache->keytext.data,
+					      cache->keytext.len, 0);
+	cache->replaying = false;
+	cache->replay_pos = 0;
+
+	LWLockAcquire(ResultCache->lock, LW_EXCLUSIVE);
+
+	entry = (jdbcResultCacheEntry *) hash_search(ResultCacheIndex, &cache->key, HASH_FIND, NULL);
+	if (entry != NULL && entry->expires <= GetCurrentTimestamp())
+	{
+		jdbcResultCacheRemove(entry);
+		entry = NULL;
+	}
+
+	if (entry != NULL)
+	{
+		data = (char *) dsa_get_address(ResultCacheArea, entry->data);
+
+		if (entry->keylen == cache->keytext.len &&
+		    memcmp(data, cache->keytext.data, entry->keylen) == 0)
+		{
+			rows_size = entry->size - MAXALIGN(entry->keylen);
+			enlargeStringInfo(&cache->rows, rows_size);
+			memcpy(cache->rows.data, data + MAXALIGN(entry->keylen), rows_size);
+			cache->rows.len = rows_size;
+
+			dlist_move_head(&ResultCache->lru, &entry->lru_node);
+			cache->replaying = true;
+		}
+	}
+
+	LWLockRelease(ResultCache->lock);
+
+	cache->collecting = !cache->replaying;
+
+	return cache->replaying;
+}
+
+/*
+ * jdbcAppendCacheKeyString
+ *		(12+) Append a string and its terminating zero byte to the key
+ *		text of a result.
+ */
+static void
+jdbcAppendCacheKeyString(StringInfo buf, const char *str)
+{
+	appendStringInfoString(buf, str);
+	appendStringInfoChar(buf, '\0');
+}
+
+/*
+ * jdbcResultCacheFetchRow
+ *		(12+) Read the next row of a scan that uses the result cache:
+ *		from the copied result on a hit, and otherwise from the server,
+ *		collecting the row.  The collected rows are stored once the last
+ *		one is read, unless they outgrew jdbc_fdw.result_cache_entry_limit.
+ */
+static void
+jdbcResultCacheFetchRow(jdbcFdwExecutionState *festate, TupleDesc tupdesc, TupleTableSlot *slot)
+{
+	jdbcResultCacheScan	*cache = festate->cache;
+	MinimalTuple		tuple;
+	Size			len;
+	bool			shouldFree;
+
+	if (cache->replaying)
+	{
+		if (cache->replay_pos >= cache->rows.len)
+		{
+			ExecClearTuple(slot);
+			return;
+		}
+
+		memcpy(&len, cache->rows.data + cache->replay_pos, sizeof(Size));
+		ExecForceStoreMinimalTuple((MinimalTuple) (cache->rows.data + cache->replay_pos +
+							  MAXALIGN(sizeof(Size))),
+					   slot, false);
+		cache->replay_pos += MAXALIGN(sizeof(Size)) + MAXALIGN(len);
+		return;
+	}
+
+	jdbcFetchRow(festate, tupdesc, slot);
+
+	if (!cache->collecting)
+	{
+		return;
+	}
+
+	if (TupIsNull(slot))
+	{
+		cache->collecting = false;
+		jdbcResultCacheStore(cache);
+		return;
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	len = tuple->t_len;
+
+	if (MAXALIGN(cache->keytext.len) + cache->rows.len + MAXALIGN(sizeof(Size)) + MAXALIGN(len) >
+	    (Size) ResultCacheEntryLimitKB * 1024)
+	{
+		cache->collecting = false;
+		MemoryContextReset(cache->cxt);
+	}
+	else
+	{
+		appendBinaryStringInfo(&cache->rows, (char *) &len, sizeof(Size));
+		appendStringInfoSpaces(&cache->rows, MAXALIGN(sizeof(Size)) - sizeof(Size));
+		appendBinaryStringInfo(&cache->rows, (char *) tuple, len);
+		appendStringInfoSpaces(&cache->rows, MAXALIGN(len) - len);
+	}
+
+	if (shouldFree)
+	{
+		pfree(tuple);
+	}
+}
+
+/*
+ * jdbcResultCacheStore
+ *		(12+) Store the collected result of a scan, evicting the least
+ *		recently used entries as needed.  A result that does not fit is
+ *		not stored.
+ */
+static void
+jdbcResultCacheStore(jdbcResultCacheScan *cache)
+{
+	jdbcResultCacheEntry	*entry;
+	dsa_pointer		data;
+	Size			size = MAXALIGN(cache->keytext.len) + cache->rows.len;
+	char			*dest;
+
+	/* The scan ran into a write of the local transaction */
+	if (list_member_oid(ResultCacheWrittenServers, cache->key.serverid))
+	{
+		return;
+	}
+
+	LWLockAcquire(ResultCache->lock, LW_EXCLUSIVE);
+
+	/* A concurrent scan of the same query may have stored it already */
+	entry = (jdbcResultCacheEntry *) hash_search(ResultCacheIndex, &cache->key, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		jdbcResultCacheRemove(entry);
+	}
+
+	while (ResultCache->num_entries >= jdbcResultCacheMaxEntries())
+	{
+		jdbcResultCacheRemove(dlist_tail_element(jdbcResultCacheEntry, lru_node, &ResultCache->lru));
+	}
+
+	while ((data = dsa_allocate_extended(ResultCacheArea, size, DSA_ALLOC_NO_OOM)) == InvalidDsaPointer)
+	{
+		if (dlist_is_empty(&ResultCache->lru))
+		{
+			LWLockRelease(ResultCache->lock);
+			return;
+		}
+		jdbcResultCacheRemove(dlist_tail_element(jdbcResultCacheEntry, lru_node, &ResultCache->lru));
+	}
+
+	entry = (jdbcResultCacheEntry *) hash_search(ResultCacheIndex, &cache->key, HASH_ENTER_NULL, NULL);
+	if (entry == NULL)
+	{
+		dsa_free(ResultCacheArea, data);
+		LWLockRelease(ResultCache->lock);
+		return;
+	}
+
+	dest = (char *) dsa_get_address(ResultCacheArea, data);
+	memcpy(dest, cache->keytext.data, cache->keytext.len);
+	memcpy(dest + MAXALIGN(cache->keytext.len), cache->rows.data, cache->rows.len);
+
+	entry->data = data;
+	entry->keylen = cache->keytext.len;
+	entry->size = size;
+	entry->expires = TimestampTzPlusMilliseconds(GetCurrentTimestamp(), (int64) cache->ttl * 1000);
+	dlist_push_head(&ResultCache->lru, &entry->lru_node);
+	ResultCache->num_entries++;
+
+	LWLockRelease(ResultCache->lock);
+}
+
+/*
+ * jdbcResultCacheRemove
+ *		(12+) Remove an entry from the result cache.  The caller holds
+ *		the lock exclusively.
+ */
+static void
+jdbcResultCacheRemove(jdbcResultCacheEntry *entry)
+{
+	dsa_free(ResultCacheArea, entry->data);
+	dlist_delete(&entry->lru_node);
+	hash_search(ResultCacheIndex, &entry->key, HASH_REMOVE, NULL);
+	ResultCache->num_entries--;
+}
+
+/*
+ * jdbcResultCacheInvalidate
+ *		(12+) Remove the cached results of a foreign table, or all of them
+ *		if relid is invalid, and return how many were removed.
+ */
+static int64
+jdbcResultCacheInvalidate(Oid relid)
+{
+	HASH_SEQ_STATUS		scan;
+	jdbcResultCacheEntry	*entry;
+	int64			removed = 0;
+
+	LWLockAcquire(ResultCache->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&scan, ResultCacheIndex);
+	while ((entry = (jdbcResultCacheEntry *) hash_seq_search(&scan)) != NULL)
+	{
+		if (!OidIsValid(relid) || entry->key.relid == relid)
+		{
+			jdbcResultCacheRemove(entry);
+			removed++;
+		}
+	}
+
+	LWLockRelease(ResultCache->lock);
+
+	return removed;
+}
+
+/*
+ * jdbcResultCacheNoteWrite
+ *		(12+) Remove the cached results of a foreign table the local
+ *		transaction is about to write to, and again once it commits,
+ *		since other backends may store the old rows meanwhile.  Until
+ *		then, its scans of the same server neither use nor fill the cache.
+ */
+static void
+jdbcResultCacheNoteWrite(Oid relid)
+{
+	Oid		serverid;
+	MemoryContext	oldcontext;
+
+	if (ResultCache == NULL)
+	{
+		return;
+	}
+
+	jdbcResultCacheAttach();
+	jdbcResultCacheInvalidate(relid);
+
+	if (!ResultCacheXactCallbackRegistered)
+	{
+		RegisterXactCallback(jdbcResultCacheXactCallback, NULL);
+		ResultCacheXactCallbackRegistered = true;
+	}
+
+	serverid = GetForeignTable(relid)->serverid;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	ResultCacheWrittenRels = list_append_unique_oid(ResultCacheWrittenRels, relid);
+	ResultCacheWrittenServers = list_append_unique_oid(ResultCacheWrittenServers, serverid);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * jdbcResultCacheXactCallback
+ *		(12+) Remove the cached results of the foreign tables the local
+ *		transaction wrote to once its writes are visible to others.
+ */
+static void
+jdbcResultCacheXactCallback(XactEvent event, void *arg)
+{
+	ListCell	*lc;
+
+	if (ResultCacheWrittenRels == NIL)
+	{
+		return;
+	}
+
+	switch (event)
+	{
+		case XACT_EVENT_PARALLEL_COMMIT:
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_PREPARE:
+			foreach(lc, ResultCacheWrittenRels)
+			{
+				jdbcResultCacheInvalidate(lfirst_oid(lc));
+			}
+			/* FALLTHROUGH */
+		case XACT_EVENT_PARALLEL_ABORT:
+		case XACT_EVENT_ABORT:
+			list_free(ResultCacheWrittenRels);
+			list_free(ResultCacheWrittenServers);
+			ResultCacheWrittenRels = NIL;
+			ResultCacheWrittenServers = NIL;
+			break;
+		default:
+			break;
+	}
 }
 #endif
+
+/*
+ * jdbc_fdw_invalidate_cache
+ *		Remove the cached results of a foreign table, or all of them if
+ *		it is NULL, and return how many were removed.
+ */
+Datum
+jdbc_fdw_invalidate_cache(PG_FUNCTION_ARGS)
+{
+	int64			removed = 0;
+#if PG_VERSION_NUM >= 120000
+	Oid			relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+
+	if (ResultCache == NULL)
+	{
+		PG_RETURN_INT64(0);
+	}
+
+	jdbcResultCacheAttach();
+	removed = jdbcResultCacheInvalidate(relid);
+#endif
+
+	PG_RETURN_INT64(removed);
+}